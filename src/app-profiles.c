@@ -36,6 +36,10 @@
 #include <dirent.h>
 #include <ctype.h>
 #include <time.h>
+#include <limits.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
 #include "common-utils.h"
 #include "app-profiles.h"
 #include "msg.h"
@@ -58,52 +62,107 @@
 # define NV_JSON_OBJECT_FOREACH(object, key, value) json_object_foreach(object, key, value)
 #endif
 
+static void app_profile_config_invalidate_matcher(AppProfileConfig *config);
+static void app_profile_config_invalidate_rule_counts(AppProfileConfig *config);
+
+/*
+ * Growable text buffer, used to build the converted text of a file in a
+ * single pass.
+ */
+typedef struct {
+    char *s;
+    size_t len;
+    size_t alloc;
+} TextBuffer;
+
+static void text_buffer_init(TextBuffer *buf, size_t alloc)
+{
+    buf->alloc = alloc ? alloc : 1;
+    buf->s = nvalloc(buf->alloc);
+    buf->len = 0;
+}
+
+static void text_buffer_append(TextBuffer *buf, const char *s, size_t n)
+{
+    if (buf->len + n + 1 > buf->alloc) {
+        while (buf->len + n + 1 > buf->alloc) {
+            buf->alloc *= 2;
+        }
+        buf->s = nvrealloc(buf->s, buf->alloc);
+    }
+    memcpy(buf->s + buf->len, s, n);
+    buf->len += n;
+    buf->s[buf->len] = '\0';
+}
+
+/*
+ * slurp() - read the whole file, and return its non-empty lines, each
+ * preceded by a newline.  Lines are terminated by either '\n' or '\0'.
+ */
 static char *slurp(FILE *fp)
 {
-    int eof = FALSE;
-    char *text = strdup("");
-    char *new_text;
+    TextBuffer text;
+    char *data;
+    size_t len = 0, alloc = 4096, n;
+    size_t line;
 
-    while (text && !eof) {
-        char *line = fget_next_line(fp, &eof);
+    data = nvalloc(alloc);
 
-        if (line && *line != '\0' && *line != '\n') {
-            new_text = nvstrcat(text, "\n", line, NULL);
-            free(text);
-            text = new_text;
+    while ((n = fread(data + len, 1, alloc - len, fp)) > 0) {
+        len += n;
+        if (len == alloc) {
+            alloc *= 2;
+            data = nvrealloc(data, alloc);
         }
-        free(line);
     }
 
-    return text;
-}
+    if (ferror(fp)) {
+        nvfree(data);
+        return NULL;
+    }
 
-static void splice_string(char **s, size_t b, size_t e, const char *replace)
-{
-    char *tail = strdup(*s + e);
-    *s = realloc(*s, b + strlen(replace) + strlen(tail) + 1);
-    if (!*s) {
-        return;
+    text_buffer_init(&text, len + 2);
+
+    for (line = 0; line < len; ) {
+        size_t eol = line;
+
+        while ((eol < len) && (data[eol] != '\n') && (data[eol] != '\0')) {
+            eol++;
+        }
+        if (eol > line) {
+            text_buffer_append(&text, "\n", 1);
+            text_buffer_append(&text, data + line, eol - line);
+        }
+        line = eol + 1;
     }
-    sprintf(*s + b, "%s%s", replace, tail);
-    free(tail);
+
+    nvfree(data);
+
+    return text.s;
 }
 
 #define HEX_DIGITS "0123456789abcdefABCDEF"
 
+/*
+ * nv_app_profile_file_syntax_to_json() - convert the given text from the
+ * app profile configuration file syntax to JSON, by stripping comments
+ * and converting hexadecimal and octal integers to decimal.  The result
+ * is built in a single pass over the text.
+ */
 char *nv_app_profile_file_syntax_to_json(const char *orig_s)
 {
-    char *s = strdup(orig_s);
-
+    TextBuffer out;
     int quoted = FALSE;
-    char *tok;
-    size_t start, end, size;
+    const char *tok, *copied;
+    size_t size;
     unsigned long long val;
-    char *old_substr = NULL;
     char *endptr;
-    char *new_substr = NULL;
+    char new_substr[32];
+
+    text_buffer_init(&out, strlen(orig_s) + 1);
 
-    tok = s;
+    // Text up to 'copied' has been written to the output
+    tok = copied = orig_s;
     while ((tok = strpbrk(tok, "\\\"#" HEX_DIGITS))) {
         switch (*tok) {
         case '\"':
@@ -121,14 +180,9 @@ char *nv_app_profile_file_syntax_to_json(const char *orig_s)
         case '#':
             // Comment
             if (!quoted) {
-                char *end_tok = nvstrchrnul(tok, '\n');
-                start = tok - s;
-                end = end_tok - s;
-                splice_string(&s, start, end, "");
-                if (!s) {
-                    goto fail;
-                }
-                tok = s + start;
+                text_buffer_append(&out, copied, tok - copied);
+                tok += strcspn(tok, "\n");
+                copied = tok;
             } else {
                 tok++;
             }
@@ -142,33 +196,22 @@ char *nv_app_profile_file_syntax_to_json(const char *orig_s)
             if ((tok[0] == '0') &&
                 (tok[1] == 'x' || tok[1] == 'X' || isdigit(tok[1])) &&
                 !quoted) {
-                old_substr = nvstrndup(tok, size);
-                if (!old_substr) {
-                    goto fail;
-                }
+                /*
+                 * The character following the token is not a valid digit,
+                 * so strtoull() cannot parse past the token
+                 */
                 errno = 0;
-                val = strtoull(old_substr, &endptr, 0);
-                if (errno || (endptr - old_substr != strlen(old_substr))) {
-                    // Invalid conversion, skip this string
-                    tok += size;
-                    free(old_substr); old_substr = NULL;
-                } else {
-                    new_substr = nvasprintf("%llu", val);
-                    if (!new_substr) {
-                        goto fail;
-                    } else {
-                        start = tok - s;
-                        end = tok - s + size;
-                        splice_string(&s, start, end, new_substr);
-                        free(new_substr); new_substr = NULL;
-                        free(old_substr); old_substr = NULL;
-                        tok = s + start;
-                    }
+                val = strtoull(tok, &endptr, 0);
+                if (!errno && (endptr - tok == size)) {
+                    text_buffer_append(&out, copied, tok - copied);
+                    snprintf(new_substr, sizeof(new_substr), "%llu", val);
+                    text_buffer_append(&out, new_substr, strlen(new_substr));
+                    copied = tok + size;
                 }
-            } else {
-                // Not hex or octal; let the JSON parser deal with it
-                tok += size;
+                // Otherwise, invalid conversion; skip this string
             }
+            // Not hex or octal numbers are left to the JSON parser
+            tok += size;
             break;
         default:
             assert(!"Unhandled character");
@@ -176,15 +219,9 @@ char *nv_app_profile_file_syntax_to_json(const char *orig_s)
         }
     }
 
-    assert(!new_substr);
-    assert(!old_substr);
-    return s;
+    text_buffer_append(&out, copied, strlen(copied));
 
-fail:
-    free(old_substr);
-    free(new_substr);
-    free(s);
-    return NULL;
+    return out.s;
 }
 
 static int open_and_stat(const char *filename, const char *perms, FILE **fp, struct stat *stat_buf)
@@ -270,20 +307,25 @@ static json_t *app_profile_config_insert_file_object(AppProfileConfig *config, j
 
     // Mark the order of the file
     order = json_object_get(new_file, "order");
+    if (!order) {
+        order = json_object();
+        json_object_set_new(new_file, "order", order);
+    }
     json_object_set_new(order, "major", json_integer(new_file_major));
     json_object_set_new(order, "minor", json_integer(new_file_minor));
 
     // Add the new file
     json_array_insert(config->parsed_files, i, new_file);
+    app_profile_config_invalidate_rule_counts(config);
 
     // Bump up minor for files after this one with the same major
     num_files = json_array_size(config->parsed_files);
 
-    for ( ; i < num_files; i++) {
+    for (i++; i < num_files; i++) {
         file = json_array_get(config->parsed_files, i);
         file_order = json_object_get(file, "order");
-        file_order_major = json_integer_value(json_object_get(order, "major"));
-        file_order_minor = json_integer_value(json_object_get(order, "minor"));
+        file_order_major = json_integer_value(json_object_get(file_order, "major"));
+        file_order_minor = json_integer_value(json_object_get(file_order, "minor"));
         if (file_order_major > new_file_major) {
             break;
         }
@@ -898,6 +940,11 @@ static json_t *app_profile_config_load_global_options(const char *global_config_
     option_text = slurp(fp);
     fclose(fp);
 
+    if (!option_text) {
+        nv_error_msg("Could not read from file %s", global_config_file);
+        return options;
+    }
+
     options_from_file = json_loads(option_text, 0, &error);
     free(option_text);
 
@@ -931,6 +978,11 @@ AppProfileConfig *nv_app_profile_config_load(const char *global_config_file,
 
     // Initialize the config
     config->next_free_rule_id = 0;
+    config->matcher = NULL;
+    config->rule_indices = json_object();
+    config->file_positions = NULL;
+    config->rule_counts = NULL;
+    config->num_rule_counts = 0;
 
     config->parsed_files = json_array();
     config->profile_locations = json_object();
@@ -1189,6 +1241,8 @@ int nv_app_profile_config_save_updates(AppProfileConfig *config,
     int ret = 0;
     int all_ret = 0;
 
+    app_profile_config_invalidate_matcher(config);
+
     if (error_str) {
         *error_str = NULL;
     }
@@ -1227,6 +1281,11 @@ AppProfileConfig *nv_app_profile_config_dup(AppProfileConfig *config)
     new_config->profile_locations = json_deep_copy(config->profile_locations);
     new_config->rule_locations = json_deep_copy(config->rule_locations);
     new_config->next_free_rule_id = config->next_free_rule_id;
+    new_config->matcher = NULL;
+    new_config->rule_indices = json_deep_copy(config->rule_indices);
+    new_config->file_positions = NULL;
+    new_config->rule_counts = NULL;
+    new_config->num_rule_counts = 0;
 
     new_config->global_config_file =
         config->global_config_file ? strdup(config->global_config_file) : NULL;
@@ -1265,6 +1324,11 @@ int nv_app_profile_config_get_enabled(AppProfileConfig *config)
 void nv_app_profile_config_free(AppProfileConfig *config)
 {
     size_t i;
+
+    app_profile_config_invalidate_matcher(config);
+    app_profile_config_invalidate_rule_counts(config);
+
+    json_decref(config->rule_indices);
     json_decref(config->global_options);
     json_decref(config->parsed_files);
     json_decref(config->profile_locations);
@@ -1310,6 +1374,7 @@ static void app_profile_config_delete_file(AppProfileConfig *config, const char
         json_filename = json_object_get(json_file, "filename");
         if (!strcmp(json_string_value(json_filename), filename)) {
             json_array_remove(config->parsed_files, i);
+            app_profile_config_invalidate_rule_counts(config);
             return;
         }
     }
@@ -1533,6 +1598,8 @@ int nv_app_profile_config_update_profile(AppProfileConfig *config,
     json_t *file_profiles;
     const char *old_filename;
 
+    app_profile_config_invalidate_matcher(config);
+
     old_filename = json_string_value(json_object_get(config->profile_locations, profile_name));
 
     if (old_filename) {
@@ -1572,6 +1639,8 @@ void nv_app_profile_config_delete_profile(AppProfileConfig *config,
     json_t *file = NULL;
     const char *filename = json_string_value(json_object_get(config->profile_locations, profile_name));
 
+    app_profile_config_invalidate_matcher(config);
+
     if (filename) {
         file = app_profile_config_lookup_file(config, filename);
         if (file) {
@@ -1586,6 +1655,113 @@ void nv_app_profile_config_delete_profile(AppProfileConfig *config,
     }
 }
 
+/*
+ * Returns the position of the rule with the given id in the rules array of
+ * its file, or -1 if it is not there. The position recorded for the rule is
+ * tried first; if the array changed since, the positions of all its rules
+ * are recorded again, so that looking up each rule of a file in turn does
+ * not scan the file each time.
+ */
+static int app_profile_config_lookup_rule_index(AppProfileConfig *config,
+                                                json_t *rules, int id)
+{
+    json_t *rule_id;
+    char *key;
+    size_t i, size;
+    int idx = -1;
+
+    key = rule_id_to_key_string(id);
+    rule_id = json_object_get(config->rule_indices, key);
+    if (rule_id) {
+        i = json_integer_value(rule_id);
+        rule_id = json_object_get(json_array_get(rules, i), "id");
+        if (rule_id && (json_integer_value(rule_id) == id)) {
+            idx = i;
+        }
+    }
+    free(key);
+
+    if (idx != -1) {
+        return idx;
+    }
+
+    for (i = 0, size = json_array_size(rules); i < size; i++) {
+        rule_id = json_object_get(json_array_get(rules, i), "id");
+        if (!rule_id) {
+            continue;
+        }
+        key = rule_id_to_key_string(json_integer_value(rule_id));
+        json_object_set_new(config->rule_indices, key, json_integer(i));
+        free(key);
+        if (json_integer_value(rule_id) == id) {
+            idx = i;
+        }
+    }
+
+    return idx;
+}
+
+static void app_profile_config_invalidate_rule_counts(AppProfileConfig *config)
+{
+    json_decref(config->file_positions);
+    config->file_positions = NULL;
+    free(config->rule_counts);
+    config->rule_counts = NULL;
+    config->num_rule_counts = 0;
+}
+
+/*
+ * Builds a Fenwick tree of the number of rules in each parsed file, so that
+ * the number of rules before a file can be counted in logarithmic time.
+ */
+static void app_profile_config_build_rule_counts(AppProfileConfig *config)
+{
+    json_t *file;
+    size_t i, j, size;
+
+    size = json_array_size(config->parsed_files);
+
+    config->file_positions = json_object();
+    config->rule_counts = nvalloc(sizeof(size_t) * (size ? size : 1));
+    config->num_rule_counts = size;
+
+    for (i = 0; i < size; i++) {
+        file = json_array_get(config->parsed_files, i);
+        json_object_set_new(config->file_positions,
+                            json_string_value(json_object_get(file, "filename")),
+                            json_integer(i));
+
+        config->rule_counts[i] += json_array_size(json_object_get(file, "rules"));
+        j = i | (i + 1);
+        if (j < size) {
+            config->rule_counts[j] += config->rule_counts[i];
+        }
+    }
+}
+
+static void app_profile_config_update_rule_count(AppProfileConfig *config,
+                                                 const char *filename,
+                                                 int delta)
+{
+    json_t *pos;
+    size_t i;
+
+    if (!config->rule_counts) {
+        // The count is taken when the tree is next built
+        return;
+    }
+
+    pos = json_object_get(config->file_positions, filename);
+    if (!pos) {
+        app_profile_config_invalidate_rule_counts(config);
+        return;
+    }
+
+    for (i = json_integer_value(pos); i < config->num_rule_counts; i |= i + 1) {
+        config->rule_counts[i] += delta;
+    }
+}
+
 int nv_app_profile_config_create_rule(AppProfileConfig *config,
                                       const char *filename,
                                       json_t *new_rule)
@@ -1595,6 +1771,8 @@ int nv_app_profile_config_create_rule(AppProfileConfig *config,
     json_t *new_rule_copy;
     int new_id;
 
+    app_profile_config_invalidate_matcher(config);
+
     file = app_profile_config_lookup_file(config, filename);
     if (!file) {
         file = app_profile_config_new_file(config, filename);
@@ -1611,24 +1789,13 @@ int nv_app_profile_config_create_rule(AppProfileConfig *config,
 
     key = rule_id_to_key_string(new_id);
     json_object_set(config->rule_locations, key, json_string(filename));
+    json_object_set_new(config->rule_indices, key,
+                        json_integer(json_array_size(file_rules) - 1));
     free(key);
 
-    return new_id;
-}
+    app_profile_config_update_rule_count(config, filename, 1);
 
-static int lookup_rule_index_in_array(json_t *rules, int id)
-{
-    json_t *rule, *rule_id;
-    size_t i, size;
-    for (i = 0, size = json_array_size(rules); i < size; i++) {
-        rule = json_array_get(rules, i);
-        rule_id = json_object_get(rule, "id");
-        if (json_integer_value(rule_id) == id) {
-            return i;
-        }
-    }
-
-    return -1;
+    return new_id;
 }
 
 int nv_app_profile_config_update_rule(AppProfileConfig *config,
@@ -1644,6 +1811,8 @@ int nv_app_profile_config_update_rule(AppProfileConfig *config,
     int idx;
     int rule_moved;
 
+    app_profile_config_invalidate_matcher(config);
+
     key = rule_id_to_key_string(id);
     old_filename = json_string_value(json_object_get(config->rule_locations, key));
     assert(old_filename);
@@ -1663,19 +1832,22 @@ int nv_app_profile_config_update_rule(AppProfileConfig *config,
 
         new_file_rules = json_object_get(new_file, "rules");
 
-        idx = lookup_rule_index_in_array(old_file_rules, id);
+        idx = app_profile_config_lookup_rule_index(config, old_file_rules, id);
         if (idx != -1) {
             json_array_remove(old_file_rules, idx);
+            app_profile_config_update_rule_count(config, old_filename, -1);
         }
         json_array_insert(new_file_rules, 0, new_rule);
         new_rule_copy = json_array_get(new_file_rules, 0);
         json_object_set_new(new_rule_copy, "id", json_integer(id));
+        app_profile_config_update_rule_count(config, filename, 1);
 
         json_object_set_new(config->rule_locations, key, json_string(filename));
+        json_object_set_new(config->rule_indices, key, json_integer(0));
     } else {
         // Otherwise, just edit the existing rule
         rule_moved = FALSE;
-        idx = lookup_rule_index_in_array(old_file_rules, id);
+        idx = app_profile_config_lookup_rule_index(config, old_file_rules, id);
         if (idx != -1) {
             json_array_set(old_file_rules, idx, new_rule);
             new_rule_copy = json_array_get(old_file_rules, idx);
@@ -1698,6 +1870,8 @@ void nv_app_profile_config_delete_rule(AppProfileConfig *config, int id)
     char *key;
     int idx;
 
+    app_profile_config_invalidate_matcher(config);
+
     key = rule_id_to_key_string(id);
 
     filename = json_string_value(json_object_get(config->rule_locations, key));
@@ -1708,12 +1882,14 @@ void nv_app_profile_config_delete_rule(AppProfileConfig *config, int id)
 
     file_rules = json_object_get(file, "rules");
 
-    idx = lookup_rule_index_in_array(file_rules, id);
+    idx = app_profile_config_lookup_rule_index(config, file_rules, id);
     if (idx != -1) {
         json_array_remove(file_rules, idx);
+        app_profile_config_update_rule_count(config, filename, -1);
     }
 
     json_object_del(config->rule_locations, key);
+    json_object_del(config->rule_indices, key);
     free(key);
 }
 
@@ -1724,17 +1900,20 @@ size_t nv_app_profile_config_count_rules(AppProfileConfig *config)
 
 static size_t app_profile_config_count_rules_before(AppProfileConfig *config, const char *filename)
 {
-    size_t i, size;
+    json_t *pos;
+    size_t i;
     size_t num_rules = 0;
-    json_t *cur_file, *cur_filename;
 
-    for (i = 0, size = json_array_size(config->parsed_files); i < size; i++) {
-        cur_file = json_array_get(config->parsed_files, i);
-        cur_filename = json_object_get(cur_file, "filename");
-        if (!strcmp(filename, json_string_value(cur_filename))) {
-            break;
-        }
-        num_rules += json_array_size(json_object_get(cur_file, "rules"));
+    if (!config->rule_counts) {
+        app_profile_config_build_rule_counts(config);
+    }
+
+    // A file which is not in the configuration comes after all the others
+    pos = json_object_get(config->file_positions, filename);
+    i = pos ? (size_t)json_integer_value(pos) : config->num_rule_counts;
+
+    for ( ; i > 0; i &= i - 1) {
+        num_rules += config->rule_counts[i - 1];
     }
 
     return num_rules;
@@ -1781,11 +1960,15 @@ static void app_profile_config_insert_rule(AppProfileConfig *config,
 
     file_rules = json_object_get(target[i], "rules");
     json_array_insert_new(file_rules, new_pri - rules_before_target[i], rule);
-    // Update the hashtable to point to the new file
+    // Update the hashtables to point to the new file and position
     key = rule_id_to_key_string(json_integer_value(json_object_get(rule, "id")));
     filename = json_string_value(json_object_get(target[i], "filename"));
     json_object_set_new(config->rule_locations, key, json_string(filename));
+    json_object_set_new(config->rule_indices, key,
+                        json_integer(new_pri - rules_before_target[i]));
     free(key);
+
+    app_profile_config_update_rule_count(config, filename, 1);
 }
 
 size_t nv_app_profile_config_get_rule_priority(AppProfileConfig *config,
@@ -1806,7 +1989,7 @@ size_t nv_app_profile_config_get_rule_priority(AppProfileConfig *config,
 
     file_rules = json_object_get(file, "rules");
 
-    idx = lookup_rule_index_in_array(file_rules, id);
+    idx = app_profile_config_lookup_rule_index(config, file_rules, id);
 
     free(key);
 
@@ -1825,6 +2008,8 @@ static void app_profile_config_set_abs_rule_priority_internal(AppProfileConfig *
     int idx;
     char *key;
 
+    app_profile_config_invalidate_matcher(config);
+
     if (new_pri == current_pri) {
         return;
     } else if (new_pri >= lowest_pri) {
@@ -1840,12 +2025,13 @@ static void app_profile_config_set_abs_rule_priority_internal(AppProfileConfig *
     assert(file);
 
     file_rules = json_object_get(file, "rules");
-    idx = lookup_rule_index_in_array(file_rules, id);
+    idx = app_profile_config_lookup_rule_index(config, file_rules, id);
     assert(idx >= 0);
     rule = json_array_get(file_rules, idx);
 
     rule_copy = json_deep_copy(rule);
     json_array_remove(file_rules, idx);
+    app_profile_config_update_rule_count(config, filename, -1);
 
     app_profile_config_insert_rule(config, rule_copy, new_pri, filename);
 
@@ -1912,7 +2098,7 @@ const json_t *nv_app_profile_config_get_rule(AppProfileConfig *config,
     file = app_profile_config_lookup_file(config, json_string_value(filename));
     file_rules = json_object_get(file, "rules");
 
-    idx = lookup_rule_index_in_array(file_rules, id);
+    idx = app_profile_config_lookup_rule_index(config, file_rules, id);
     if (idx != -1) {
         rule = json_array_get(file_rules, idx);
     } else {
@@ -2238,6 +2424,345 @@ int nv_app_profile_config_check_backing_files(AppProfileConfig *config)
     return changed;
 }
 
+/*
+ * Remove the given file, or all files in the given directory, from the
+ * configuration, along with their profiles and rules.
+ */
+static void app_profile_config_unload_file(AppProfileConfig *config,
+                                           const char *filename)
+{
+    json_t *file, *file_rules, *file_profiles, *value;
+    json_t *order, *file_order;
+    const char *cur_filename, *key;
+    char *rule_key;
+    size_t i, j, size;
+    size_t major, file_order_major, file_order_minor;
+
+    i = 0;
+    while (i < json_array_size(config->parsed_files)) {
+        file = json_array_get(config->parsed_files, i);
+        cur_filename = json_string_value(json_object_get(file, "filename"));
+
+        if (strcmp(cur_filename, filename) &&
+            (app_profile_config_check_is_prefix(cur_filename, filename) <= 0)) {
+            i++;
+            continue;
+        }
+
+        file_profiles = json_object_get(file, "profiles");
+        NV_JSON_OBJECT_FOREACH(file_profiles, key, value) {
+            json_object_del(config->profile_locations, key);
+        }
+
+        file_rules = json_object_get(file, "rules");
+        for (j = 0, size = json_array_size(file_rules); j < size; j++) {
+            value = json_array_get(file_rules, j);
+            rule_key = rule_id_to_key_string(json_integer_value(json_object_get(value, "id")));
+            json_object_del(config->rule_locations, rule_key);
+            json_object_del(config->rule_indices, rule_key);
+            free(rule_key);
+        }
+
+        // Close the gap in the order of files with the same major
+        order = json_object_get(file, "order");
+        major = json_integer_value(json_object_get(order, "major"));
+
+        for (j = i + 1, size = json_array_size(config->parsed_files); j < size; j++) {
+            file_order = json_object_get(json_array_get(config->parsed_files, j), "order");
+            file_order_major = json_integer_value(json_object_get(file_order, "major"));
+            file_order_minor = json_integer_value(json_object_get(file_order, "minor"));
+            if (file_order_major > major) {
+                break;
+            }
+            json_object_set_new(file_order, "minor", json_integer(file_order_minor-1));
+        }
+
+        json_array_remove(config->parsed_files, i);
+        app_profile_config_invalidate_rule_counts(config);
+    }
+}
+
+int nv_app_profile_config_reload_file(AppProfileConfig *config,
+                                      const char *filename)
+{
+    FILE *fp;
+    struct stat stat_buf;
+    char *dirname;
+    int in_search_path, ret;
+
+    app_profile_config_invalidate_matcher(config);
+
+    if (config->global_config_file &&
+        !strcmp(filename, config->global_config_file)) {
+        json_decref(config->global_options);
+        config->global_options =
+            app_profile_config_load_global_options(filename);
+        return TRUE;
+    }
+
+    in_search_path = file_in_search_path(config, filename);
+    if (!in_search_path) {
+        dirname = nv_dirname(filename);
+        ret = file_in_search_path(config, dirname);
+        free(dirname);
+        if (!ret) {
+            return FALSE;
+        }
+    }
+
+    app_profile_config_unload_file(config, filename);
+
+    ret = open_and_stat(filename, "r", &fp, &stat_buf);
+    if (ret < 0) {
+        // The file was removed
+        return TRUE;
+    }
+
+    /*
+     * app_profile_config_load_file() inserts the file at its position in
+     * the search path order, so rule priorities remain consistent with a
+     * full reload.
+     */
+    if (S_ISDIR(stat_buf.st_mode)) {
+        fclose(fp);
+        if (in_search_path) {
+            app_profile_config_load_files_from_directory(config, filename);
+        }
+    } else {
+        app_profile_config_load_file(config, filename, &stat_buf, fp);
+        fclose(fp);
+    }
+
+    return TRUE;
+}
+
+struct AppProfileConfigWatchRec {
+    int fd;
+
+    // Watched directories, and their inotify watch descriptors
+    char **dirs;
+    int *wds;
+    size_t num_dirs;
+
+    // Copy of the global configuration filename and search path
+    char *global_config_file;
+    char **search_path;
+    size_t search_path_count;
+};
+
+#if defined(__linux__)
+
+#define APP_PROFILE_WATCH_MASK (IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | \
+                                IN_MOVED_FROM | IN_MOVED_TO)
+
+static void app_profile_config_watch_add_dir(AppProfileConfigWatch *watch,
+                                             const char *dir)
+{
+    size_t i;
+    int wd;
+
+    for (i = 0; i < watch->num_dirs; i++) {
+        if (!strcmp(watch->dirs[i], dir)) {
+            if (watch->wds[i] < 0) {
+                watch->wds[i] = inotify_add_watch(watch->fd, dir,
+                                                  APP_PROFILE_WATCH_MASK);
+            }
+            return;
+        }
+    }
+
+    // Directories which do not exist (yet) are not watched
+    wd = inotify_add_watch(watch->fd, dir, APP_PROFILE_WATCH_MASK);
+
+    watch->dirs = nvrealloc(watch->dirs, sizeof(char *) * (watch->num_dirs + 1));
+    watch->wds = nvrealloc(watch->wds, sizeof(int) * (watch->num_dirs + 1));
+    watch->dirs[watch->num_dirs] = nvstrdup(dir);
+    watch->wds[watch->num_dirs] = wd;
+    watch->num_dirs++;
+}
+
+/*
+ * Watch both the parent directory of each search path entry, to be notified
+ * when the entry is created, replaced or removed, and the entry itself, for
+ * the files it contains if it is a directory.
+ */
+static void app_profile_config_watch_add_entry(AppProfileConfigWatch *watch,
+                                               const char *filename)
+{
+    struct stat stat_buf;
+    char *dirname = nv_dirname(filename);
+
+    app_profile_config_watch_add_dir(watch, dirname);
+    free(dirname);
+
+    if ((stat(filename, &stat_buf) == 0) && S_ISDIR(stat_buf.st_mode)) {
+        app_profile_config_watch_add_dir(watch, filename);
+    }
+}
+
+#endif
+
+AppProfileConfigWatch *nv_app_profile_config_watch_new(AppProfileConfig *config)
+{
+#if defined(__linux__)
+    AppProfileConfigWatch *watch;
+    size_t i;
+    int fd;
+
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    watch = nvalloc(sizeof(AppProfileConfigWatch));
+    watch->fd = fd;
+
+    if (config->global_config_file) {
+        watch->global_config_file = nvstrdup(config->global_config_file);
+        app_profile_config_watch_add_entry(watch, config->global_config_file);
+    }
+
+    watch->search_path = nvalloc(sizeof(char *) * (config->search_path_count + 1));
+    watch->search_path_count = config->search_path_count;
+
+    for (i = 0; i < config->search_path_count; i++) {
+        watch->search_path[i] = nvstrdup(config->search_path[i]);
+        app_profile_config_watch_add_entry(watch, config->search_path[i]);
+    }
+
+    return watch;
+#else
+    return NULL;
+#endif
+}
+
+int nv_app_profile_config_watch_get_fd(AppProfileConfigWatch *watch)
+{
+    return watch->fd;
+}
+
+#if defined(__linux__)
+
+/*
+ * Returns the search path entry or the global configuration file which
+ * filename refers to, or NULL if it is not part of the configuration.
+ */
+static const char *app_profile_config_watch_lookup(AppProfileConfigWatch *watch,
+                                                   const char *filename,
+                                                   const char *dir)
+{
+    size_t i;
+
+    if (watch->global_config_file &&
+        !strcmp(filename, watch->global_config_file)) {
+        return watch->global_config_file;
+    }
+
+    for (i = 0; i < watch->search_path_count; i++) {
+        if (!strcmp(filename, watch->search_path[i]) ||
+            !strcmp(dir, watch->search_path[i])) {
+            return watch->search_path[i];
+        }
+    }
+
+    return NULL;
+}
+
+#endif
+
+json_t *nv_app_profile_config_watch_read_changes(AppProfileConfigWatch *watch)
+{
+    json_t *changes = json_array();
+#if defined(__linux__)
+    json_t *seen = json_object();
+    char buf[4096 + sizeof(struct inotify_event) + NAME_MAX + 1]
+        __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *event;
+    const char *entry;
+    char *filename;
+    ssize_t len;
+    char *p;
+    size_t i;
+
+    while ((len = read(watch->fd, buf, sizeof(buf))) > 0) {
+        for (p = buf; p < buf + len;
+             p += sizeof(struct inotify_event) + event->len) {
+            event = (const struct inotify_event *) p;
+
+            for (i = 0; i < watch->num_dirs; i++) {
+                if (watch->wds[i] == event->wd) {
+                    break;
+                }
+            }
+            if (i == watch->num_dirs) {
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED) {
+                // The directory was removed
+                watch->wds[i] = -1;
+                continue;
+            }
+
+            if (!event->len) {
+                continue;
+            }
+
+            // Files are reported once they have been written
+            if ((event->mask & IN_CREATE) && !(event->mask & IN_ISDIR)) {
+                continue;
+            }
+
+            filename = nvstrcat(watch->dirs[i], "/", event->name, NULL);
+            entry = app_profile_config_watch_lookup(watch, filename,
+                                                    watch->dirs[i]);
+
+            if (entry) {
+                // Start watching search path directories as they are created
+                if ((event->mask & IN_ISDIR) && !strcmp(entry, filename)) {
+                    app_profile_config_watch_add_entry(watch, filename);
+                }
+
+                if (!json_object_get(seen, filename)) {
+                    json_object_set_new(seen, filename, json_true());
+                    json_array_append_new(changes, json_string(filename));
+                }
+            }
+            free(filename);
+        }
+    }
+
+    json_decref(seen);
+#endif
+
+    return changes;
+}
+
+void nv_app_profile_config_watch_free(AppProfileConfigWatch *watch)
+{
+    size_t i;
+
+    if (!watch) {
+        return;
+    }
+
+    close(watch->fd);
+
+    for (i = 0; i < watch->num_dirs; i++) {
+        free(watch->dirs[i]);
+    }
+    free(watch->dirs);
+    free(watch->wds);
+
+    for (i = 0; i < watch->search_path_count; i++) {
+        free(watch->search_path[i]);
+    }
+    free(watch->search_path);
+    free(watch->global_config_file);
+
+    free(watch);
+}
+
 /*
  * Filenames in the search path ending in "*.d" are directories by convention,
  * and should not be listed as valid default filenames.
@@ -2296,6 +2821,8 @@ int nv_app_profile_config_profile_name_change_fixup(AppProfileConfig *config,
     json_t *file, *rules, *rule, *rule_profile;
     const char *rule_profile_str;
 
+    app_profile_config_invalidate_matcher(config);
+
     for (i = 0, num_files = json_array_size(config->parsed_files); i < num_files; i++) {
         file = json_array_get(config->parsed_files, i);
         rules = json_object_get(file, "rules");
@@ -2313,3 +2840,265 @@ int nv_app_profile_config_profile_name_change_fixup(AppProfileConfig *config,
 
     return fixed_up;
 }
+
+char *nv_app_profile_get_default_global_config_file(void)
+{
+    const char *homeStr = getenv("HOME");
+    if (homeStr) {
+        return nvstrcat(homeStr, "/.nv/nvidia-application-profile-globals-rc", NULL);
+    } else {
+        nv_error_msg("The environment variable HOME is not set. Any "
+                     "modifications to global application profile settings "
+                     "will not be saved.");
+        return NULL;
+    }
+}
+
+#define SEARCH_PATH_NUM_FILES 4
+
+char **nv_app_profile_get_default_search_path(size_t *num_files)
+{
+    size_t i = 0;
+    char **filenames = malloc(SEARCH_PATH_NUM_FILES * sizeof(char *));
+    const char *homeStr = getenv("HOME");
+
+    if (homeStr) {
+        filenames[i++] = nvstrcat(homeStr, "/.nv/nvidia-application-profiles-rc", NULL);
+        filenames[i++] = nvstrcat(homeStr, "/.nv/nvidia-application-profiles-rc.d", NULL);
+    }
+    filenames[i++] = strdup("/etc/nvidia/nvidia-application-profiles-rc");
+    filenames[i++] = strdup("/etc/nvidia/nvidia-application-profiles-rc.d");
+
+    *num_files = i;
+    assert(i <= SEARCH_PATH_NUM_FILES);
+
+    return filenames;
+}
+
+void nv_app_profile_free_search_path(char **search_path, size_t search_path_size)
+{
+    while (search_path_size--) {
+        free(search_path[search_path_size]);
+    }
+    free(search_path);
+}
+
+/*
+ * The rules of a configuration, compiled for matching: rules using the
+ * procname, commname and dso features are indexed by the string they
+ * match, so that the rules which apply to a process can be found without
+ * evaluating all of them.
+ */
+struct AppProfileMatcherRec {
+    json_t *rules;      // JSON array of the rules, in priority order
+    json_t *filenames;  // JSON array of the files of these rules
+    json_t *index;      // JSON object: feature -> matches -> priorities
+    json_t *always;     // JSON array of the priorities of "true" rules
+};
+
+static const char *indexed_features[] = { "procname", "commname", "dso" };
+
+static void app_profile_config_invalidate_matcher(AppProfileConfig *config)
+{
+    AppProfileMatcher *matcher = config->matcher;
+
+    if (!matcher) {
+        return;
+    }
+
+    json_decref(matcher->rules);
+    json_decref(matcher->filenames);
+    json_decref(matcher->index);
+    json_decref(matcher->always);
+    free(matcher);
+
+    config->matcher = NULL;
+}
+
+static AppProfileMatcher *app_profile_config_compile_matcher(AppProfileConfig *config)
+{
+    AppProfileMatcher *matcher = nvalloc(sizeof(AppProfileMatcher));
+    json_t *file, *file_rules, *filename, *rule, *pattern;
+    json_t *feature_index, *pris;
+    const char *feature, *matches;
+    size_t i, j, num_files, num_rules;
+    size_t pri = 0;
+
+    matcher->rules = json_array();
+    matcher->filenames = json_array();
+    matcher->index = json_object();
+    matcher->always = json_array();
+
+    for (i = 0; i < ARRAY_LEN(indexed_features); i++) {
+        json_object_set_new(matcher->index, indexed_features[i], json_object());
+    }
+
+    for (i = 0, num_files = json_array_size(config->parsed_files); i < num_files; i++) {
+        file = json_array_get(config->parsed_files, i);
+        file_rules = json_object_get(file, "rules");
+        filename = json_object_get(file, "filename");
+
+        for (j = 0, num_rules = json_array_size(file_rules); j < num_rules; j++, pri++) {
+            rule = json_array_get(file_rules, j);
+            json_array_append(matcher->rules, rule);
+            json_array_append(matcher->filenames, filename);
+
+            pattern = json_object_get(rule, "pattern");
+            feature = json_string_value(json_object_get(pattern, "feature"));
+            matches = json_string_value(json_object_get(pattern, "matches"));
+
+            if (!feature) {
+                continue;
+            }
+
+            if (!strcmp(feature, "true")) {
+                json_array_append_new(matcher->always, json_integer(pri));
+                continue;
+            }
+
+            // Rules using other features never match
+            feature_index = json_object_get(matcher->index, feature);
+            if (!feature_index || !matches) {
+                continue;
+            }
+
+            pris = json_object_get(feature_index, matches);
+            if (!pris) {
+                pris = json_array();
+                json_object_set_new(feature_index, matches, pris);
+            }
+            json_array_append_new(pris, json_integer(pri));
+        }
+    }
+
+    return matcher;
+}
+
+typedef struct {
+    size_t *pris;
+    size_t num_pris;
+    size_t alloc;
+} PriorityList;
+
+static void priority_list_add(PriorityList *list, const json_t *pris)
+{
+    size_t i, size = json_array_size(pris);
+
+    if (list->num_pris + size > list->alloc) {
+        list->alloc = (list->num_pris + size) * 2;
+        list->pris = nvrealloc(list->pris, list->alloc * sizeof(size_t));
+    }
+
+    for (i = 0; i < size; i++) {
+        list->pris[list->num_pris++] = json_integer_value(json_array_get(pris, i));
+    }
+}
+
+static void priority_list_add_matches(PriorityList *list,
+                                      const AppProfileMatcher *matcher,
+                                      const char *feature,
+                                      const char *name)
+{
+    const char *basename;
+
+    if (!name) {
+        return;
+    }
+
+    // Leading directory components are not considered
+    basename = strrchr(name, '/');
+    basename = basename ? basename + 1 : name;
+
+    priority_list_add(list, json_object_get(json_object_get(matcher->index,
+                                                            feature),
+                                            basename));
+}
+
+static int compare_priorities(const void *a, const void *b)
+{
+    size_t pri_a = *(const size_t *)a;
+    size_t pri_b = *(const size_t *)b;
+
+    return (pri_a > pri_b) - (pri_a < pri_b);
+}
+
+json_t *nv_app_profile_config_match(AppProfileConfig *config,
+                                    const AppProfileProcess *process)
+{
+    AppProfileMatcher *matcher;
+    PriorityList list = { NULL, 0, 0 };
+    json_t *result, *matched_rules, *settings, *seen_keys;
+    json_t *rule, *matched_rule, *profile_settings, *setting, *key;
+    const json_t *profile;
+    const char *profile_name;
+    size_t i, j, size;
+
+    if (!config->matcher) {
+        config->matcher = app_profile_config_compile_matcher(config);
+    }
+    matcher = config->matcher;
+
+    // Gather the priorities of all the matching rules
+    priority_list_add(&list, matcher->always);
+    priority_list_add_matches(&list, matcher, "procname", process->procname);
+    priority_list_add_matches(&list, matcher, "commname", process->commname);
+    for (i = 0; i < process->num_dsos; i++) {
+        priority_list_add_matches(&list, matcher, "dso", process->dsos[i]);
+    }
+
+    if (list.num_pris > 1) {
+        qsort(list.pris, list.num_pris, sizeof(size_t), compare_priorities);
+    }
+
+    result = json_object();
+    matched_rules = json_array();
+    settings = json_array();
+    seen_keys = json_object();
+
+    for (i = 0; i < list.num_pris; i++) {
+        // A rule may match several loaded DSOs
+        if ((i > 0) && (list.pris[i] == list.pris[i-1])) {
+            continue;
+        }
+
+        rule = json_array_get(matcher->rules, list.pris[i]);
+
+        matched_rule = json_deep_copy(rule);
+        json_object_set_new(matched_rule, "priority", json_integer(list.pris[i]));
+        json_object_set(matched_rule, "filename",
+                        json_array_get(matcher->filenames, list.pris[i]));
+        json_array_append_new(matched_rules, matched_rule);
+
+        /*
+         * All the settings of the matching profiles apply; when several
+         * profiles set the same key, the rule with the highest priority
+         * takes precedence.
+         */
+        profile_name = json_string_value(json_object_get(rule, "profile"));
+        profile = profile_name ?
+            nv_app_profile_config_get_profile(config, profile_name) : NULL;
+        profile_settings = json_object_get(profile, "settings");
+
+        for (j = 0, size = json_array_size(profile_settings); j < size; j++) {
+            key = json_object_get(json_array_get(profile_settings, j), "key");
+            if (!json_is_string(key) ||
+                json_object_get(seen_keys, json_string_value(key))) {
+                continue;
+            }
+            json_object_set_new(seen_keys, json_string_value(key), json_true());
+
+            setting = json_deep_copy(json_array_get(profile_settings, j));
+            json_object_set_new(setting, "profile", json_string(profile_name));
+            json_object_set(setting, "id", json_object_get(rule, "id"));
+            json_array_append_new(settings, setting);
+        }
+    }
+
+    json_object_set_new(result, "rules", matched_rules);
+    json_object_set_new(result, "settings", settings);
+
+    json_decref(seen_keys);
+    free(list.pris);
+
+    return result;
+}
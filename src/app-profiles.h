@@ -79,6 +79,8 @@
  * as determined by nvidia-settings. This configuration contains a list
  * of files which contain rules and profiles.
  */
+typedef struct AppProfileMatcherRec AppProfileMatcher;
+
 typedef struct AppProfileConfigRec {
     /*
      * JSON object containing our global app profile options. Currently
@@ -114,6 +116,26 @@ typedef struct AppProfileConfigRec {
      */
     char **search_path;
     size_t search_path_count;
+
+    /*
+     * Rules compiled for nv_app_profile_config_match(); built on first use,
+     * and discarded whenever rules or profiles are modified.
+     */
+    AppProfileMatcher *matcher;
+
+    /*
+     * Lookup structures for rules: rule_indices maps the key of each rule
+     * id to the position of the rule in the rules array of its file; it is
+     * only a hint, which is checked on use and refreshed when stale.
+     * rule_counts is a Fenwick tree of the number of rules in each parsed
+     * file, used to compute rule priorities, and file_positions maps file
+     * names to their position in parsed_files; both are rebuilt on demand
+     * after files are added or removed.
+     */
+    json_t *rule_indices;
+    json_t *file_positions;
+    size_t *rule_counts;
+    size_t num_rule_counts;
 } AppProfileConfig;
 
 /*
@@ -280,6 +302,36 @@ void nv_app_profile_config_change_rule_priority(AppProfileConfig *config,
  */
 int nv_app_profile_config_check_backing_files(AppProfileConfig *config);
 
+/*
+ * Reparses the given file from the configuration's search path, or the
+ * files of the given search path directory, or the global configuration
+ * file, and replaces their profiles and rules in the configuration. Files
+ * which no longer exist are removed from the configuration.
+ *
+ * This function returns FALSE if filename is not part of the configuration.
+ */
+int nv_app_profile_config_reload_file(AppProfileConfig *config,
+                                      const char *filename);
+
+/*
+ * An AppProfileConfigWatch uses inotify(7) to track changes to the files
+ * backing a configuration, so that only the files which changed need to be
+ * reloaded with nv_app_profile_config_reload_file().
+ *
+ * nv_app_profile_config_watch_new() returns NULL if the files cannot be
+ * watched. Otherwise, the file descriptor returned by
+ * nv_app_profile_config_watch_get_fd() becomes readable when files changed,
+ * and nv_app_profile_config_watch_read_changes() then returns a JSON array
+ * of the names of these files, without duplicates, which should be freed
+ * via json_decref().
+ */
+typedef struct AppProfileConfigWatchRec AppProfileConfigWatch;
+
+AppProfileConfigWatch *nv_app_profile_config_watch_new(AppProfileConfig *config);
+int nv_app_profile_config_watch_get_fd(AppProfileConfigWatch *watch);
+json_t *nv_app_profile_config_watch_read_changes(AppProfileConfigWatch *watch);
+void nv_app_profile_config_watch_free(AppProfileConfigWatch *watch);
+
 /*
  * Utility function to strip comments and translate hex/octal values to decimal
  * so the JSON parser can understand.
@@ -320,4 +372,41 @@ int nv_app_profile_config_profile_name_change_fixup(AppProfileConfig *config,
                                                     const char *orig_name,
                                                     const char *new_name);
 
+/*
+ * Returns the default global configuration file and search path of the
+ * application profile configuration. The search path should be freed via
+ * nv_app_profile_free_search_path().
+ */
+char *nv_app_profile_get_default_global_config_file(void);
+char **nv_app_profile_get_default_search_path(size_t *num_files);
+void nv_app_profile_free_search_path(char **search_path, size_t search_path_size);
+
+/*
+ * Description of a process, used to determine which rules apply to it.
+ * Leading directory components of the names are ignored.
+ */
+typedef struct {
+    const char *procname;   // pathname of the process, or NULL
+    const char *commname;   // command name of the process, or NULL
+    const char **dsos;      // pathnames of the shared objects it loaded
+    size_t num_dsos;
+} AppProfileProcess;
+
+/*
+ * Evaluates the rules of the configuration against the given process, the
+ * way the driver does. This returns a JSON object, which should be freed
+ * via json_decref(), with the following members:
+ *     rules: array of the matching rules, in priority order, each with
+ *            "priority" and "filename" members added.
+ *     settings: array of the settings which apply to the process, each
+ *               with the key and value of the setting, and the "profile"
+ *               and rule "id" it comes from. If several matching profiles
+ *               set the same key, the highest priority rule wins.
+ *
+ * Rules are indexed on first use, so that matching does not depend on the
+ * number of rules in the configuration.
+ */
+json_t *nv_app_profile_config_match(AppProfileConfig *config,
+                                    const AppProfileProcess *process);
+
 #endif // __APP_PROFILES_H__
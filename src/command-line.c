@@ -35,10 +35,12 @@
 
 #include "common-utils.h"
 #include "config-file.h"
+#include "app-profiles.h"
 
 /* local prototypes */
 
 static void print_attribute_help(const char *attr);
+static void print_app_profile_match(const char *process_str);
 static void print_help(void);
 
 /*
@@ -176,6 +178,143 @@ static void print_attribute_help(const char *attr)
 } /* print_attribute_help() */
 
 
+/*
+ * print_app_profile_match() - print the application profile rules which
+ * match the process described by process_str, a comma separated list of
+ * "procname=", "commname=" and "dso=" items, and the resulting settings.
+ */
+
+static void print_app_profile_match(const char *process_str)
+{
+    AppProfileProcess process = { NULL, NULL, NULL, 0 };
+    AppProfileConfig *config;
+    char *str, *item, *value, *saveptr = NULL;
+    char *global_config_file;
+    char **search_path;
+    size_t search_path_size;
+    json_t *match, *rules, *settings, *entry, *json_value;
+    size_t i;
+    char *value_str;
+
+    str = nvstrdup(process_str);
+
+    for (item = strtok_r(str, ",", &saveptr); item;
+         item = strtok_r(NULL, ",", &saveptr)) {
+
+        value = strchr(item, '=');
+        if (value) {
+            *value++ = '\0';
+        }
+
+        if (value && !strcmp(item, "procname")) {
+            process.procname = value;
+        } else if (value && !strcmp(item, "commname")) {
+            process.commname = value;
+        } else if (value && !strcmp(item, "dso")) {
+            process.dsos = nvrealloc(process.dsos, sizeof(char *) *
+                                     (process.num_dsos + 1));
+            process.dsos[process.num_dsos++] = value;
+        } else {
+            nv_error_msg("Invalid process description item '%s'; expected "
+                         "'procname=', 'commname=' or 'dso='.", item);
+            goto done;
+        }
+    }
+
+    search_path = nv_app_profile_get_default_search_path(&search_path_size);
+    global_config_file = nv_app_profile_get_default_global_config_file();
+    config = nv_app_profile_config_load(global_config_file, search_path,
+                                        search_path_size);
+    nv_app_profile_free_search_path(search_path, search_path_size);
+    free(global_config_file);
+
+    if (!config) {
+        goto done;
+    }
+
+    match = nv_app_profile_config_match(config, &process);
+    rules = json_object_get(match, "rules");
+    settings = json_object_get(match, "settings");
+
+    nv_msg(NULL, "");
+
+    if (!nv_app_profile_config_get_enabled(config)) {
+        nv_warning_msg("Application profiles are disabled; the driver does "
+                       "not apply the settings below.");
+        nv_msg(NULL, "");
+    }
+
+    if (json_array_size(rules) == 0) {
+        nv_msg(NULL, "No application profile rules match.");
+    } else {
+        nv_msg(NULL, "Matching rules, in priority order:");
+        nv_msg(NULL, "");
+    }
+
+    for (i = 0; i < json_array_size(rules); i++) {
+        json_t *pattern;
+
+        entry = json_array_get(rules, i);
+        pattern = json_object_get(entry, "pattern");
+
+        nv_msg(TAB, "%" JSON_INTEGER_FORMAT ": %s \"%s\" -> profile \"%s\" (%s)",
+               json_integer_value(json_object_get(entry, "priority")),
+               json_string_value(json_object_get(pattern, "feature")),
+               json_string_value(json_object_get(pattern, "matches")),
+               json_string_value(json_object_get(entry, "profile")),
+               json_string_value(json_object_get(entry, "filename")));
+    }
+
+    if (json_array_size(settings)) {
+        nv_msg(NULL, "");
+        nv_msg(NULL, "Settings applied:");
+        nv_msg(NULL, "");
+    }
+
+    for (i = 0; i < json_array_size(settings); i++) {
+        entry = json_array_get(settings, i);
+        json_value = json_object_get(entry, "value");
+
+        switch (json_typeof(json_value)) {
+        case JSON_STRING:
+            value_str = nvasprintf("\"%s\"", json_string_value(json_value));
+            break;
+        case JSON_INTEGER:
+            value_str = nvasprintf("%" JSON_INTEGER_FORMAT,
+                                   json_integer_value(json_value));
+            break;
+        case JSON_REAL:
+            value_str = nvasprintf("%g", json_real_value(json_value));
+            break;
+        case JSON_TRUE:
+            value_str = nvstrdup("true");
+            break;
+        case JSON_FALSE:
+            value_str = nvstrdup("false");
+            break;
+        default:
+            value_str = nvstrdup("?");
+            break;
+        }
+
+        nv_msg(TAB, "%s = %s (profile \"%s\")",
+               json_string_value(json_object_get(entry, "key")), value_str,
+               json_string_value(json_object_get(entry, "profile")));
+        nvfree(value_str);
+    }
+
+    nv_msg(NULL, "");
+
+    json_decref(match);
+    nv_app_profile_config_free(config);
+
+ done:
+    nvfree(process.dsos);
+    nvfree(str);
+
+} /* print_app_profile_match() */
+
+
 static void print_help_helper(const char *name, const char *description)
 {
     nv_msg(TAB, "%s", name);
@@ -216,10 +355,12 @@ Options *parse_command_line(int argc, char *argv[],
     int n, c;
     char *strval;
     int boolval;
+    int intval;
 
     op = nvalloc(sizeof(Options));
     op->config = DEFAULT_RC_FILE;
     op->write_config = NV_TRUE;
+    op->monitor_interval = DEFAULT_MONITOR_INTERVAL;
 
     /*
      * initialize the controlled display to the gui display name
@@ -229,7 +370,7 @@ Options *parse_command_line(int argc, char *argv[],
     while (1) {
         c = nvgetopt(argc, argv, __options, &strval,
                      &boolval,  /* boolval */
-                     NULL,  /* intval */
+                     &intval,  /* intval */
                      NULL,  /* doubleval */
                      NULL); /* disable_val */
 
@@ -242,13 +383,22 @@ Options *parse_command_line(int argc, char *argv[],
         case 'l': op->only_load = 1; break;
         case 'n': op->no_load = 1; break;
         case 'r': op->rewrite = 1; break;
-        case 'c': op->ctrl_display = strval; break;
+        case 'c':
+            n = op->num_ctrl_displays;
+            op->ctrl_displays = nvrealloc(op->ctrl_displays,
+                                          sizeof(char *) * (n+1));
+            op->ctrl_displays[n] = strval;
+            op->num_ctrl_displays++;
+            if (n == 0) {
+                op->ctrl_display = strval;
+            }
+            break;
         case DISPLAY_OPTION:
             /*
              * --ctrl-display and --display can both be specified so only assign
              * --display to ctrl_display if it is not yet assigned.
              */
-            if (!op->ctrl_display) {
+            if (!op->num_ctrl_displays) {
                 op->ctrl_display = strval;
             }
             break;
@@ -289,13 +439,45 @@ Options *parse_command_line(int argc, char *argv[],
             op->queries[n] = strval;
             op->num_queries++;
             break;
+        case MONITOR_OPTION:
+            n = op->num_monitors;
+            op->monitors = nvrealloc(op->monitors, sizeof(char *) * (n+1));
+            op->monitors[n] = strval;
+            op->num_monitors++;
+            break;
+        case MONITOR_INTERVAL_OPTION:
+            if (intval <= 0) {
+                nv_error_msg("Invalid monitoring interval '%d'; the interval "
+                             "must be a positive number of milliseconds.",
+                             intval);
+                exit(0);
+            }
+            op->monitor_interval = intval;
+            break;
+        case MONITOR_FORMAT_OPTION:
+            if (nv_strcasecmp(strval, "csv") == NV_TRUE) {
+                op->monitor_json = NV_FALSE;
+            } else if (nv_strcasecmp(strval, "json") == NV_TRUE) {
+                op->monitor_json = NV_TRUE;
+            } else {
+                nv_error_msg("Invalid monitoring output format '%s'.  Please "
+                             "run `%s --help` for usage information.\n",
+                             strval, argv[0]);
+                exit(0);
+            }
+            break;
         case CONFIG_FILE_OPTION: op->config = strval; break;
         case 'g': print_glxinfo(NULL, systems); exit(0); break;
         case 'E': print_eglinfo(NULL, systems); exit(0); break;
         case 't': op->terse = NV_TRUE; break;
         case 'd': op->dpy_string = NV_TRUE; break;
         case 'e': print_attribute_help(strval); exit(0); break;
+        case APP_PROFILE_MATCH_OPTION:
+            print_app_profile_match(strval);
+            exit(0);
+            break;
         case 'L': op->list_targets = NV_TRUE; break;
+        case DRY_RUN_OPTION: op->dry_run = NV_TRUE; break;
         case 'w': op->write_config = boolval; break;
         case 'i': op->use_gtk2 = NV_TRUE; break;
         case 'I': op->gtk_lib_path = strval; break;
@@ -306,6 +488,30 @@ Options *parse_command_line(int argc, char *argv[],
         }
     }
 
+    /* the samples of several displays could not be merged */
+
+    if (op->num_monitors && (op->num_ctrl_displays > 1)) {
+        nv_error_msg("The --monitor option can only be used with a single "
+                     "--ctrl-display.  Please run `%s --help` for usage "
+                     "information.\n", argv[0]);
+        exit(0);
+    }
+
+    /*
+     * --dry-run only applies to loading the configuration file; don't
+     * let it be silently ignored by the operations that skip loading it
+     */
+
+    if (op->dry_run &&
+        (op->num_assignments || op->num_queries || op->num_monitors ||
+         op->no_load || op->rewrite)) {
+        nv_error_msg("The --dry-run option cannot be used with the --assign, "
+                     "--query, --monitor, --no-config or "
+                     "--rewrite-config-file options.  Please run `%s --help` "
+                     "for usage information.\n", argv[0]);
+        exit(0);
+    }
+
     /* do tilde expansion on the config file path */
 
     op->config = tilde_expansion(op->config);
@@ -28,8 +28,14 @@
 struct _CtrlSystemList;
 
 #define DEFAULT_RC_FILE "~/.nvidia-settings-rc"
+#define DEFAULT_MONITOR_INTERVAL 1000
 #define CONFIG_FILE_OPTION 1
 #define DISPLAY_OPTION 2
+#define MONITOR_OPTION 3
+#define MONITOR_INTERVAL_OPTION 4
+#define MONITOR_FORMAT_OPTION 5
+#define APP_PROFILE_MATCH_OPTION 6
+#define DRY_RUN_OPTION 7
 
 /*
  * Options structure -- stores the parameters specified on the
@@ -41,8 +47,20 @@ typedef struct {
     char *ctrl_display;  /*
                           * The name of the display to control
                           * (doesn't have to be the same as the
-                          * display on which the gui is shown
+                          * display on which the gui is shown;
+                          * the first one given with --ctrl-display
                           */
+
+    char **ctrl_displays; /*
+                           * Dynamically allocated array of all the
+                           * displays given with --ctrl-display; queries
+                           * and assignments are applied to each of them.
+                           */
+
+    int num_ctrl_displays; /*
+                            * Number of displays in the ctrl_displays
+                            * array.
+                            */
     
     char *config;        /*
                           * The name of the configuration file (to be
@@ -70,6 +88,26 @@ typedef struct {
                           * Number of query strings in the query
                           * array.
                           */
+
+    char **monitors;     /*
+                          * Dynamically allocated array of the lists of
+                          * attributes to sample, specified with
+                          * --monitor on the commandline.
+                          */
+
+    int num_monitors;    /*
+                          * Number of lists in the monitors array.
+                          */
+
+    int monitor_interval; /*
+                           * Time between two samples of the monitored
+                           * attributes, in milliseconds.
+                           */
+
+    int monitor_json;    /*
+                          * If true, print the monitored attributes as
+                          * newline-delimited JSON rather than CSV.
+                          */
     
     int only_load;       /*
                           * If true, just read the configuration file,
@@ -97,6 +135,12 @@ typedef struct {
                           * (from query/assign or rc file) and exit.
                           */
 
+    int dry_run;         /*
+                          * If true, print the assignments which loading
+                          * the configuration file would make, without
+                          * making them, and exit.
+                          */
+
     int terse;           /*
                           * If true, output minimal information to query
                           * operations.
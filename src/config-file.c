@@ -55,19 +55,22 @@ typedef struct {
     ParsedAttribute a;
     int line;
     CtrlSystem *system;
+    int resolved;   /* targets were resolved by plan_config_file() */
 } ParsedAttributeWrapper;
 
 
-static ParsedAttributeWrapper *parse_config_file(char *buf,
+static ParsedAttributeWrapper *parse_config_file(const char *buf,
                                                  const char *file,
                                                  const int length,
-                                                 ConfigProperties *);
+                                                 ConfigProperties *,
+                                                 ParserArena *arena);
 
 static int process_config_file_attributes(const Options *op,
                                           const char *file,
                                           ParsedAttributeWrapper *w,
                                           const char *display_name,
-                                          CtrlSystemList *system_list);
+                                          CtrlSystemList *system_list,
+                                          ParserArena *arena);
 
 static void save_gui_parsed_attributes(ParsedAttributeWrapper *w,
                                        ParsedAttribute *p);
@@ -127,6 +130,7 @@ int nv_read_config_file(const Options *op, const char *file,
     char *buf;
     char *locale;
     ParsedAttributeWrapper *w = NULL;
+    ParserArena *arena = NULL;
 
     if (!file) {
         /*
@@ -179,7 +183,9 @@ int nv_read_config_file(const Options *op, const char *file,
 
     locale = strdup(conf->locale);
 
-    w = parse_config_file(buf, file, length, conf);
+    arena = nv_parser_arena_new();
+
+    w = parse_config_file(buf, file, length, conf, arena);
 
     setlocale(LC_NUMERIC, locale);
     free(locale);
@@ -198,7 +204,8 @@ int nv_read_config_file(const Options *op, const char *file,
 
     /* process the parsed attributes */
 
-    ret = process_config_file_attributes(op, file, w, display_name, systems);
+    ret = process_config_file_attributes(op, file, w, display_name, systems,
+                                         arena);
 
     /*
      * add any relevant parsed attributes back to the list to be
@@ -208,7 +215,7 @@ int nv_read_config_file(const Options *op, const char *file,
     save_gui_parsed_attributes(w, p);
 
  done:
-    free(w);
+    nv_parser_arena_free(arena);
     close(fd);
 
     return ret;
@@ -217,6 +224,311 @@ int nv_read_config_file(const Options *op, const char *file,
 
 
 
+/*
+ * skip_config_file_entry() - returns whether the attribute table entry
+ * 'a' is left out of the integer attributes written to the configuration
+ * file: attributes that are not supposed to be written to the config
+ * file, and string attributes.
+ */
+
+static int skip_config_file_entry(const AttributeTableEntry *a)
+{
+    return a->flags.no_config_write ||
+        (a->type != CTRL_ATTRIBUTE_TYPE_INTEGER);
+}
+
+
+
+/*
+ * get_config_file_entries() - returns the indices in attributeTable of
+ * the integer attributes that are written to the configuration file for
+ * targets of the given type: the writable attributes valid for that
+ * target type, but for none of the target types in 'exclude_targets'.
+ *
+ * Attribute permissions do not depend on the target, so they are only
+ * looked up on the first target of the type.  The number of indices is
+ * returned in 'num_entries'; the caller should free the array with
+ * nvfree().
+ */
+
+static int *get_config_file_entries(const CtrlSystem *system,
+                                    CtrlTargetType target_type,
+                                    unsigned int exclude_targets,
+                                    int *num_entries)
+{
+    ReturnStatus status;
+    CtrlAttributePerms perms;
+    CtrlTargetNode *node;
+    CtrlTarget *t = NULL;
+    int entry, *entries, *attrs;
+    int num_attrs = 0;
+
+    *num_entries = 0;
+    entries = nvalloc(attributeTableLen * sizeof(int));
+
+    for (node = system->targets[target_type]; node; node = node->next) {
+        if (node->t->h) {
+            t = node->t;
+            break;
+        }
+    }
+
+    if (!t) {
+        return entries;
+    }
+
+    /* Fetch all the permissions needed below in one batch */
+
+    attrs = nvalloc(attributeTableLen * sizeof(int));
+
+    for (entry = 0; entry < attributeTableLen; entry++) {
+        if (!skip_config_file_entry(&attributeTable[entry])) {
+            attrs[num_attrs++] = attributeTable[entry].attr;
+        }
+    }
+
+    NvCtrlPrefetchAttributePerms(t, attrs, num_attrs);
+    nvfree(attrs);
+
+    for (entry = 0; entry < attributeTableLen; entry++) {
+        const AttributeTableEntry *a = &attributeTable[entry];
+
+        if (skip_config_file_entry(a)) {
+            continue;
+        }
+
+        status = NvCtrlGetAttributePerms(t, a->type, a->attr, &perms);
+        if (status != NvCtrlSuccess || !(perms.write) ||
+            !(perms.valid_targets & CTRL_TARGET_PERM_BIT(target_type)) ||
+            (perms.valid_targets & exclude_targets)) {
+            continue;
+        }
+
+        entries[(*num_entries)++] = entry;
+    }
+
+    return entries;
+
+} /* get_config_file_entries() */
+
+
+
+/*
+ * ConfigFileValues - the attribute values written to the configuration
+ * file for all the targets, queried as one batch before anything is
+ * written.  For each target, in the order the targets are written, the
+ * queries hold the NV_CTRL_ATTR_RANDR_GAMMA_AVAILABLE query if
+ * 'query_randr_gamma' was given to add_config_file_queries(), followed by
+ * the values of its config file entries.  'next' is the first query not
+ * consumed yet.
+ */
+
+typedef struct {
+    CtrlAttributeQuery *queries;
+    int count;
+    int next;
+} ConfigFileValues;
+
+static void add_config_file_queries(ConfigFileValues *values,
+                                    const CtrlSystem *system,
+                                    CtrlTargetType target_type,
+                                    const int *entries, int num_entries,
+                                    int query_randr_gamma)
+{
+    CtrlTargetNode *node;
+    int i;
+
+    for (node = system->targets[target_type]; node; node = node->next) {
+        CtrlTarget *t = node->t;
+        int num = num_entries + (query_randr_gamma ? 1 : 0);
+
+        if (!t->h) continue;
+
+        values->queries = nvrealloc(values->queries,
+                                    (values->count + num) *
+                                    sizeof(CtrlAttributeQuery));
+        memset(&values->queries[values->count], 0,
+               num * sizeof(CtrlAttributeQuery));
+
+        if (query_randr_gamma) {
+            values->queries[values->count].ctrl_target = t;
+            values->queries[values->count].attr =
+                NV_CTRL_ATTR_RANDR_GAMMA_AVAILABLE;
+            values->count++;
+        }
+
+        for (i = 0; i < num_entries; i++) {
+            values->queries[values->count].ctrl_target = t;
+            values->queries[values->count].attr =
+                attributeTable[entries[i]].attr;
+            values->count++;
+        }
+    }
+}
+
+/*
+ * next_config_file_value() - consumes the next query of 'values', and
+ * returns whether it succeeded, storing its value in 'val'.
+ */
+
+static int next_config_file_value(ConfigFileValues *values, int *val)
+{
+    const CtrlAttributeQuery *query;
+
+    if (values->next >= values->count) {
+        return NV_FALSE;
+    }
+
+    query = &values->queries[values->next++];
+    *val = (int) query->val;
+
+    return (query->status == NvCtrlSuccess);
+}
+
+
+
+/*
+ * config_file_unchanged() - returns whether the file 'filename' already
+ * holds the 'len' bytes of 'buf', not counting the "# Generated on"
+ * header line, which holds the time the file was written.
+ */
+
+#define GENERATED_ON_LINE "\n# Generated on "
+
+static int config_file_unchanged(const char *filename,
+                                 const char *buf, size_t len)
+{
+    FILE *fp;
+    struct stat stat_buf;
+    char *old;
+    const char *head, *old_head, *tail, *old_tail;
+    size_t old_len;
+    int ret = NV_FALSE;
+
+    fp = fopen(filename, "r");
+    if (!fp) {
+        return NV_FALSE;
+    }
+
+    /* The time stamp may differ in length by a few characters at most */
+
+    if ((fstat(fileno(fp), &stat_buf) == -1) ||
+        ((size_t) stat_buf.st_size > len + 64)) {
+        fclose(fp);
+        return NV_FALSE;
+    }
+
+    old = nvalloc(stat_buf.st_size + 1);
+    old_len = fread(old, 1, stat_buf.st_size, fp);
+    old[old_len] = '\0';
+    fclose(fp);
+
+    /* buf is NUL terminated by open_memstream(3) */
+
+    head = strstr(buf, GENERATED_ON_LINE);
+    old_head = strstr(old, GENERATED_ON_LINE);
+    tail = head ? strchr(head + 1, '\n') : NULL;
+    old_tail = old_head ? strchr(old_head + 1, '\n') : NULL;
+
+    if (tail && old_tail &&
+        (head - buf == old_head - old) &&
+        (memcmp(buf, old, head - buf) == 0) &&
+        (len - (tail - buf) == old_len - (old_tail - old)) &&
+        (memcmp(tail, old_tail, len - (tail - buf)) == 0)) {
+        ret = NV_TRUE;
+    }
+
+    nvfree(old);
+
+    return ret;
+
+} /* config_file_unchanged() */
+
+
+
+/*
+ * replace_config_file() - atomically replace the file 'filename' with
+ * the 'len' bytes of 'buf': the contents are written to a temporary file
+ * in the same directory, which is then renamed over 'filename', so that
+ * the file is never left partially written.  If 'filename' is a symbolic
+ * link, the file it points to is replaced.  The permissions of an
+ * existing file are preserved.
+ */
+
+static int replace_config_file(const char *filename,
+                               const char *buf, size_t len)
+{
+    struct stat stat_buf;
+    char *path, *tmp;
+    mode_t mode, mask;
+    size_t written = 0;
+    ssize_t n;
+    int fd, ret = NV_FALSE;
+
+    path = realpath(filename, NULL);
+    if (!path) {
+        path = nvstrdup(filename);
+    }
+
+    if (stat(path, &stat_buf) == 0) {
+        mode = stat_buf.st_mode & 07777;
+    } else {
+        mask = umask(0);
+        umask(mask);
+        mode = 0666 & ~mask;
+    }
+
+    tmp = nvasprintf("%s.XXXXXX", path);
+
+    fd = mkstemp(tmp);
+    if (fd == -1) {
+        nv_error_msg("Unable to open file '%s' for writing (%s).",
+                     tmp, strerror(errno));
+        goto done;
+    }
+
+    while (written < len) {
+        n = write(fd, buf + written, len - written);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        written += n;
+    }
+
+    if ((written < len) || (fchmod(fd, mode) == -1) || (fsync(fd) == -1)) {
+        nv_error_msg("Failure while writing file '%s' (%s).",
+                     tmp, strerror(errno));
+        close(fd);
+        unlink(tmp);
+        goto done;
+    }
+
+    if (close(fd) == -1) {
+        nv_error_msg("Failure while closing file '%s'.", tmp);
+        unlink(tmp);
+        goto done;
+    }
+
+    if (rename(tmp, path) == -1) {
+        nv_error_msg("Unable to replace file '%s' (%s).",
+                     path, strerror(errno));
+        unlink(tmp);
+        goto done;
+    }
+
+    ret = NV_TRUE;
+
+ done:
+    nvfree(tmp);
+    nvfree(path);
+
+    return ret;
+
+} /* replace_config_file() */
+
+
+
 /*
  * nv_write_config_file() - write a configuration file to the
  * specified filename.
@@ -224,8 +536,11 @@ int nv_read_config_file(const Options *op, const char *file,
  * XXX how should this be handled?  Currently, we just query all
  * writable attributes, writing their current value to file.
  *
- * XXX should query first, and only once we know we can't fail, then
- * write the file (to avoid deleting the existing file).
+ * The attribute permissions are queried once per target type, and the
+ * values of all the targets in a single batch.  The file is built in
+ * memory and only then replaced atomically, so that a failure cannot
+ * leave it truncated; it is not rewritten if its contents would not
+ * change.
  */
 
 int nv_write_config_file(const char *filename, const CtrlSystem *system,
@@ -233,25 +548,60 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
 {
     int ret, entry, val, randr_gamma_available;
     FILE *stream;
+    char *buf = NULL;
+    size_t len = 0;
     time_t now;
     ReturnStatus status;
-    CtrlAttributePerms perms;
     CtrlTargetNode *node;
     CtrlTarget *t;
     char *prefix, scratch[4];
     char *locale = "C";
+    int *screen_entries, *display_entries, *gpu_entries;
+    int num_screen_entries, num_display_entries, num_gpu_entries;
+    ConfigFileValues values;
+    int i;
 
     if (!filename) {
         nv_error_msg("Unable to open configuration file for writing.");
         return NV_FALSE;
     }
 
-    stream = fopen(filename, "w");
+    stream = open_memstream(&buf, &len);
     if (!stream) {
         nv_error_msg("Unable to open file '%s' for writing.", filename);
         return NV_FALSE;
     }
-    
+
+    /*
+     * Gather the attributes written for each target type, then query
+     * their values on all the targets at once: X screen attributes that
+     * are also valid for display targets are written with the display
+     * targets instead.
+     */
+
+    screen_entries =
+        get_config_file_entries(system, X_SCREEN_TARGET,
+                                CTRL_TARGET_PERM_BIT(DISPLAY_TARGET),
+                                &num_screen_entries);
+    display_entries =
+        get_config_file_entries(system, DISPLAY_TARGET, 0,
+                                &num_display_entries);
+    gpu_entries =
+        get_config_file_entries(system, GPU_TARGET, 0, &num_gpu_entries);
+
+    memset(&values, 0, sizeof(values));
+
+    add_config_file_queries(&values, system, X_SCREEN_TARGET,
+                            screen_entries, num_screen_entries, NV_TRUE);
+    add_config_file_queries(&values, system, DISPLAY_TARGET,
+                            display_entries, num_display_entries, NV_TRUE);
+    add_config_file_queries(&values, system, GPU_TARGET,
+                            gpu_entries, num_gpu_entries, NV_FALSE);
+
+    if (values.count) {
+        NvCtrlGetAttributesBatch(values.queries, values.count);
+    }
+
     /* write header */
     
     now = time(NULL);
@@ -295,6 +645,8 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
      */
 
     for (node = system->targets[X_SCREEN_TARGET]; node; node = node->next) {
+        float c[3], b[3], g[3];
+        int have_color = NV_FALSE;
 
         t = node->t;
 
@@ -316,19 +668,20 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
             prefix = scratch;
         }
 
-        /* loop over all the entries in the table */
+        /*
+         * if we are using RandR gamma, skip saving the color info
+         */
 
-        for (entry = 0; entry < attributeTableLen; entry++) {
-            const AttributeTableEntry *a = &attributeTable[entry];
+        if (!next_config_file_value(&values, &randr_gamma_available) ||
+            !randr_gamma_available) {
+            status = NvCtrlGetColorAttributes(t, c, b, g);
+            have_color = (status == NvCtrlSuccess);
+        }
 
-            /*
-             * skip all attributes that are not supposed to be written
-             * to the config file
-             */
+        /* loop over all the entries in the table */
 
-            if (a->flags.no_config_write) {
-                continue;
-            }
+        for (entry = 0, i = 0; entry < attributeTableLen; entry++) {
+            const AttributeTableEntry *a = &attributeTable[entry];
 
             /*
              * special case the color attributes because we want to
@@ -336,46 +689,26 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
              */
 
             if (a->type == CTRL_ATTRIBUTE_TYPE_COLOR) {
-                float c[3], b[3], g[3];
-
-                /*
-                 * if we are using RandR gamma, skip saving the color info
-                 */
-
-                status = NvCtrlGetAttribute(t,
-                                            NV_CTRL_ATTR_RANDR_GAMMA_AVAILABLE,
-                                            &val);
-                if (status == NvCtrlSuccess && val) continue;
+                if (a->flags.no_config_write || !have_color) continue;
 
-                status = NvCtrlGetColorAttributes(t, c, b, g);
-                if (status != NvCtrlSuccess) continue;
                 fprintf(stream, "%s%c%s=%f\n",
                         prefix, DISPLAY_NAME_SEPARATOR, a->name,
                         get_color_value(a->attr, c, b, g));
                 continue;
             }
 
-            /* Only write out integer attributes, string attributes
-             * aren't written here.
-             */
-            if (a->type != CTRL_ATTRIBUTE_TYPE_INTEGER) {
-                continue;
-            }
-
             /*
-             * Ignore display attributes (they are written later on) and only
-             * write attributes that can be written for an X screen target
+             * Only write out the integer attributes that can be written
+             * for an X screen target; display attributes are written later
+             * on.
              */
 
-            status = NvCtrlGetAttributePerms(t, a->type, a->attr, &perms);
-            if (status != NvCtrlSuccess || !(perms.write) ||
-                !(perms.valid_targets & CTRL_TARGET_PERM_BIT(X_SCREEN_TARGET)) ||
-                (perms.valid_targets & CTRL_TARGET_PERM_BIT(DISPLAY_TARGET))) {
+            if ((i >= num_screen_entries) || (screen_entries[i] != entry)) {
                 continue;
             }
+            i++;
 
-            status = NvCtrlGetAttribute(t, a->attr, &val);
-            if (status != NvCtrlSuccess) {
+            if (!next_config_file_value(&values, &val)) {
                 continue;
             }
 
@@ -400,6 +733,8 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
      */
 
     for (node = system->targets[DISPLAY_TARGET]; node; node = node->next) {
+        float c[3], b[3], g[3];
+        int have_color = NV_FALSE;
 
         t = node->t;
 
@@ -412,42 +747,30 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
          * skip writing attributes if it is missing. 
          */
 
-        status = NvCtrlGetAttribute(t, 
-                                    NV_CTRL_ATTR_RANDR_GAMMA_AVAILABLE,
-                                    &randr_gamma_available);
-        if (status != NvCtrlSuccess) {
+        if (!next_config_file_value(&values, &randr_gamma_available)) {
             randr_gamma_available = 0;
         }
 
+        if (randr_gamma_available) {
+            status = NvCtrlGetColorAttributes(t, c, b, g);
+            have_color = (status == NvCtrlSuccess);
+        }
+
         /* Get the prefix we want to use for the display device target */
 
         prefix = create_display_device_target_string(t, conf);
 
         /* loop over all the entries in the table */
 
-        for (entry = 0; entry < attributeTableLen; entry++) {
+        for (entry = 0, i = 0; entry < attributeTableLen; entry++) {
             const AttributeTableEntry *a = &attributeTable[entry];
 
-            /*
-             * skip all attributes that are not supposed to be written
-             * to the config file
-             */
-
-            if (a->flags.no_config_write) {
-                continue;
-            }
-
             /*
              * for the display target we only write color attributes for now
              */
 
             if (a->type == CTRL_ATTRIBUTE_TYPE_COLOR) {
-                float c[3], b[3], g[3];
-
-                if (!randr_gamma_available) continue;
-
-                status = NvCtrlGetColorAttributes(t, c, b, g);
-                if (status != NvCtrlSuccess) continue;
+                if (a->flags.no_config_write || !have_color) continue;
 
                 fprintf(stream, "%s%c%s=%f\n",
                         prefix, DISPLAY_NAME_SEPARATOR, a->name,
@@ -455,23 +778,14 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
                 continue;
             }
 
-            /* Only write out integer attributes, string attributes
-             * aren't written here.
-             */
-            if (a->type != CTRL_ATTRIBUTE_TYPE_INTEGER) {
-                continue;
-            }
-
             /* Make sure this is a display and writable attribute */
 
-            status = NvCtrlGetAttributePerms(t, a->type, a->attr, &perms);
-            if (status != NvCtrlSuccess || !(perms.write) ||
-                !(perms.valid_targets & CTRL_TARGET_PERM_BIT(DISPLAY_TARGET))) {
+            if ((i >= num_display_entries) || (display_entries[i] != entry)) {
                 continue;
             }
+            i++;
 
-            status = NvCtrlGetAttribute(t, a->attr, &val);
-            if (status == NvCtrlSuccess) {
+            if (next_config_file_value(&values, &val)) {
                 fprintf(stream, "%s%c%s=%d\n", prefix,
                         DISPLAY_NAME_SEPARATOR, a->name, val);
             }
@@ -503,39 +817,14 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
         target_str = nvasprintf("[gpu:%d]", NvCtrlGetTargetId(t));
         nvstrtoupper(target_str);
 
-        /* loop over all the entries in the table */
-
-        for (entry = 0; entry < attributeTableLen; entry++) {
-            const AttributeTableEntry *a = &attributeTable[entry];
-
-            /*
-             * skip all attributes that are not supposed to be written
-             * to the config file
-             */
-
-            if (a->flags.no_config_write) {
-                continue;
-            }
-
-            /* Only write out integer attributes, string attributes
-             * aren't written here.
-             */
-            if (a->type != CTRL_ATTRIBUTE_TYPE_INTEGER) {
-                continue;
-            }
-
-            /*
-             * Only write attributes that can be written for a GPU target
-             */
+        /*
+         * Only write attributes that can be written for a GPU target
+         */
 
-            status = NvCtrlGetAttributePerms(t, a->type, a->attr, &perms);
-            if (status != NvCtrlSuccess || !(perms.write) ||
-                !(perms.valid_targets & CTRL_TARGET_PERM_BIT(GPU_TARGET)))  {
-                continue;
-            }
+        for (i = 0; i < num_gpu_entries; i++) {
+            const AttributeTableEntry *a = &attributeTable[gpu_entries[i]];
 
-            status = NvCtrlGetAttribute(t, a->attr, &val);
-            if (status != NvCtrlSuccess) {
+            if (!next_config_file_value(&values, &val)) {
                 continue;
             }
 
@@ -546,6 +835,11 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
         free(target_str);
     }
 
+    nvfree(values.queries);
+    nvfree(screen_entries);
+    nvfree(display_entries);
+    nvfree(gpu_entries);
+
     /*
      * loop the ParsedAttribute list, writing the attributes to file.
      * note that we ignore conf->include_display_name_in_config_file
@@ -601,15 +895,27 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
 
     setlocale(LC_NUMERIC, conf->locale);
 
-    /* close the configuration file */
+    /* close the in-memory stream */
 
     ret = fclose(stream);
     if (ret != 0) {
-        nv_error_msg("Failure while closing file '%s'.", filename);
+        nv_error_msg("Failure while writing configuration file '%s'.",
+                     filename);
+        free(buf);
         return NV_FALSE;
     }
-    
-    return NV_TRUE;
+
+    /* write the configuration file, unless it would not change */
+
+    ret = NV_TRUE;
+
+    if (!config_file_unchanged(filename, buf, len)) {
+        ret = replace_config_file(filename, buf, len);
+    }
+
+    free(buf);
+
+    return ret;
     
 } /* nv_write_config_file() */
 
@@ -618,105 +924,414 @@ int nv_write_config_file(const char *filename, const CtrlSystem *system,
 /*
  * parse_config_file() - scan through the buffer; skipping comment
  * lines.  Non-comment lines with non-whitespace characters are passed
- * on to nv_parse_attribute_string for parsing.
+ * on to nv_parse_attribute_slice for parsing.
+ *
+ * The lines are parsed in place, and the parsed attributes and their
+ * strings are allocated from 'arena', so that parsing a large file
+ * costs a few large allocations rather than several per line.
  *
  * If an error occurs, an error message is printed and NULL is
- * returned.  If successful, a malloced array of
- * ParsedAttributeWrapper structs is returned.  The last
- * ParsedAttributeWrapper in the array has line == -1.  It is the
- * caller's responsibility to free the array.
+ * returned.  If successful, an array of ParsedAttributeWrapper structs,
+ * allocated from 'arena', is returned.  The last
+ * ParsedAttributeWrapper in the array has line == -1.
  */
 
-static ParsedAttributeWrapper *parse_config_file(char *buf, const char *file,
+static ParsedAttributeWrapper *parse_config_file(const char *buf,
+                                                 const char *file,
                                                  const int length,
-                                                 ConfigProperties *conf)
+                                                 ConfigProperties *conf,
+                                                 ParserArena *arena)
 {
-    int line, has_data, current_tmp_len, len, n, ret;
-    char *cur, *c, *comment, *tmp;
+    int line, len, n, ret, num_lines, current_tmp_len;
+    const char *cur, *end, *eol, *comment, *equal_sign, *c;
+    char *tmp;
     ParsedAttributeWrapper *w;
-    
-    cur = buf;
-    line = 1;
-    current_tmp_len = 0;
+
+    /* the text ends at the first NUL character, if any */
+
+    end = memchr(buf, '\0', length);
+    if (!end) end = buf + length;
+
+    /* size the array from the number of lines */
+
+    num_lines = 1;
+    for (c = buf; (c = memchr(c, '\n', end - c)) != NULL; c++) {
+        num_lines++;
+    }
+
+    w = nv_parser_arena_alloc(arena,
+                              sizeof(ParsedAttributeWrapper) * (num_lines + 1));
+
     n = 0;
-    w = NULL;
     tmp = NULL;
+    current_tmp_len = 0;
+
+    for (cur = buf, line = 1; cur;
+         cur = (eol < end) ? eol + 1 : NULL, line++) {
+
+        eol = memchr(cur, '\n', end - cur);
+        if (!eol) eol = end;
+
+        comment = memchr(cur, '#', eol - cur);
+        if (!comment) comment = eol;
+
+        /* skip lines without data */
+
+        for (c = cur; (c < comment) && isspace(*c); c++);
+        if (c == comment) continue;
+
+        len = comment - cur;
+
+        /*
+         * first, see if this line is a config property; these never have
+         * a display name, so only the lines without one need to be
+         * copied and checked
+         */
+
+        equal_sign = memchr(cur, '=', len);
+        if (!memchr(cur, DISPLAY_NAME_SEPARATOR,
+                    (equal_sign ? equal_sign : comment) - cur)) {
 
-    while (cur) {
-        c = cur;
-        comment = NULL;
-        has_data = NV_FALSE;;
-        
-        while (((c - buf) < length) &&
-               (*c != '\n') &&
-               (*c != '\0')) {
-            if (comment) { c++; continue; }
-            if (*c == '#') { comment = c; continue; }
-            if (!isspace(*c)) has_data = NV_TRUE;
-            c++;
-        }
-        
-        if (has_data) {
-            if (!comment) comment = c;
-            len = comment - cur;
-            
             /* grow the tmp buffer if it's too small */
-            
+
             if (len >= current_tmp_len) {
                 current_tmp_len = len + 1;
-                if (tmp) {
-                    free(tmp);
-                }
+                free(tmp);
                 tmp = nvalloc(sizeof(char) * current_tmp_len);
             }
 
-            strncpy (tmp, cur, len);
+            strncpy(tmp, cur, len);
             tmp[len] = '\0';
 
-            /* first, see if this line is a config property */
-
-            if (!parse_config_property(file, tmp, conf)) {
-                
-                w = nvrealloc(w, sizeof(ParsedAttributeWrapper) * (n+1));
-            
-                ret = nv_parse_attribute_string(tmp,
-                                                NV_PARSER_ASSIGNMENT,
-                                                &w[n].a);
-                if (ret != NV_PARSER_STATUS_SUCCESS) {
-                    nv_error_msg("Error parsing configuration file '%s' on "
-                                 "line %d: '%s' (%s).",
-                                 file, line, tmp, nv_parse_strerror(ret));
-                    goto failed;
-                }
-            
-                w[n].line = line;
-                n++;
+            if (parse_config_property(file, tmp, conf)) {
+                continue;
             }
         }
 
-        if (((c - buf) >= length) || (*c == '\0')) cur = NULL;
-        else cur = c + 1;
+        ret = nv_parse_attribute_slice(cur, len, NV_PARSER_ASSIGNMENT,
+                                       &w[n].a, arena);
+        if (ret != NV_PARSER_STATUS_SUCCESS) {
+            nv_error_msg("Error parsing configuration file '%s' on "
+                         "line %d: '%.*s' (%s).",
+                         file, line, len, cur, nv_parse_strerror(ret));
+            free(tmp);
+            return NULL;
+        }
 
-        line++;
+        w[n].line = line;
+        n++;
     }
+
     free(tmp);
+
     /* mark the end of the array */
 
-    w = nvrealloc(w, sizeof(ParsedAttributeWrapper) * (n+1));
     w[n].line = -1;
     
     return w;
 
- failed:
-    if (w) free(w);
-    free(tmp);
-    return NULL;
-
 } /* parse_config_file() */
 
 
 
 
+/*
+ * Planning of the assignments of a configuration file.  Generated and
+ * hand-merged files often assign the same attribute to the same target
+ * several times, e.g. on all X screens and then on one; only the last of
+ * these assignments has any effect, so the others are dropped before
+ * anything is sent to the X server.
+ *
+ * Assignments are identified by their target, the display device mask
+ * for attributes that hijack it, and the attribute table entry.
+ */
+
+typedef struct {
+    const CtrlTarget *t;
+    uint32 mask;
+    const AttributeTableEntry *a;
+} ConfigFileWrite;
+
+
+
+/*
+ * can_supersede() - returns whether assignments of the attribute 'a' can
+ * be dropped when a later line assigns it again.  This is not the case
+ * for assignments with side effects (string operations), or depending on
+ * the state left by other lines (frame lock attributes), and for the
+ * attributes that are handed over to the GUI, which applies them itself.
+ */
+
+static int can_supersede(const AttributeTableEntry *a)
+{
+    if ((a->type == CTRL_ATTRIBUTE_TYPE_STRING_OPERATION) ||
+        a->flags.is_framelock_attribute ||
+        a->flags.is_gui_attribute) {
+        return NV_FALSE;
+    }
+
+    if ((a->type == CTRL_ATTRIBUTE_TYPE_INTEGER) &&
+        a->f.int_flags.is_display_id) {
+        return NV_FALSE;
+    }
+
+    return NV_TRUE;
+}
+
+
+
+/*
+ * add_config_file_write() - adds 'write' to the open addressing table
+ * 'table' of 'size' entries (a power of two, larger than the number of
+ * writes added to it); returns NV_FALSE if it was already there.
+ */
+
+static int add_config_file_write(ConfigFileWrite *table, unsigned int size,
+                                 const ConfigFileWrite *write)
+{
+    unsigned int i;
+
+    i = (unsigned int) (((uintptr_t) write->t >> 4) * 31 +
+                        ((uintptr_t) write->a >> 4)) * 31 + write->mask;
+
+    for (i &= size - 1; table[i].t; i = (i + 1) & (size - 1)) {
+        if ((table[i].t == write->t) && (table[i].a == write->a) &&
+            (table[i].mask == write->mask)) {
+            return NV_FALSE;
+        }
+    }
+
+    table[i] = *write;
+
+    return NV_TRUE;
+}
+
+
+
+static int compare_ints(const void *a, const void *b)
+{
+    return *(const int *) a - *(const int *) b;
+}
+
+
+
+/*
+ * prefetch_config_file_perms() - resolving the targets of an attribute
+ * looks up its permissions on the default target of its system; look up
+ * those of all the integer attributes of the file in one batch per
+ * system instead.
+ */
+
+static void prefetch_config_file_perms(ParsedAttributeWrapper *w)
+{
+    CtrlSystem **systems;
+    CtrlTarget *ctrl_target;
+    int *attrs;
+    int i, j, n, m, count, num_systems = 0;
+
+    for (count = 0; w[count].line != -1; count++);
+
+    systems = nvalloc(count * sizeof(CtrlSystem *));
+    attrs = nvalloc(count * sizeof(int));
+
+    for (i = 0; i < count; i++) {
+        CtrlSystem *system = w[i].system;
+
+        if (!system) {
+            continue;
+        }
+
+        for (j = 0; j < num_systems; j++) {
+            if (systems[j] == system) {
+                break;
+            }
+        }
+        if (j < num_systems) {
+            continue;
+        }
+        systems[num_systems++] = system;
+
+        /* gather the distinct integer attributes assigned on this system */
+
+        for (n = 0, j = i; j < count; j++) {
+            if ((w[j].system == system) &&
+                (w[j].a.attr_entry->type == CTRL_ATTRIBUTE_TYPE_INTEGER)) {
+                attrs[n++] = w[j].a.attr_entry->attr;
+            }
+        }
+
+        qsort(attrs, n, sizeof(int), compare_ints);
+
+        for (j = 1, m = n ? 1 : 0; j < n; j++) {
+            if (attrs[j] != attrs[m - 1]) {
+                attrs[m++] = attrs[j];
+            }
+        }
+
+        /* this is the target on which the permissions are looked up */
+
+        ctrl_target = NULL;
+        if (system->has_nvml) {
+            ctrl_target = NvCtrlGetDefaultTargetByType(system, GPU_TARGET);
+        }
+        if (!ctrl_target) {
+            ctrl_target = NvCtrlGetDefaultTarget(system);
+        }
+
+        if (ctrl_target && m) {
+            NvCtrlPrefetchAttributePerms(ctrl_target, attrs, m);
+        }
+    }
+
+    nvfree(attrs);
+    nvfree(systems);
+}
+
+
+
+/*
+ * plan_config_file() - resolves the targets of each parsed attribute
+ * ahead of processing, and removes from them the targets that a later
+ * line assigns the same attribute to.  A line left without targets is
+ * not processed.  Lines whose targets cannot be resolved are left
+ * unresolved, so that nv_process_parsed_attribute() reports the error.
+ *
+ * The number of assignments (one per target) is returned in
+ * 'num_writes', and the number of those that were dropped in
+ * 'num_superseded'.
+ */
+
+static void plan_config_file(const char *file, ParsedAttributeWrapper *w,
+                             int *num_writes, int *num_superseded)
+{
+    ConfigFileWrite *table;
+    CtrlTargetNode **prev, *node;
+    unsigned int size;
+    char *whence;
+    int i, count;
+
+    *num_writes = 0;
+    *num_superseded = 0;
+
+    prefetch_config_file_perms(w);
+
+    for (count = 0; w[count].line != -1; count++) {
+        const AttributeTableEntry *a = w[count].a.attr_entry;
+
+        if (!w[count].system ||
+            (strncmp(a->desc, "NOT SUPPORTED", 13) == 0)) {
+            continue;
+        }
+
+        whence = nvasprintf("on line %d of configuration file '%s'",
+                            w[count].line, file);
+
+        if (nv_resolve_parsed_attribute_targets(&w[count].a, w[count].system,
+                                                whence) ==
+            NV_PARSER_STATUS_SUCCESS) {
+            w[count].resolved = NV_TRUE;
+            for (node = w[count].a.targets; node; node = node->next) {
+                (*num_writes)++;
+            }
+        }
+
+        nvfree(whence);
+    }
+
+    /* walk the lines backwards, keeping the first write of each key seen */
+
+    for (size = 16; size < 2 * (unsigned int) *num_writes; size <<= 1);
+    table = nvalloc(size * sizeof(ConfigFileWrite));
+
+    for (i = count - 1; i >= 0; i--) {
+        ParsedAttribute *p = &w[i].a;
+
+        if (!w[i].resolved || !can_supersede(p->attr_entry)) {
+            continue;
+        }
+
+        prev = &p->targets;
+
+        while ((node = *prev)) {
+            ConfigFileWrite write;
+
+            write.t = node->t;
+            write.a = p->attr_entry;
+            write.mask = p->attr_entry->flags.hijack_display_device ?
+                p->display_device_mask : 0;
+
+            if (add_config_file_write(table, size, &write)) {
+                prev = &node->next;
+            } else {
+                *prev = node->next;
+                free(node);
+                (*num_superseded)++;
+            }
+        }
+    }
+
+    nvfree(table);
+}
+
+
+
+/*
+ * print_config_file_plan() - prints the assignments which loading the
+ * configuration file would make, for --dry-run.
+ */
+
+static void print_config_file_plan(const char *file,
+                                   const ParsedAttributeWrapper *w,
+                                   int num_writes, int num_superseded)
+{
+    CtrlTargetNode *node;
+    char value[64];
+    int i;
+
+    nv_msg(NULL, "Assignments from configuration file '%s':", file);
+
+    for (i = 0; w[i].line != -1; i++) {
+        const ParsedAttribute *p = &w[i].a;
+        const AttributeTableEntry *a = p->attr_entry;
+        const char *str = value;
+
+        switch (a->type) {
+        case CTRL_ATTRIBUTE_TYPE_INTEGER:
+            if (a->f.int_flags.is_display_id) {
+                str = p->val.str;
+            } else if (a->f.int_flags.is_packed) {
+                snprintf(value, sizeof(value), "%d,%d",
+                         p->val.i >> 16, p->val.i & 0xffff);
+            } else {
+                snprintf(value, sizeof(value), "%d", p->val.i);
+            }
+            break;
+        case CTRL_ATTRIBUTE_TYPE_COLOR:
+            snprintf(value, sizeof(value), "%f", p->val.f);
+            break;
+        default:
+            str = p->val.str;
+            break;
+        }
+
+        if (!w[i].resolved) {
+            nv_msg(TAB, "line %d: '%s' = %s (targets not resolved)",
+                   w[i].line, a->name, str);
+            continue;
+        }
+
+        for (node = p->targets; node; node = node->next) {
+            nv_msg(TAB, "line %d: '%s' on %s = %s",
+                   w[i].line, a->name, node->t->name, str);
+        }
+    }
+
+    nv_msg(NULL, "%d of %d assignments are overridden by later lines and "
+           "would be skipped.", num_superseded, num_writes);
+}
+
+
+
 /*
  * process_config_file_attributes() - process the list of
  * attributes to be assigned that we acquired in parsing the config
@@ -727,10 +1342,11 @@ static int process_config_file_attributes(const Options *op,
                                           const char *file,
                                           ParsedAttributeWrapper *w,
                                           const char *display_name,
-                                          CtrlSystemList *systems)
+                                          CtrlSystemList *systems,
+                                          ParserArena *arena)
 {
-    int i;
-    
+    int i, num_writes, num_superseded;
+
     NvVerbosity old_verbosity = nv_get_verbosity();
 
     /* Override the verbosity in the default behavior so
@@ -742,23 +1358,63 @@ static int process_config_file_attributes(const Options *op,
 
     /*
      * make sure that all ParsedAttributes have displays (this will do
-     * nothing if we already have a display name
+     * nothing if we already have a display name); the default display
+     * name is interned like the others
      */
 
     for (i = 0; w[i].line != -1; i++) {
-        nv_assign_default_display(&w[i].a, display_name);
+        if (!w[i].a.parser_flags.has_x_display) {
+            w[i].a.display = display_name ?
+                nv_parser_arena_intern(arena, display_name,
+                                       strlen(display_name)) : NULL;
+            w[i].a.parser_flags.has_x_display = NV_TRUE;
+        }
+        nv_assign_default_display(&w[i].a, NULL);
     }
 
-    /* connect to all the systems referenced in the config file */
+    /*
+     * connect to all the systems referenced in the config file; as the
+     * display names are interned, lines naming the same display as the
+     * previous one share its display name pointer
+     */
 
     for (i = 0; w[i].line != -1; i++) {
-        w[i].system = NvCtrlConnectToSystem(w[i].a.display, systems);
+        if ((i > 0) && (w[i].a.display == w[i - 1].a.display)) {
+            w[i].system = w[i - 1].system;
+        } else {
+            w[i].system = NvCtrlConnectToSystem(w[i].a.display, systems);
+        }
     }
 
-    /* now process each attribute, passing in the correct system */
+    /*
+     * resolve the targets of each line, and drop the assignments that
+     * later lines override
+     */
+
+    plan_config_file(file, w, &num_writes, &num_superseded);
+
+    if (op->dry_run) {
+        print_config_file_plan(file, w, num_writes, num_superseded);
+        goto done;
+    }
+
+    /*
+     * now process each attribute, passing in the correct system; runs of
+     * integer assignments are sent to the X server in batches
+     */
+
+    if (!op->list_targets) {
+        nv_start_assignment_batch();
+    }
 
     for (i = 0; w[i].line != -1; i++) {
 
+        /* every target of this line is assigned again further down */
+
+        if (w[i].resolved && !w[i].a.targets) {
+            continue;
+        }
+
         nv_process_parsed_attribute(op, &w[i].a, w[i].system, NV_TRUE, NV_FALSE,
                                     "on line %d of configuration file "
                                     "'%s'", w[i].line, file);
@@ -770,7 +1426,11 @@ static int process_config_file_attributes(const Options *op,
          * control to force stereo)
          */
     }
-    
+
+    nv_end_assignment_batch();
+
+ done:
+
     /* Reset the default verbosity */
 
     if (__dynamic_verbosity) {
@@ -797,7 +1457,17 @@ static void save_gui_parsed_attributes(ParsedAttributeWrapper *w,
     for (i = 0; w[i].line != -1; i++) {
         ParsedAttribute *p = &(w[i].a);
         if (p->attr_entry->flags.is_gui_attribute) {
-            nv_parsed_attribute_add(p_list, p);
+            /*
+             * The list takes ownership of the target specification, which
+             * was allocated from the parser arena
+             */
+            ParsedAttribute copy = *p;
+
+            if (copy.target_specification) {
+                copy.target_specification =
+                    nvstrdup(copy.target_specification);
+            }
+            nv_parsed_attribute_add(p_list, &copy);
         }
     }
 }
@@ -257,6 +257,11 @@ static void app_profile_finalize(GObject *object)
     ctk_help_data_list_free_full(ctk_app_profile->profiles_help_data);
     ctk_help_data_list_free_full(ctk_app_profile->profiles_columns_help_data);
     ctk_help_data_list_free_full(ctk_app_profile->save_reload_help_data);
+
+    if (ctk_app_profile->watch_source) {
+        g_source_remove(ctk_app_profile->watch_source);
+    }
+    nv_app_profile_config_watch_free(ctk_app_profile->watch);
 }
 
 static void tool_button_set_label_and_stock_icon(GtkToolButton *button, const gchar *label_text, const gchar *icon_id)
@@ -3810,19 +3815,6 @@ static GtkWidget* create_profiles_page(CtkAppProfile *ctk_app_profile)
     return vbox;
 }
 
-static char *get_default_global_config_file(void)
-{
-    const char *homeStr = getenv("HOME");
-    if (homeStr) {
-        return nvstrcat(homeStr, "/.nv/nvidia-application-profile-globals-rc", NULL);
-    } else {
-        nv_error_msg("The environment variable HOME is not set. Any "
-                     "modifications to global application profile settings "
-                     "will not be saved.");
-        return NULL;
-    }
-}
-
 static char *get_default_keys_file(const char *driver_version)
 {
     char *file = NULL;
@@ -3867,35 +3859,6 @@ static char *get_default_keys_file(const char *driver_version)
     }
 }
 
-#define SEARCH_PATH_NUM_FILES 4
-
-static char **get_default_search_path(size_t *num_files)
-{
-    size_t i = 0;
-    char **filenames = malloc(SEARCH_PATH_NUM_FILES * sizeof(char *));
-    const char *homeStr = getenv("HOME");
-
-    if (homeStr) {
-        filenames[i++] = nvstrcat(homeStr, "/.nv/nvidia-application-profiles-rc", NULL);
-        filenames[i++] = nvstrcat(homeStr, "/.nv/nvidia-application-profiles-rc.d", NULL);
-    }
-    filenames[i++] = strdup("/etc/nvidia/nvidia-application-profiles-rc");
-    filenames[i++] = strdup("/etc/nvidia/nvidia-application-profiles-rc.d");
-
-    *num_files = i;
-    assert(i <= SEARCH_PATH_NUM_FILES);
-
-    return filenames;
-}
-
-static void free_search_path(char **search_path, size_t search_path_size)
-{
-    while (search_path_size--) {
-        free(search_path[search_path_size]);
-    }
-    free(search_path);
-}
-
 static void app_profile_load_global_settings(CtkAppProfile *ctk_app_profile,
                                              AppProfileConfig *config)
 {
@@ -3912,6 +3875,13 @@ static void app_profile_load_global_settings(CtkAppProfile *ctk_app_profile,
         ~CTK_CONFIG_PENDING_WRITE_APP_PROFILES;
 }
 
+static void app_profile_attach_config(CtkAppProfile *ctk_app_profile)
+{
+    ctk_apc_profile_model_attach(ctk_app_profile->apc_profile_model, ctk_app_profile->cur_config);
+    ctk_apc_rule_model_attach(ctk_app_profile->apc_rule_model, ctk_app_profile->cur_config);
+    app_profile_load_global_settings(ctk_app_profile, ctk_app_profile->cur_config);
+}
+
 static void app_profile_reload(CtkAppProfile *ctk_app_profile)
 {
     char *global_config_file;
@@ -3921,18 +3891,67 @@ static void app_profile_reload(CtkAppProfile *ctk_app_profile)
     nv_app_profile_config_free(ctk_app_profile->cur_config);
     nv_app_profile_config_free(ctk_app_profile->gold_config);
 
-    search_path = get_default_search_path(&search_path_size);
-    global_config_file = get_default_global_config_file();
+    search_path = nv_app_profile_get_default_search_path(&search_path_size);
+    global_config_file = nv_app_profile_get_default_global_config_file();
     ctk_app_profile->gold_config = nv_app_profile_config_load(global_config_file,
                                                               search_path,
                                                               search_path_size);
     ctk_app_profile->cur_config = nv_app_profile_config_dup(ctk_app_profile->gold_config);
-    free_search_path(search_path, search_path_size);
+    nv_app_profile_free_search_path(search_path, search_path_size);
     free(global_config_file);
 
-    ctk_apc_profile_model_attach(ctk_app_profile->apc_profile_model, ctk_app_profile->cur_config);
-    ctk_apc_rule_model_attach(ctk_app_profile->apc_rule_model, ctk_app_profile->cur_config);
-    app_profile_load_global_settings(ctk_app_profile, ctk_app_profile->cur_config);
+    // Changes made so far, including our own writes, are now loaded
+    if (ctk_app_profile->watch) {
+        json_decref(nv_app_profile_config_watch_read_changes(ctk_app_profile->watch));
+    }
+
+    app_profile_attach_config(ctk_app_profile);
+}
+
+/*
+ * Called when configuration files change on disk: if there are no unsaved
+ * changes, only the files which changed are reloaded. Otherwise, the
+ * configuration is left alone, and the conflict is reported by
+ * nv_app_profile_config_check_backing_files() when saving or reloading.
+ */
+static gboolean config_files_changed(GIOChannel *source,
+                                     GIOCondition condition,
+                                     gpointer user_data)
+{
+    CtkAppProfile *ctk_app_profile = CTK_APP_PROFILE(user_data);
+    json_t *changes, *updates;
+    size_t i;
+
+    changes = nv_app_profile_config_watch_read_changes(ctk_app_profile->watch);
+
+    if (json_array_size(changes) == 0) {
+        json_decref(changes);
+        return TRUE;
+    }
+
+    updates = nv_app_profile_config_validate(ctk_app_profile->cur_config,
+                                             ctk_app_profile->gold_config);
+
+    if (json_array_size(updates) == 0) {
+        for (i = 0; i < json_array_size(changes); i++) {
+            nv_app_profile_config_reload_file(ctk_app_profile->gold_config,
+                                              json_string_value(json_array_get(changes, i)));
+        }
+
+        nv_app_profile_config_free(ctk_app_profile->cur_config);
+        ctk_app_profile->cur_config = nv_app_profile_config_dup(ctk_app_profile->gold_config);
+
+        app_profile_attach_config(ctk_app_profile);
+
+        ctk_config_statusbar_message(ctk_app_profile->ctk_config,
+                                     "Application profile configuration files changed on disk "
+                                     "and were reloaded.");
+    }
+
+    json_decref(updates);
+    json_decref(changes);
+
+    return TRUE;
 }
 
 
@@ -4624,15 +4643,25 @@ GtkWidget* ctk_app_profile_new(CtrlTarget *ctrl_target,
 
     /* Load app profile settings */
     // TODO only load this if the page is exposed
-    search_path = get_default_search_path(&search_path_size);
-    global_config_file = get_default_global_config_file();
+    search_path = nv_app_profile_get_default_search_path(&search_path_size);
+    global_config_file = nv_app_profile_get_default_global_config_file();
     ctk_app_profile->gold_config = nv_app_profile_config_load(global_config_file,
                                                               search_path,
                                                               search_path_size);
     ctk_app_profile->cur_config = nv_app_profile_config_dup(ctk_app_profile->gold_config);
-    free_search_path(search_path, search_path_size);
+    nv_app_profile_free_search_path(search_path, search_path_size);
     free(global_config_file);
 
+    ctk_app_profile->watch = nv_app_profile_config_watch_new(ctk_app_profile->gold_config);
+    if (ctk_app_profile->watch) {
+        GIOChannel *channel =
+            g_io_channel_unix_new(nv_app_profile_config_watch_get_fd(ctk_app_profile->watch));
+        ctk_app_profile->watch_source = g_io_add_watch(channel, G_IO_IN,
+                                                       config_files_changed,
+                                                       (gpointer)ctk_app_profile);
+        g_io_channel_unref(channel);
+    }
+
     ctk_app_profile->apc_profile_model = ctk_apc_profile_model_new(ctk_app_profile->cur_config);
     ctk_app_profile->apc_rule_model = ctk_apc_rule_model_new(ctk_app_profile->cur_config);
 
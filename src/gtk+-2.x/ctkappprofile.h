@@ -166,6 +166,10 @@ struct _CtkAppProfile
     AppProfileConfig *gold_config, *cur_config;
     json_t *key_docs;
 
+    // Tracks changes to the configuration files on disk
+    AppProfileConfigWatch *watch;
+    guint watch_source;
+
     // Interfaces layered on top of the config object for use with GtkTreeView
     CtkApcProfileModel *apc_profile_model;
     CtkApcRuleModel    *apc_rule_model;
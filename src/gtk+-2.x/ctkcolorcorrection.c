@@ -81,6 +81,9 @@ get_attribute_channel_value (CtkColorCorrection *, gint, gint);
 static void
 flush_attribute_channel_values (CtkColorCorrection *, gint, gint);
 
+static void
+queue_attribute_channel_values (CtkColorCorrection *, gint, gint);
+
 static void
 ctk_color_correction_class_init(CtkColorCorrectionClass *, gpointer);
 
@@ -98,6 +101,11 @@ static void callback_palette_update(GObject *object, CtrlEvent *event,
 static void
 update_confirm_text  (CtkColorCorrection *);
 
+static gboolean flush_pending_color_ramp(gpointer);
+
+static gboolean slider_button_released(GtkWidget *, GdkEventButton *,
+                                       gpointer);
+
 enum {
     CHANGED,
     LAST_SIGNAL
@@ -186,6 +194,11 @@ static void ctk_color_correction_finalize(GObject *object)
     CtkColorCorrection *ctk_color_correction = CTK_COLOR_CORRECTION(object);
     CtrlTarget *ctrl_target = ctk_color_correction->ctrl_target;
 
+    if (ctk_color_correction->flush_timer) {
+        g_source_remove(ctk_color_correction->flush_timer);
+        ctk_color_correction->flush_timer = 0;
+    }
+
     if (ctk_color_correction->confirm_timer) {
         /*
          * This situation comes, if user perform VT-switching
@@ -272,6 +285,7 @@ GtkWidget* ctk_color_correction_new(CtrlTarget *ctrl_target,
     ctk_color_correction->ctk_config = ctk_config;
     ctk_color_correction->ctk_event = ctk_event;
     ctk_color_correction->confirm_timer = 0;
+    ctk_color_correction->flush_timer = 0;
     ctk_color_correction->confirm_countdown =
         DEFAULT_CONFIRM_COLORCORRECTION_TIMEOUT;
     apply_parsed_attribute_list(ctk_color_correction, p);
@@ -438,6 +452,10 @@ GtkWidget* ctk_color_correction_new(CtrlTarget *ctrl_target,
     
     widget = CTK_SCALE(scale)->gtk_scale;
 
+    g_signal_connect(G_OBJECT(widget), "button_release_event",
+                     G_CALLBACK(slider_button_released),
+                     (gpointer) ctk_color_correction);
+
     ctk_config_set_tooltip(ctk_config, widget, "The Brightness slider alters "
                            "the amount of brightness for the selected color "
                            "channel(s).");
@@ -467,6 +485,10 @@ GtkWidget* ctk_color_correction_new(CtrlTarget *ctrl_target,
     
     widget = CTK_SCALE(scale)->gtk_scale;
 
+    g_signal_connect(G_OBJECT(widget), "button_release_event",
+                     G_CALLBACK(slider_button_released),
+                     (gpointer) ctk_color_correction);
+
     ctk_config_set_tooltip(ctk_config, widget, "The Contrast slider alters "
                            "the amount of contrast for the selected color "
                            "channel(s).");
@@ -494,6 +516,10 @@ GtkWidget* ctk_color_correction_new(CtrlTarget *ctrl_target,
     gtk_box_pack_start(GTK_BOX(rightvbox), scale, TRUE, TRUE, 0);
 
     widget = CTK_SCALE(scale)->gtk_scale;
+
+    g_signal_connect(G_OBJECT(widget), "button_release_event",
+                     G_CALLBACK(slider_button_released),
+                     (gpointer) ctk_color_correction);
  
     ctk_config_set_tooltip(ctk_config, widget, "The Gamma slider alters "
                            "the amount of gamma for the selected color "
@@ -805,8 +831,6 @@ static void adjustment_value_changed(
     channel = GPOINTER_TO_INT(user_data);
 
     value = gtk_adjustment_get_value(adjustment);
-    
-    ctk_color_correction->num_expected_updates++;
 
     /* start timer for confirming changes */
     ctk_color_correction->confirm_countdown =
@@ -857,7 +881,7 @@ static void adjustment_value_changed(
     set_color_state(ctk_color_correction, attribute_idx, channel,
                     value, FALSE);
     
-    flush_attribute_channel_values(ctk_color_correction, attribute, channel);
+    queue_attribute_channel_values(ctk_color_correction, attribute, channel);
     
     ctk_config_statusbar_message(ctk_color_correction->ctk_config,
                                  "Set %s%s to %f.",
@@ -914,6 +938,12 @@ static void flush_attribute_channel_values(
 {
     CtrlTarget *ctrl_target = ctk_color_correction->ctrl_target;
 
+    /* This supersedes any coalesced ramp that is still pending */
+    if (ctk_color_correction->flush_timer) {
+        g_source_remove(ctk_color_correction->flush_timer);
+        ctk_color_correction->flush_timer = 0;
+    }
+
     NvCtrlSetColorAttributes(ctrl_target,
                              ctk_color_correction->cur_slider_val[CONTRAST],
                              ctk_color_correction->cur_slider_val[BRIGHTNESS],
@@ -926,6 +956,77 @@ static void flush_attribute_channel_values(
 }
 
 
+/*
+ * queue_attribute_channel_values() - same as
+ * flush_attribute_channel_values(), for values that change continuously
+ * as a slider is dragged: the library only sends a new color ramp to the
+ * X server every NV_CTRL_COLOR_UPDATE_INTERVAL ms, so the latest ramp is
+ * sent from a timer if it was held back, or when the slider is released.
+ */
+
+static void queue_attribute_channel_values(
+    CtkColorCorrection *ctk_color_correction,
+    gint attribute,
+    gint channel
+)
+{
+    CtrlTarget *ctrl_target = ctk_color_correction->ctrl_target;
+    Bool sent;
+
+    NvCtrlQueueColorAttributes(ctrl_target,
+                               ctk_color_correction->cur_slider_val[CONTRAST],
+                               ctk_color_correction->cur_slider_val[BRIGHTNESS],
+                               ctk_color_correction->cur_slider_val[GAMMA],
+                               attribute | channel, &sent);
+
+    if (sent) {
+        ctk_color_correction->num_expected_updates++;
+    } else if (ctk_color_correction->flush_timer == 0) {
+        ctk_color_correction->flush_timer =
+            g_timeout_add(NV_CTRL_COLOR_UPDATE_INTERVAL,
+                          flush_pending_color_ramp,
+                          (gpointer) ctk_color_correction);
+    }
+
+    gtk_widget_hide(ctk_color_correction->warning_container);
+
+    g_signal_emit(ctk_color_correction, signals[CHANGED], 0);
+}
+
+
+static gboolean flush_pending_color_ramp(gpointer user_data)
+{
+    CtkColorCorrection *ctk_color_correction = CTK_COLOR_CORRECTION(user_data);
+    Bool sent;
+
+    ctk_color_correction->flush_timer = 0;
+
+    NvCtrlFlushColorAttributes(ctk_color_correction->ctrl_target, &sent);
+
+    if (sent) {
+        ctk_color_correction->num_expected_updates++;
+    }
+
+    return FALSE;
+}
+
+
+static gboolean slider_button_released(GtkWidget *widget,
+                                       GdkEventButton *event,
+                                       gpointer user_data)
+{
+    CtkColorCorrection *ctk_color_correction = CTK_COLOR_CORRECTION(user_data);
+
+    /* Make sure the final position of the slider is applied right away */
+    if (ctk_color_correction->flush_timer) {
+        g_source_remove(ctk_color_correction->flush_timer);
+        flush_pending_color_ramp(ctk_color_correction);
+    }
+
+    return FALSE;
+}
+
+
 static void apply_parsed_attribute_list(
     CtkColorCorrection *ctk_color_correction,
     ParsedAttribute *p
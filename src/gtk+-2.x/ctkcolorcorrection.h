@@ -67,6 +67,7 @@ struct _CtkColorCorrection
     GtkWidget *confirm_label;
     gint confirm_countdown;
     guint confirm_timer;
+    guint flush_timer;            // sends a coalesced color ramp
     gfloat cur_slider_val[3][4];  // as [attribute][channel]
     gfloat prev_slider_val[3][4]; // as [attribute][channel]
     guint enabled_display_devices;
@@ -238,19 +238,21 @@ GtkWidget* ctk_config_new(ConfigProperties *conf, CtrlSystem *pCtrlSystem)
         check_button = gtk_check_button_new();
         gtk_container_add(GTK_CONTAINER(check_button), label);
 
-        b = !!(ctk_config->conf->booleans & config_check_button_entries[i].mask);
+        b = !!(ctk_config->conf->booleans &
+               config_check_button_entries[i].mask);
 
         gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(check_button), b);
         gtk_box_pack_start(GTK_BOX(vbox), check_button, FALSE, FALSE, 0);
         g_signal_connect(G_OBJECT(check_button), "toggled",
                          config_check_button_entries[i].toggled_callback,
                          ctk_config);
-        ctk_config_set_tooltip_and_add_help_data(ctk_config,
-                                                 check_button,
-                                                 &ctk_config->help_data,
-                                                 config_check_button_entries[i].label,
-                                                 config_check_button_entries[i].help_text,
-                                                 NULL);
+        ctk_config_set_tooltip_and_add_help_data(
+            ctk_config,
+            check_button,
+            &ctk_config->help_data,
+            config_check_button_entries[i].label,
+            config_check_button_entries[i].help_text,
+            NULL);
     }
 
     ctk_config->help_data = g_list_reverse(ctk_config->help_data);
@@ -261,6 +263,7 @@ GtkWidget* ctk_config_new(ConfigProperties *conf, CtrlSystem *pCtrlSystem)
     ctk_config->timer_list = create_timer_list(ctk_config);
     g_object_ref(ctk_config->timer_list);
     ctk_config->timer_list_visible = FALSE;
+    ctk_config->timers_suspended = FALSE;
 
     gtk_box_pack_start(GTK_BOX(ctk_config), ctk_config->timer_list_box,
                        TRUE, TRUE, 0); 
@@ -492,7 +495,8 @@ gboolean ctk_config_slider_text_entry_shown(CtkConfig *ctk_config)
               CONFIG_PROPERTIES_SLIDER_TEXT_ENTRIES);
 }
 
-GtkTextBuffer *ctk_config_create_help(CtkConfig *ctk_config, GtkTextTagTable *table)
+GtkTextBuffer *ctk_config_create_help(CtkConfig *ctk_config,
+                                      GtkTextTagTable *table)
 {
     GtkTextIter i;
     GtkTextBuffer *b;
@@ -515,8 +519,12 @@ GtkTextBuffer *ctk_config_create_help(CtkConfig *ctk_config, GtkTextTagTable *ta
                   "describes the function of a timer, the 'Enabled' "
                   "field allows enabling/disabling it, the 'Time "
                   "Interval' field controls the delay between two "
-                  "consecutive polls (in milliseconds).  The Active "
-                  "Timers table is only visible when timers are active.");
+                  "consecutive polls (in milliseconds).  The 'Active' "
+                  "field shows whether the timer is currently polling: "
+                  "timers only run while the page they belong to is "
+                  "displayed and the nvidia-settings window is not "
+                  "minimized.  The Active Timers table is only visible "
+                  "when timers are active.");
 
     ctk_help_heading(b, &i, "Save Current Configuration");
     ctk_help_para(b, &i, "%s", __save_current_config_help);
@@ -537,6 +545,9 @@ GtkTextBuffer *ctk_config_create_help(CtkConfig *ctk_config, GtkTextTagTable *ta
 static void enabled_renderer_func(GtkTreeViewColumn*, GtkCellRenderer*,
                                   GtkTreeModel*, GtkTreeIter*, gpointer);
 
+static void active_renderer_func(GtkTreeViewColumn*, GtkCellRenderer*,
+                                 GtkTreeModel*, GtkTreeIter*, gpointer);
+
 static void description_renderer_func(GtkTreeViewColumn*, GtkCellRenderer*,
                                       GtkTreeModel*, GtkTreeIter*, gpointer);
 
@@ -557,6 +568,7 @@ enum {
     DATA_COLUMN,
     HANDLE_COLUMN,
     OWNER_ENABLE_COLUMN,
+    FIRE_ON_START_COLUMN,
     NUM_COLUMNS,
 };
 
@@ -582,7 +594,8 @@ static GtkWidget *create_timer_list(CtkConfig *ctk_config)
                            G_TYPE_POINTER,  /* FUNCTION_COLUMN */
                            G_TYPE_POINTER,  /* DATA_COLUMN */
                            G_TYPE_UINT,     /* HANDLE_COLUMN */
-                           G_TYPE_BOOLEAN); /* OWNER_ENABLE_COLUMN */
+                           G_TYPE_BOOLEAN,  /* OWNER_ENABLE_COLUMN */
+                           G_TYPE_BOOLEAN); /* FIRE_ON_START_COLUMN */
     
     model = GTK_TREE_MODEL(ctk_config->list_store);
     
@@ -608,6 +621,23 @@ static GtkWidget *create_timer_list(CtkConfig *ctk_config)
                                             (TIMER_CONFIG_COLUMN),
                                             NULL);
 
+    /* Active */
+
+    renderer = gtk_cell_renderer_toggle_new();
+    g_object_set(renderer, "activatable", FALSE, NULL);
+    column = gtk_tree_view_column_new_with_attributes("Active", renderer,
+                                                      NULL);
+
+    gtk_tree_view_append_column(GTK_TREE_VIEW(treeview), column);
+    gtk_tree_view_column_set_resizable(column, FALSE);
+
+    gtk_tree_view_column_set_cell_data_func(column,
+                                            renderer,
+                                            active_renderer_func,
+                                            GINT_TO_POINTER
+                                            (HANDLE_COLUMN),
+                                            NULL);
+
     /* Description */
     
     renderer = gtk_cell_renderer_text_new();
@@ -689,6 +719,26 @@ static void enabled_renderer_func(GtkTreeViewColumn *tree_column,
     g_object_set(GTK_CELL_RENDERER(cell), "active", value, NULL);
 }
 
+/*
+ * A timer is active when it has a GLib source attached; the handle is
+ * reset to 0 whenever the source is removed, so this reflects whether
+ * the timer is actually firing rather than just the user's preference.
+ */
+
+static void active_renderer_func(GtkTreeViewColumn *tree_column,
+                                 GtkCellRenderer   *cell,
+                                 GtkTreeModel      *model,
+                                 GtkTreeIter       *iter,
+                                 gpointer           data)
+{
+    gint column = GPOINTER_TO_INT(data);
+    guint handle;
+
+    gtk_tree_model_get(model, iter, column, &handle, -1);
+
+    g_object_set(GTK_CELL_RENDERER(cell), "active", (handle != 0), NULL);
+}
+
 static void description_renderer_func(GtkTreeViewColumn *tree_column,
                                       GtkCellRenderer   *cell,
                                       GtkTreeModel      *model,
@@ -737,6 +787,73 @@ static void time_interval_renderer_func(GtkTreeViewColumn *tree_column,
 
 
 
+/*
+ * timer_should_run() - a timer only polls when the user has enabled it,
+ * the page that owns it is being displayed, and the window is not
+ * hidden.
+ */
+
+static gboolean timer_should_run(CtkConfig *ctk_config,
+                                 TimerConfigProperty *timer_config,
+                                 gboolean owner_enabled)
+{
+    return timer_config->user_enabled && owner_enabled &&
+        !ctk_config->timers_suspended;
+}
+
+
+
+/*
+ * run_timer() - attach the timer's source.  Timers added with
+ * ctk_config_add_timer_full() and 'fire_on_start' set are fired once
+ * right away, so their page is up to date as soon as it becomes visible
+ * instead of one interval later; as for any GLib source, the timer is
+ * not scheduled if that call returns FALSE, or if the call stopped the
+ * timer.
+ */
+
+static void run_timer(CtkConfig *ctk_config, GtkTreeIter *iter,
+                      TimerConfigProperty *timer_config,
+                      GSourceFunc function, gpointer data)
+{
+    GtkTreeModel *model = GTK_TREE_MODEL(ctk_config->list_store);
+    gboolean fire_on_start, owner_enabled;
+    guint handle;
+
+    gtk_tree_model_get(model, iter,
+                       FIRE_ON_START_COLUMN, &fire_on_start, -1);
+
+    if (fire_on_start) {
+        if (!(*function)(data)) {
+            return;
+        }
+
+        gtk_tree_model_get(model, iter,
+                           OWNER_ENABLE_COLUMN, &owner_enabled, -1);
+        if (!timer_should_run(ctk_config, timer_config, owner_enabled)) {
+            return;
+        }
+    }
+
+    handle = g_timeout_add(timer_config->interval, function, data);
+    gtk_list_store_set(ctk_config->list_store, iter,
+                       HANDLE_COLUMN, handle, -1);
+}
+
+
+
+static void halt_timer(CtkConfig *ctk_config, GtkTreeIter *iter,
+                       guint handle)
+{
+    if (handle) {
+        g_source_remove(handle);
+    }
+    gtk_list_store_set(ctk_config->list_store, iter,
+                       HANDLE_COLUMN, 0, -1);
+}
+
+
+
 static void time_interval_edited(GtkCellRendererText *cell,
                                  const gchar         *path_string,
                                  const gchar         *new_text,
@@ -775,9 +892,13 @@ static void time_interval_edited(GtkCellRendererText *cell,
 
     timer_config->interval = interval;
     
-    /* Restart the timer if it is already running */
+    /*
+     * Restart the timer if it is already running; a timer whose function
+     * asked to stop when it was started has no source to restart
+     */
 
-    if (timer_config->user_enabled && owner_enabled) {
+    if (timer_should_run(ctk_config, timer_config, owner_enabled) &&
+        (handle != 0)) {
         
         g_source_remove(handle);
         
@@ -816,15 +937,16 @@ static void timer_enable_toggled(GtkCellRendererToggle *cell,
 
     timer_config->user_enabled ^= 1;
 
-    /* Start/stop the timer only when the owner widget has enabled it */
+    /*
+     * Start/stop the timer only when the owner widget has enabled it
+     * and the window is not hidden
+     */
 
-    if (owner_enabled) {
+    if (owner_enabled && !ctk_config->timers_suspended) {
         if (timer_config->user_enabled) {
-            handle = g_timeout_add(timer_config->interval, function, data);
-            gtk_list_store_set(ctk_config->list_store, &iter,
-                               HANDLE_COLUMN, handle, -1);
+            run_timer(ctk_config, &iter, timer_config, function, data);
         } else {
-            g_source_remove(handle);
+            halt_timer(ctk_config, &iter, handle);
         }
     }
 
@@ -839,6 +961,17 @@ void ctk_config_add_timer(CtkConfig *ctk_config,
                           gchar *descr,
                           GSourceFunc function,
                           gpointer data)
+{
+    ctk_config_add_timer_full(ctk_config, interval, descr, function, data,
+                              FALSE);
+}
+
+void ctk_config_add_timer_full(CtkConfig *ctk_config,
+                               guint interval,
+                               gchar *descr,
+                               GSourceFunc function,
+                               gpointer data,
+                               gboolean fire_on_start)
 {
     GtkTreeIter iter;
     ConfigProperties *conf = ctk_config->conf;
@@ -873,8 +1006,10 @@ void ctk_config_add_timer(CtkConfig *ctk_config,
     gtk_list_store_set(ctk_config->list_store, &iter,
                        TIMER_CONFIG_COLUMN, timer_config,
                        OWNER_ENABLE_COLUMN, FALSE,
+                       HANDLE_COLUMN, 0,
                        FUNCTION_COLUMN, function,
-                       DATA_COLUMN, data, -1);
+                       DATA_COLUMN, data,
+                       FIRE_ON_START_COLUMN, fire_on_start, -1);
 
     /* make the timer list visible if it is not */
 
@@ -887,7 +1022,8 @@ void ctk_config_add_timer(CtkConfig *ctk_config,
     }
 }
 
-void ctk_config_remove_timer(CtkConfig *ctk_config, GSourceFunc function)
+void ctk_config_remove_timer(CtkConfig *ctk_config, GSourceFunc function,
+                             gpointer data)
 {
     GtkTreeModel *model;
     GtkTreeIter iter;
@@ -896,6 +1032,7 @@ void ctk_config_remove_timer(CtkConfig *ctk_config, GSourceFunc function)
     guint handle;
     TimerConfigProperty *timer_config;
     gboolean owner_enabled;
+    gpointer model_data;
     
     model = GTK_TREE_MODEL(ctk_config->list_store);
 
@@ -904,13 +1041,14 @@ void ctk_config_remove_timer(CtkConfig *ctk_config, GSourceFunc function)
         gtk_tree_model_get(model, &iter,
                            TIMER_CONFIG_COLUMN, &timer_config,
                            FUNCTION_COLUMN, &func,
+                           DATA_COLUMN, &model_data,
                            OWNER_ENABLE_COLUMN, &owner_enabled,
                            HANDLE_COLUMN, &handle, -1);
-        if (func == function) {
+        if ((func == function) && (model_data == data)) {
 
             /* Remove the timer if it was running */
 
-            if (timer_config->user_enabled && owner_enabled) {
+            if (handle) {
                 g_source_remove(handle);
             }
 
@@ -930,7 +1068,8 @@ void ctk_config_remove_timer(CtkConfig *ctk_config, GSourceFunc function)
     }
 }
 
-void ctk_config_start_timer(CtkConfig *ctk_config, GSourceFunc function, gpointer data)
+void ctk_config_start_timer(CtkConfig *ctk_config, GSourceFunc function,
+                            gpointer data)
 {
     GtkTreeModel *model;
     GtkTreeIter iter;
@@ -957,20 +1096,20 @@ void ctk_config_start_timer(CtkConfig *ctk_config, GSourceFunc function, gpointe
             /* Start the timer if is enabled by the user and
                it is not already running. */
             
-            if (timer_config->user_enabled && !owner_enabled) {
-                handle = g_timeout_add(timer_config->interval, function, data);
-                gtk_list_store_set(ctk_config->list_store, &iter,
-                                   HANDLE_COLUMN, handle, -1);
-            }
             gtk_list_store_set(ctk_config->list_store, &iter,
                                OWNER_ENABLE_COLUMN, TRUE, -1);
+            if (!owner_enabled &&
+                timer_should_run(ctk_config, timer_config, TRUE)) {
+                run_timer(ctk_config, &iter, timer_config, function, data);
+            }
             break;
         }
         valid = gtk_tree_model_iter_next(model, &iter);
     }
 }
 
-void ctk_config_stop_timer(CtkConfig *ctk_config, GSourceFunc function, gpointer data)
+void ctk_config_stop_timer(CtkConfig *ctk_config, GSourceFunc function,
+                           gpointer data)
 {
     GtkTreeModel *model;
     GtkTreeIter iter;
@@ -996,9 +1135,7 @@ void ctk_config_stop_timer(CtkConfig *ctk_config, GSourceFunc function, gpointer
 
             /* Remove the timer if was running. */
 
-            if (timer_config->user_enabled && owner_enabled) {
-                g_source_remove(handle);
-            }
+            halt_timer(ctk_config, &iter, handle);
             gtk_list_store_set(ctk_config->list_store, &iter,
                                OWNER_ENABLE_COLUMN, FALSE, -1);
             break;
@@ -1007,6 +1144,54 @@ void ctk_config_stop_timer(CtkConfig *ctk_config, GSourceFunc function, gpointer
     }
 }
 
+/*
+ * ctk_config_suspend_timers() - stop every running timer while the
+ * control panel window is iconified or unmapped, and restart the timers
+ * of the displayed page when the window is shown again.  The per-page
+ * owner state is left untouched, so page selection keeps working
+ * independently of the window state.
+ */
+
+void ctk_config_suspend_timers(CtkConfig *ctk_config, gboolean suspend)
+{
+    GtkTreeModel *model;
+    GtkTreeIter iter;
+    GSourceFunc func;
+    gboolean valid;
+    guint handle;
+    TimerConfigProperty *timer_config;
+    gboolean owner_enabled;
+    gpointer data;
+
+    if (ctk_config->timers_suspended == suspend) {
+        return;
+    }
+
+    ctk_config->timers_suspended = suspend;
+
+    model = GTK_TREE_MODEL(ctk_config->list_store);
+
+    valid = gtk_tree_model_get_iter_first(model, &iter);
+    while (valid) {
+        gtk_tree_model_get(model, &iter,
+                           TIMER_CONFIG_COLUMN, &timer_config,
+                           OWNER_ENABLE_COLUMN, &owner_enabled,
+                           HANDLE_COLUMN, &handle,
+                           FUNCTION_COLUMN, &func,
+                           DATA_COLUMN, &data,
+                           -1);
+
+        if (suspend) {
+            halt_timer(ctk_config, &iter, handle);
+        } else if (timer_should_run(ctk_config, timer_config,
+                                    owner_enabled)) {
+            run_timer(ctk_config, &iter, timer_config, func, data);
+        }
+
+        valid = gtk_tree_model_iter_next(model, &iter);
+    }
+}
+
 /*
  * Helper function to add a tooltip to a widget *and* append a section to the
  * help text for that widget, for pages which use CtkHelpDataItem lists
@@ -1018,6 +1203,7 @@ void ctk_config_set_tooltip_and_add_help_data(CtkConfig *config,
                                               const gchar *help_text,
                                               const gchar *extended_help_text)
 {
-    ctk_help_data_list_prepend(help_data_list, label, help_text, extended_help_text); 
+    ctk_help_data_list_prepend(help_data_list, label, help_text,
+                               extended_help_text);
     ctk_config_set_tooltip(config, widget, help_text);
 }
@@ -97,6 +97,7 @@ struct _CtkConfig
     GtkWidget *button_save_rc;
     gchar *rc_filename;
     gboolean timer_list_visible;
+    gboolean timers_suspended;
     CtrlSystem *pCtrlSystem;
     GList *help_data;
     guint pending_config;
@@ -116,10 +117,13 @@ void       ctk_config_set_tooltip         (CtkConfig *, GtkWidget *,
 GtkTextBuffer *ctk_config_create_help     (CtkConfig *, GtkTextTagTable *);
 
 void ctk_config_add_timer(CtkConfig *, guint, gchar *, GSourceFunc, gpointer);
-void ctk_config_remove_timer(CtkConfig *, GSourceFunc);
+void ctk_config_add_timer_full(CtkConfig *, guint, gchar *, GSourceFunc,
+                               gpointer, gboolean);
+void ctk_config_remove_timer(CtkConfig *, GSourceFunc, gpointer);
 
 void ctk_config_start_timer(CtkConfig *, GSourceFunc, gpointer);
 void ctk_config_stop_timer(CtkConfig *, GSourceFunc, gpointer);
+void ctk_config_suspend_timers(CtkConfig *, gboolean);
 
 gboolean ctk_config_slider_text_entry_shown(CtkConfig *);
 
@@ -34,6 +34,16 @@
 
 #define DEFAULT_UPDATE_ECC_STATUS_INFO_TIME_INTERVAL 1000
 
+/* Integer attributes read by update_ecc_info() */
+
+static const int __ecc_sampled_attributes[] = {
+    NV_CTRL_GPU_ECC_CONFIGURATION,
+    NV_CTRL_GPU_ECC_SINGLE_BIT_ERRORS,
+    NV_CTRL_GPU_ECC_DOUBLE_BIT_ERRORS,
+    NV_CTRL_GPU_ECC_AGGREGATE_SINGLE_BIT_ERRORS,
+    NV_CTRL_GPU_ECC_AGGREGATE_DOUBLE_BIT_ERRORS,
+};
+
 static const char *__ecc_settings_help =
 "This page allows you to change the Error Correction Code (ECC) "
 "setting for this GPU.";
@@ -95,6 +105,12 @@ static void ecc_configuration_update_received(GObject *, CtrlEvent *, gpointer);
 static void post_ecc_configuration_update(CtkEcc *);
 static void reset_default_config_button_clicked(GtkWidget *, gpointer);
 
+static void ctk_ecc_class_init(CtkEccClass *, gpointer);
+static void ctk_ecc_finalize(GObject *);
+static gboolean update_ecc_info(gpointer);
+
+static GObjectClass *parent_class = NULL;
+
 GType ctk_ecc_get_type(void)
 {
     static GType ctk_ecc_type = 0;
@@ -104,7 +120,7 @@ GType ctk_ecc_get_type(void)
             sizeof (CtkEccClass),
             NULL, /* base_init */
             NULL, /* base_finalize */
-            NULL, /* constructor */
+            (GClassInitFunc) ctk_ecc_class_init, /* constructor */
             NULL, /* class_finalize */
             NULL, /* class_data */
             sizeof (CtkEcc),
@@ -124,6 +140,34 @@ GType ctk_ecc_get_type(void)
 
 
 
+static void ctk_ecc_class_init(CtkEccClass *ctk_ecc_class,
+                               gpointer class_data)
+{
+    GObjectClass *gobject_class = (GObjectClass *)ctk_ecc_class;
+
+    parent_class = (GObjectClass *)g_type_class_peek_parent(ctk_ecc_class);
+    gobject_class->finalize = ctk_ecc_finalize;
+}
+
+
+
+static void ctk_ecc_finalize(GObject *object)
+{
+    CtkEcc *ctk_ecc = CTK_ECC(object);
+
+    /* Stop sampling for this page */
+
+    if (ctk_ecc->sampler) {
+        ctk_sampler_unsubscribe(ctk_ecc->sampler,
+                                (GSourceFunc) update_ecc_info,
+                                (gpointer) ctk_ecc);
+    }
+
+    parent_class->finalize(object);
+}
+
+
+
 static void set_label_value(GtkWidget *widget, uint64_t val)
 {
     gchar *s;
@@ -773,6 +817,24 @@ static void update_detailed_label_for_values(CtkEcc *ctk_ecc)
 
 
 
+/*
+ * ctk_ecc_available() - returns whether ctk_ecc_new() would build a page
+ * for the given GPU, without building it.
+ */
+
+gboolean ctk_ecc_available(CtrlTarget *ctrl_target)
+{
+    ReturnStatus ret;
+    gint val;
+
+    ret = NvCtrlGetAttribute(ctrl_target, NV_CTRL_GPU_ECC_SUPPORTED, &val);
+
+    return (ret == NvCtrlSuccess) && (val == NV_CTRL_GPU_ECC_SUPPORTED_TRUE);
+
+} /* ctk_ecc_available() */
+
+
+
 GtkWidget* ctk_ecc_new(CtrlTarget *ctrl_target,
                        CtkConfig *ctk_config,
                        CtkEvent *ctk_event)
@@ -794,8 +856,7 @@ GtkWidget* ctk_ecc_new(CtrlTarget *ctrl_target,
     gboolean ecc_enabled;
     ReturnStatus ret;
     gchar *ecc_enabled_string;
-    gchar *str = NULL;
-    int loc;
+    int loc, i;
     gint xpad = 12, ypad = 2;
 
     /* make sure we have a handle */
@@ -1142,17 +1203,22 @@ GtkWidget* ctk_ecc_new(CtrlTarget *ctrl_target,
                      G_CALLBACK(reset_default_config_button_clicked),
                      (gpointer) ctk_ecc);
 
-    /* Register a timer callback to update Ecc status info */
-    str = g_strdup_printf("ECC Settings (GPU %d)",
-                        NvCtrlGetTargetId(ctrl_target));
+    /* Subscribe to the GPU sampler to update Ecc status info */
 
-    ctk_config_add_timer(ctk_ecc->ctk_config,
-                         DEFAULT_UPDATE_ECC_STATUS_INFO_TIME_INTERVAL,
-                         str,
-                         (GSourceFunc) update_ecc_info,
-                         (gpointer) ctk_ecc);
+    ctk_ecc->sampler = ctk_sampler_get(ctk_ecc->ctk_config, ctrl_target);
+
+    ctk_sampler_subscribe(ctk_ecc->sampler,
+                          DEFAULT_UPDATE_ECC_STATUS_INFO_TIME_INTERVAL,
+                          (GSourceFunc) update_ecc_info,
+                          (gpointer) ctk_ecc);
 
-    g_free(str);
+    for (i = 0; i < ARRAY_LEN(__ecc_sampled_attributes); i++) {
+        ctk_sampler_add_attribute(ctk_ecc->sampler,
+                                  (GSourceFunc) update_ecc_info,
+                                  (gpointer) ctk_ecc,
+                                  ctrl_target,
+                                  __ecc_sampled_attributes[i]);
+    }
     
     gtk_widget_show_all(GTK_WIDGET(ctk_ecc));
 
@@ -1219,20 +1285,20 @@ void ctk_ecc_start_timer(GtkWidget *widget)
 {
     CtkEcc *ctk_ecc = CTK_ECC(widget);
 
-    /* Start the ECC timer */
+    /* Start the ECC updates */
 
-    ctk_config_start_timer(ctk_ecc->ctk_config,
-                           (GSourceFunc) update_ecc_info,
-                           (gpointer) ctk_ecc);
+    ctk_sampler_start(ctk_ecc->sampler,
+                      (GSourceFunc) update_ecc_info,
+                      (gpointer) ctk_ecc);
 }
 
 void ctk_ecc_stop_timer(GtkWidget *widget)
 {
     CtkEcc *ctk_ecc = CTK_ECC(widget);
 
-    /* Stop the ECC timer */
+    /* Stop the ECC updates */
 
-    ctk_config_stop_timer(ctk_ecc->ctk_config,
-                          (GSourceFunc) update_ecc_info,
-                          (gpointer) ctk_ecc);
+    ctk_sampler_stop(ctk_ecc->sampler,
+                     (GSourceFunc) update_ecc_info,
+                     (gpointer) ctk_ecc);
 }
@@ -22,6 +22,7 @@
 
 #include "ctkevent.h"
 #include "ctkconfig.h"
+#include "ctksampler.h"
 #include "nvml.h"
 
 G_BEGIN_DECLS
@@ -63,6 +64,7 @@ struct _CtkEcc
 
     CtrlTarget *ctrl_target;
     CtkConfig *ctk_config;
+    CtkSampler *sampler;
 
     GtkWidget* status;
     GtkWidget* sbit_error;
@@ -96,6 +98,7 @@ struct _CtkEccClass
 };
 
 GType          ctk_ecc_get_type    (void) G_GNUC_CONST;
+gboolean       ctk_ecc_available   (CtrlTarget *);
 GtkWidget*     ctk_ecc_new         (CtrlTarget *, CtkConfig *, CtkEvent *);
 GtkTextBuffer* ctk_ecc_create_help (GtkTextTagTable *, CtkEcc *);
 
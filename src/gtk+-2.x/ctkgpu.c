@@ -53,6 +53,11 @@ typedef struct {
     gboolean pcie_specified;
 } utilizationEntry, * utilizationEntryPtr;
 
+static void ctk_gpu_class_init(CtkGpuClass *, gpointer);
+static void ctk_gpu_finalize(GObject *);
+
+static GObjectClass *parent_class = NULL;
+
 GType ctk_gpu_get_type(
     void
 )
@@ -64,7 +69,7 @@ GType ctk_gpu_get_type(
             sizeof (CtkGpuClass),
             NULL, /* base_init */
             NULL, /* base_finalize */
-            NULL, /* class_init */
+            (GClassInitFunc) ctk_gpu_class_init, /* class_init */
             NULL, /* class_finalize */
             NULL, /* class_data */
             sizeof (CtkGpu),
@@ -82,6 +87,33 @@ GType ctk_gpu_get_type(
 }
 
 
+static void ctk_gpu_class_init(CtkGpuClass *ctk_gpu_class,
+                               gpointer class_data)
+{
+    GObjectClass *gobject_class = (GObjectClass *)ctk_gpu_class;
+
+    parent_class = (GObjectClass *)g_type_class_peek_parent(ctk_gpu_class);
+    gobject_class->finalize = ctk_gpu_finalize;
+}
+
+
+
+static void ctk_gpu_finalize(GObject *object)
+{
+    CtkGpu *ctk_gpu = CTK_GPU(object);
+
+    /* Stop sampling for this page */
+
+    if (ctk_gpu->sampler) {
+        ctk_sampler_unsubscribe(ctk_gpu->sampler,
+                                (GSourceFunc) update_gpu_usage,
+                                (gpointer) ctk_gpu);
+    }
+
+    parent_class->finalize(object);
+}
+
+
 static gchar *make_display_device_list(CtrlTarget *ctrl_target)
 {
     return create_display_name_list_string(ctrl_target,
@@ -656,15 +688,19 @@ GtkWidget* ctk_gpu_new(CtrlTarget *ctrl_target,
                      G_CALLBACK(probe_displays_received),
                      (gpointer) ctk_gpu);
 
-    tmp_str = g_strdup_printf("Memory Used (GPU %d)",
-                              NvCtrlGetTargetId(ctrl_target));
+    /* Subscribe to the GPU sampler to update the memory and utilization */
 
-    ctk_config_add_timer(ctk_gpu->ctk_config,
-                         DEFAULT_UPDATE_GPU_INFO_TIME_INTERVAL,
-                         tmp_str,
-                         (GSourceFunc) update_gpu_usage,
-                         (gpointer) ctk_gpu);
-    g_free(tmp_str);
+    ctk_gpu->sampler = ctk_sampler_get(ctk_gpu->ctk_config, ctrl_target);
+
+    ctk_sampler_subscribe(ctk_gpu->sampler,
+                          DEFAULT_UPDATE_GPU_INFO_TIME_INTERVAL,
+                          (GSourceFunc) update_gpu_usage,
+                          (gpointer) ctk_gpu);
+    ctk_sampler_add_attribute(ctk_gpu->sampler,
+                              (GSourceFunc) update_gpu_usage,
+                              (gpointer) ctk_gpu,
+                              ctrl_target,
+                              NV_CTRL_USED_DEDICATED_GPU_MEMORY);
 
     return GTK_WIDGET(object);
 }
@@ -936,25 +972,24 @@ void ctk_gpu_page_select(GtkWidget *widget)
 {
     CtkGpu *ctk_gpu = CTK_GPU(widget);
 
-    /* Update GPU usage */
-
-    update_gpu_usage(ctk_gpu);
-
-    /* Start the gpu timer */
+    /*
+     * Start the gpu updates; this also updates the GPU usage right away,
+     * unless the page was just built
+     */
 
-    ctk_config_start_timer(ctk_gpu->ctk_config,
-                           (GSourceFunc) update_gpu_usage,
-                           (gpointer) ctk_gpu);
+    ctk_sampler_start(ctk_gpu->sampler,
+                      (GSourceFunc) update_gpu_usage,
+                      (gpointer) ctk_gpu);
 }
 
 void ctk_gpu_page_unselect(GtkWidget *widget)
 {
     CtkGpu *ctk_gpu = CTK_GPU(widget);
 
-    /* Stop the gpu timer */
+    /* Stop the gpu updates */
 
-    ctk_config_stop_timer(ctk_gpu->ctk_config,
-                          (GSourceFunc) update_gpu_usage,
-                          (gpointer) ctk_gpu);
+    ctk_sampler_stop(ctk_gpu->sampler,
+                     (GSourceFunc) update_gpu_usage,
+                     (gpointer) ctk_gpu);
 }
 
@@ -25,6 +25,7 @@
 
 #include "ctkevent.h"
 #include "ctkconfig.h"
+#include "ctksampler.h"
 
 G_BEGIN_DECLS
 
@@ -56,6 +57,7 @@ struct _CtkGpu
     CtrlTarget *ctrl_target;
     CtkConfig *ctk_config;
     CtkEvent *ctk_event;
+    CtkSampler *sampler;
 
     GtkWidget *displays;
     GtkWidget *gpu_memory_used_label;
@@ -37,6 +37,18 @@
 #define FRAME_PADDING 10
 #define DEFAULT_UPDATE_POWERMIZER_INFO_TIME_INTERVAL 1000
 
+/* Integer attributes read by update_powermizer_info() */
+
+static const int __powermizer_sampled_attributes[] = {
+    NV_CTRL_GPU_ADAPTIVE_CLOCK_STATE,
+    NV_CTRL_GPU_POWER_SOURCE,
+    NV_CTRL_GPU_PCIE_CURRENT_LINK_WIDTH,
+    NV_CTRL_GPU_PCIE_CURRENT_LINK_SPEED,
+    NV_CTRL_GPU_CURRENT_PERFORMANCE_LEVEL,
+    NV_CTRL_GPU_POWER_MIZER_MODE,
+    NV_CTRL_GPU_POWER_MIZER_DEFAULT_MODE,
+};
+
 static gboolean update_powermizer_info(gpointer);
 static void update_powermizer_menu_info(CtkPowermizer *ctk_powermizer);
 static void set_powermizer_menu_label_txt(CtkPowermizer *ctk_powermizer,
@@ -126,6 +138,11 @@ static const char *__powermizer_prefer_consistent_performance_help =
 "'Prefer Consistent Performance' hints to the driver to lock to GPU base clocks, "
 "when possible.  ";
 
+static void ctk_powermizer_class_init(CtkPowermizerClass *, gpointer);
+static void ctk_powermizer_finalize(GObject *);
+
+static GObjectClass *parent_class = NULL;
+
 GType ctk_powermizer_get_type(void)
 {
     static GType ctk_powermizer_type = 0;
@@ -135,7 +152,7 @@ GType ctk_powermizer_get_type(void)
             sizeof (CtkPowermizerClass),
             NULL, /* base_init */
             NULL, /* base_finalize */
-            NULL, /* constructor */
+            (GClassInitFunc) ctk_powermizer_class_init, /* constructor */
             NULL, /* class_finalize */
             NULL, /* class_data */
             sizeof (CtkPowermizer),
@@ -155,6 +172,34 @@ GType ctk_powermizer_get_type(void)
 
 
 
+static void ctk_powermizer_class_init(CtkPowermizerClass *ctk_powermizer_class,
+                                      gpointer class_data)
+{
+    GObjectClass *gobject_class = (GObjectClass *)ctk_powermizer_class;
+
+    parent_class = (GObjectClass *)g_type_class_peek_parent(ctk_powermizer_class);
+    gobject_class->finalize = ctk_powermizer_finalize;
+}
+
+
+
+static void ctk_powermizer_finalize(GObject *object)
+{
+    CtkPowermizer *ctk_powermizer = CTK_POWERMIZER(object);
+
+    /* Stop sampling for this page */
+
+    if (ctk_powermizer->sampler) {
+        ctk_sampler_unsubscribe(ctk_powermizer->sampler,
+                                (GSourceFunc) update_powermizer_info,
+                                (gpointer) ctk_powermizer);
+    }
+
+    parent_class->finalize(object);
+}
+
+
+
 typedef struct {
     gint perf_level;
     gboolean perf_level_specified;
@@ -1088,6 +1133,42 @@ static void create_powermizer_menu_entry(CtkDropDownMenu *menu,
 
 
 
+/*
+ * ctk_powermizer_available() - returns whether ctk_powermizer_new() would
+ * build a page for the given GPU, without building it.
+ */
+
+gboolean ctk_powermizer_available(CtrlTarget *ctrl_target)
+{
+    ReturnStatus ret;
+    char *clock_string = NULL;
+    perfModeEntry pEntry;
+    gint val;
+
+    ret = NvCtrlGetAttribute(ctrl_target,
+                             NV_CTRL_GPU_CURRENT_PERFORMANCE_LEVEL,
+                             &val);
+    if (ret == NvCtrlSuccess) {
+        return TRUE;
+    }
+
+    ret = NvCtrlGetStringAttribute(ctrl_target,
+                                   NV_CTRL_STRING_GPU_CURRENT_CLOCK_FREQS,
+                                   &clock_string);
+    if (ret != NvCtrlSuccess) {
+        return FALSE;
+    }
+
+    memset(&pEntry, 0, sizeof(pEntry));
+    parse_token_value_pairs(clock_string, apply_perf_mode_token, &pEntry);
+    free(clock_string);
+
+    return pEntry.nvclock_specified;
+
+} /* ctk_powermizer_available() */
+
+
+
 GtkWidget* ctk_powermizer_new(CtrlTarget *ctrl_target,
                               CtkConfig *ctk_config,
                               CtkEvent *ctk_event)
@@ -1101,8 +1182,8 @@ GtkWidget* ctk_powermizer_new(CtrlTarget *ctrl_target,
     gint nvclock_attribute = 0, mem_transfer_rate_attribute = 0;
     gint val;
     gint row = 0;
-    gchar *s = NULL;
     gint tmp;
+    int i;
     gboolean power_source_available = FALSE;
     gboolean perf_level_available = FALSE;
     gboolean gpu_clock_available = FALSE;
@@ -1406,17 +1487,23 @@ GtkWidget* ctk_powermizer_new(CtrlTarget *ctrl_target,
         ctk_powermizer->performance_table_hbox1 = hbox;
     }
 
-    /* Register a timer callback to update the temperatures */
+    /* Subscribe to the GPU sampler to update the PowerMizer information */
 
-    s = g_strdup_printf("PowerMizer Monitor (GPU %d)",
-                        NvCtrlGetTargetId(ctrl_target));
+    ctk_powermizer->sampler = ctk_sampler_get(ctk_powermizer->ctk_config,
+                                              ctrl_target);
 
-    ctk_config_add_timer(ctk_powermizer->ctk_config,
-                         DEFAULT_UPDATE_POWERMIZER_INFO_TIME_INTERVAL,
-                         s,
-                         (GSourceFunc) update_powermizer_info,
-                         (gpointer) ctk_powermizer);
-    g_free(s);
+    ctk_sampler_subscribe(ctk_powermizer->sampler,
+                          DEFAULT_UPDATE_POWERMIZER_INFO_TIME_INTERVAL,
+                          (GSourceFunc) update_powermizer_info,
+                          (gpointer) ctk_powermizer);
+
+    for (i = 0; i < ARRAY_LEN(__powermizer_sampled_attributes); i++) {
+        ctk_sampler_add_attribute(ctk_powermizer->sampler,
+                                  (GSourceFunc) update_powermizer_info,
+                                  (gpointer) ctk_powermizer,
+                                  ctrl_target,
+                                  __powermizer_sampled_attributes[i]);
+    }
 
     /* PowerMizer Settings */
 
@@ -1758,20 +1845,20 @@ void ctk_powermizer_start_timer(GtkWidget *widget)
 {
     CtkPowermizer *ctk_powermizer = CTK_POWERMIZER(widget);
 
-    /* Start the powermizer timer */
+    /* Start the powermizer updates */
 
-    ctk_config_start_timer(ctk_powermizer->ctk_config,
-                           (GSourceFunc) update_powermizer_info,
-                           (gpointer) ctk_powermizer);
+    ctk_sampler_start(ctk_powermizer->sampler,
+                      (GSourceFunc) update_powermizer_info,
+                      (gpointer) ctk_powermizer);
 }
 
 void ctk_powermizer_stop_timer(GtkWidget *widget)
 {
     CtkPowermizer *ctk_powermizer = CTK_POWERMIZER(widget);
 
-    /* Stop the powermizer timer */
+    /* Stop the powermizer updates */
 
-    ctk_config_stop_timer(ctk_powermizer->ctk_config,
-                          (GSourceFunc) update_powermizer_info,
-                          (gpointer) ctk_powermizer);
+    ctk_sampler_stop(ctk_powermizer->sampler,
+                     (GSourceFunc) update_powermizer_info,
+                     (gpointer) ctk_powermizer);
 }
@@ -22,6 +22,7 @@
 
 #include "ctkconfig.h"
 #include "ctkevent.h"
+#include "ctksampler.h"
 
 G_BEGIN_DECLS
 
@@ -51,6 +52,7 @@ struct _CtkPowermizer
 
     CtrlTarget *ctrl_target;
     CtkConfig *ctk_config;
+    CtkSampler *sampler;
 
     GtkWidget *adaptive_clock_status;
     GtkWidget *gpu_clock;
@@ -85,6 +87,7 @@ struct _CtkPowermizerClass
 };
 
 GType          ctk_powermizer_get_type    (void) G_GNUC_CONST;
+gboolean       ctk_powermizer_available   (CtrlTarget *);
 GtkWidget*     ctk_powermizer_new         (CtrlTarget *, CtkConfig *,
                                            CtkEvent *);
 GtkTextBuffer* ctk_powermizer_create_help (GtkTextTagTable *, CtkPowermizer *);
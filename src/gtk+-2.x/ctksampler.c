@@ -0,0 +1,341 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2024 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+#include <gtk/gtk.h>
+
+#include "NvCtrlAttributes.h"
+#include "ctksampler.h"
+
+#define DEFAULT_UPDATE_GPU_MONITOR_TIME_INTERVAL 1000
+
+/*
+ * Allowance for timer jitter, so that a subscriber whose interval is a
+ * multiple of the sampler's is not pushed back by a whole tick.
+ */
+#define SAMPLER_SLACK_MS 50
+
+typedef struct _CtkSamplerAttribute {
+    CtrlTarget *ctrl_target;
+    int attr;
+} CtkSamplerAttribute;
+
+typedef struct _CtkSamplerSubscriber {
+    GSourceFunc func;
+    gpointer data;
+    guint interval;         /* in ms */
+    gboolean active;
+    gint64 last_update;     /* in ms */
+    GArray *attributes;     /* of CtkSamplerAttribute */
+} CtkSamplerSubscriber;
+
+struct _CtkSampler {
+    CtkConfig *ctk_config;
+    CtrlTarget *ctrl_target;
+    GList *subscribers;     /* of CtkSamplerSubscriber */
+    guint num_active;
+};
+
+/*
+ * One sampler per GPU; they live as long as the pages that use them, and
+ * are freed when the last of these pages goes away
+ */
+
+static GList *__samplers = NULL;
+
+static gboolean sampler_tick(gpointer user_data);
+
+
+
+static CtkSamplerSubscriber *find_subscriber(CtkSampler *sampler,
+                                             GSourceFunc func, gpointer data)
+{
+    GList *l;
+
+    for (l = sampler->subscribers; l; l = l->next) {
+        CtkSamplerSubscriber *sub = l->data;
+
+        if ((sub->func == func) && (sub->data == data)) {
+            return sub;
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*
+ * ctk_sampler_get() - returns the sampler of the given GPU, creating it
+ * and registering its timer the first time it is requested.
+ */
+
+CtkSampler *ctk_sampler_get(CtkConfig *ctk_config, CtrlTarget *ctrl_target)
+{
+    CtkSampler *sampler;
+    GList *l;
+    gchar *s;
+
+    for (l = __samplers; l; l = l->next) {
+        sampler = l->data;
+        if (sampler->ctrl_target == ctrl_target) {
+            return sampler;
+        }
+    }
+
+    sampler = g_new0(CtkSampler, 1);
+    sampler->ctk_config = ctk_config;
+    sampler->ctrl_target = ctrl_target;
+
+    __samplers = g_list_append(__samplers, sampler);
+
+    s = g_strdup_printf("GPU Monitor (GPU %d)",
+                        NvCtrlGetTargetId(ctrl_target));
+
+    ctk_config_add_timer_full(ctk_config,
+                              DEFAULT_UPDATE_GPU_MONITOR_TIME_INTERVAL,
+                              s,
+                              (GSourceFunc) sampler_tick,
+                              (gpointer) sampler,
+                              TRUE);
+    g_free(s);
+
+    return sampler;
+}
+
+
+
+/*
+ * ctk_sampler_subscribe() - registers the update function of a page.
+ * 'func' is called with 'data' at most every 'interval' milliseconds
+ * while it is started, and is stopped if it returns FALSE.
+ */
+
+void ctk_sampler_subscribe(CtkSampler *sampler, guint interval,
+                           GSourceFunc func, gpointer data)
+{
+    CtkSamplerSubscriber *sub = find_subscriber(sampler, func, data);
+
+    if (!sub) {
+        sub = g_new0(CtkSamplerSubscriber, 1);
+        sub->func = func;
+        sub->data = data;
+        sub->attributes = g_array_new(FALSE, FALSE,
+                                      sizeof(CtkSamplerAttribute));
+        sampler->subscribers = g_list_append(sampler->subscribers, sub);
+    }
+
+    sub->interval = interval;
+
+    /*
+     * The page fills itself in when it is built, which is right before
+     * it is first displayed; don't update it again when it is started.
+     */
+
+    sub->last_update = g_get_monotonic_time() / 1000;
+}
+
+
+
+/*
+ * ctk_sampler_unsubscribe() - called when a page goes away; stops and
+ * forgets its update function.  The sampler is freed, and its timer
+ * removed, once it has no subscribers left.
+ */
+
+void ctk_sampler_unsubscribe(CtkSampler *sampler, GSourceFunc func,
+                             gpointer data)
+{
+    CtkSamplerSubscriber *sub = find_subscriber(sampler, func, data);
+
+    if (!sub) {
+        return;
+    }
+
+    ctk_sampler_stop(sampler, func, data);
+
+    sampler->subscribers = g_list_remove(sampler->subscribers, sub);
+    g_array_free(sub->attributes, TRUE);
+    g_free(sub);
+
+    if (sampler->subscribers) {
+        return;
+    }
+
+    ctk_config_remove_timer(sampler->ctk_config,
+                            (GSourceFunc) sampler_tick,
+                            (gpointer) sampler);
+
+    __samplers = g_list_remove(__samplers, sampler);
+    g_free(sampler);
+}
+
+
+
+/*
+ * ctk_sampler_add_attribute() - adds an integer attribute read by the
+ * given subscriber to the set of attributes queried on each tick.
+ */
+
+void ctk_sampler_add_attribute(CtkSampler *sampler,
+                               GSourceFunc func, gpointer data,
+                               CtrlTarget *ctrl_target, int attr)
+{
+    CtkSamplerSubscriber *sub = find_subscriber(sampler, func, data);
+    CtkSamplerAttribute sample;
+
+    if (!sub || !ctrl_target) {
+        return;
+    }
+
+    /* Sampled values are handed over through the target's cache */
+
+    NvCtrlEnableAttributeCache(ctrl_target, TRUE);
+
+    sample.ctrl_target = ctrl_target;
+    sample.attr = attr;
+    g_array_append_val(sub->attributes, sample);
+}
+
+
+
+/*
+ * sampler_tick() - queries the union of the attributes of the subscribers
+ * that are due in a single batch, then calls their update functions.
+ */
+
+static gboolean sampler_tick(gpointer user_data)
+{
+    CtkSampler *sampler = user_data;
+    CtrlAttributeQuery *queries;
+    GList *due = NULL;
+    GList *l;
+    gint64 now;
+    int count = 0, max = 0;
+    guint i;
+    int j;
+
+    now = g_get_monotonic_time() / 1000;
+
+    for (l = sampler->subscribers; l; l = l->next) {
+        CtkSamplerSubscriber *sub = l->data;
+
+        if (sub->active &&
+            (now - sub->last_update + SAMPLER_SLACK_MS >= sub->interval)) {
+            due = g_list_append(due, sub);
+            max += sub->attributes->len;
+        }
+    }
+
+    if (!due) {
+        return TRUE;
+    }
+
+    /* Gather the attributes of the due subscribers, without duplicates */
+
+    queries = g_new0(CtrlAttributeQuery, max ? max : 1);
+
+    for (l = due; l; l = l->next) {
+        CtkSamplerSubscriber *sub = l->data;
+
+        for (i = 0; i < sub->attributes->len; i++) {
+            CtkSamplerAttribute *sample =
+                &g_array_index(sub->attributes, CtkSamplerAttribute, i);
+
+            for (j = 0; j < count; j++) {
+                if ((queries[j].ctrl_target == sample->ctrl_target) &&
+                    (queries[j].attr == sample->attr)) {
+                    break;
+                }
+            }
+            if (j == count) {
+                queries[count].ctrl_target = sample->ctrl_target;
+                queries[count].attr = sample->attr;
+                count++;
+            }
+        }
+    }
+
+    if (count) {
+        NvCtrlGetAttributesBatch(queries, count);
+    }
+    g_free(queries);
+
+    /* Fan the results out */
+
+    for (l = due; l; l = l->next) {
+        CtkSamplerSubscriber *sub = l->data;
+
+        sub->last_update = now;
+
+        if (!(*sub->func)(sub->data)) {
+            ctk_sampler_stop(sampler, sub->func, sub->data);
+        }
+    }
+
+    g_list_free(due);
+
+    return TRUE;
+}
+
+
+
+/*
+ * ctk_sampler_start() - called when a page is displayed; updates the page
+ * right away, unless it was updated less than an interval ago, and
+ * includes it in the following ticks.
+ */
+
+void ctk_sampler_start(CtkSampler *sampler, GSourceFunc func, gpointer data)
+{
+    CtkSamplerSubscriber *sub = find_subscriber(sampler, func, data);
+
+    if (!sub || sub->active) {
+        return;
+    }
+
+    sub->active = TRUE;
+
+    if (sampler->num_active++ == 0) {
+        /* This also fires the first tick */
+        ctk_config_start_timer(sampler->ctk_config,
+                               (GSourceFunc) sampler_tick,
+                               (gpointer) sampler);
+    } else {
+        sampler_tick(sampler);
+    }
+}
+
+
+
+void ctk_sampler_stop(CtkSampler *sampler, GSourceFunc func, gpointer data)
+{
+    CtkSamplerSubscriber *sub = find_subscriber(sampler, func, data);
+
+    if (!sub || !sub->active) {
+        return;
+    }
+
+    sub->active = FALSE;
+
+    if (--sampler->num_active == 0) {
+        ctk_config_stop_timer(sampler->ctk_config,
+                              (GSourceFunc) sampler_tick,
+                              (gpointer) sampler);
+    }
+}
@@ -0,0 +1,53 @@
+/*
+ * nvidia-settings: A tool for configuring the NVIDIA X driver on Unix
+ * and Linux systems.
+ *
+ * Copyright (C) 2024 NVIDIA Corporation.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses>.
+ */
+
+#ifndef __CTK_SAMPLER_H__
+#define __CTK_SAMPLER_H__
+
+#include <gtk/gtk.h>
+
+#include "NvCtrlAttributes.h"
+#include "ctkconfig.h"
+
+G_BEGIN_DECLS
+
+/*
+ * A CtkSampler drives the periodic updates of all the monitoring pages of
+ * one GPU from a single timer.  Pages subscribe an update function along
+ * with the integer attributes it reads; on each tick, the attributes of
+ * all the subscribers that are due are queried in one batch, which
+ * primes the attribute cache of their targets, and the update functions
+ * are then called and read the values back from that cache.
+ */
+
+typedef struct _CtkSampler CtkSampler;
+
+CtkSampler *ctk_sampler_get(CtkConfig *, CtrlTarget *);
+
+void ctk_sampler_subscribe(CtkSampler *, guint, GSourceFunc, gpointer);
+void ctk_sampler_unsubscribe(CtkSampler *, GSourceFunc, gpointer);
+void ctk_sampler_add_attribute(CtkSampler *, GSourceFunc, gpointer,
+                               CtrlTarget *, int);
+
+void ctk_sampler_start(CtkSampler *, GSourceFunc, gpointer);
+void ctk_sampler_stop(CtkSampler *, GSourceFunc, gpointer);
+
+G_END_DECLS
+
+#endif /* __CTK_SAMPLER_H__ */
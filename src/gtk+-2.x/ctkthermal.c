@@ -33,6 +33,7 @@
 
 static gboolean update_thermal_info(gpointer);
 static gboolean update_cooler_info(gpointer);
+static void subscribe_thermal_info(CtkThermal *ctk_thermal);
 static void sync_gui_sensitivity(CtkThermal *ctk_thermal);
 static void sync_gui_to_modify_cooler_level(CtkThermal *ctk_thermal);
 static gboolean sync_gui_to_update_cooler_event(gpointer user_data);
@@ -129,6 +130,11 @@ static const char * __reset_button_help =
 "The Reset Hardware Defaults button lets you restore the original GPU "
 "Fan Speed and Fan control policy.";
 
+static void ctk_thermal_class_init(CtkThermalClass *, gpointer);
+static void ctk_thermal_finalize(GObject *);
+
+static GObjectClass *parent_class = NULL;
+
 GType ctk_thermal_get_type(void)
 {
     static GType ctk_thermal_type = 0;
@@ -138,7 +144,7 @@ GType ctk_thermal_get_type(void)
             sizeof (CtkThermalClass),
             NULL, /* base_init */
             NULL, /* base_finalize */
-            NULL, /* constructor */
+            (GClassInitFunc) ctk_thermal_class_init, /* constructor */
             NULL, /* class_finalize */
             NULL, /* class_data */
             sizeof (CtkThermal),
@@ -158,6 +164,34 @@ GType ctk_thermal_get_type(void)
 
 
 
+static void ctk_thermal_class_init(CtkThermalClass *ctk_thermal_class,
+                                   gpointer class_data)
+{
+    GObjectClass *gobject_class = (GObjectClass *)ctk_thermal_class;
+
+    parent_class = (GObjectClass *)g_type_class_peek_parent(ctk_thermal_class);
+    gobject_class->finalize = ctk_thermal_finalize;
+}
+
+
+
+static void ctk_thermal_finalize(GObject *object)
+{
+    CtkThermal *ctk_thermal = CTK_THERMAL(object);
+
+    /* Stop sampling for this page */
+
+    if (ctk_thermal->sampler) {
+        ctk_sampler_unsubscribe(ctk_thermal->sampler,
+                                (GSourceFunc) update_thermal_info,
+                                (gpointer) ctk_thermal);
+    }
+
+    parent_class->finalize(object);
+}
+
+
+
 /*
  * update_cooler_info() - Update all cooler information
  */
@@ -441,6 +475,66 @@ static gboolean update_thermal_info(gpointer user_data)
 
 
 
+/*
+ * subscribe_thermal_info() - register update_thermal_info() with the GPU
+ * sampler, along with the integer attributes it reads.
+ */
+
+static void subscribe_thermal_info(CtkThermal *ctk_thermal)
+{
+    CtkSampler *sampler;
+    GSourceFunc func = (GSourceFunc) update_thermal_info;
+    int i;
+
+    sampler = ctk_sampler_get(ctk_thermal->ctk_config,
+                              ctk_thermal->ctrl_target);
+    ctk_thermal->sampler = sampler;
+
+    ctk_sampler_subscribe(sampler, DEFAULT_UPDATE_THERMAL_INFO_TIME_INTERVAL,
+                          func, ctk_thermal);
+
+    if (!ctk_thermal->thermal_sensor_target_type_supported) {
+        ctk_sampler_add_attribute(sampler, func, ctk_thermal,
+                                  ctk_thermal->ctrl_target,
+                                  NV_CTRL_GPU_CORE_TEMPERATURE);
+        if (ctk_thermal->ambient_label) {
+            ctk_sampler_add_attribute(sampler, func, ctk_thermal,
+                                      ctk_thermal->ctrl_target,
+                                      NV_CTRL_AMBIENT_TEMPERATURE);
+        }
+    } else {
+        for (i = 0; i < ctk_thermal->sensor_count; i++) {
+            ctk_sampler_add_attribute(sampler, func, ctk_thermal,
+                                      ctk_thermal->sensor_info[i].ctrl_target,
+                                      NV_CTRL_THERMAL_SENSOR_READING);
+        }
+    }
+
+    if (ctk_thermal->cooler_count) {
+        ctk_sampler_add_attribute(sampler, func, ctk_thermal,
+                                  ctk_thermal->ctrl_target,
+                                  NV_CTRL_GPU_COOLER_MANUAL_CONTROL);
+    }
+
+    for (i = 0; i < ctk_thermal->cooler_count; i++) {
+        CtrlTarget *cooler_target = ctk_thermal->cooler_control[i].ctrl_target;
+
+        ctk_sampler_add_attribute(sampler, func, ctk_thermal, cooler_target,
+                                  NV_CTRL_THERMAL_COOLER_CONTROL_TYPE);
+        ctk_sampler_add_attribute(sampler, func, ctk_thermal, cooler_target,
+                                  NV_CTRL_THERMAL_COOLER_TARGET);
+        ctk_sampler_add_attribute(sampler, func, ctk_thermal, cooler_target,
+                                  NV_CTRL_THERMAL_COOLER_SPEED);
+        ctk_sampler_add_attribute(sampler, func, ctk_thermal, cooler_target,
+                                  NV_CTRL_THERMAL_COOLER_CURRENT_LEVEL);
+        ctk_sampler_add_attribute(sampler, func, ctk_thermal, cooler_target,
+                                  NV_CTRL_THERMAL_COOLER_LEVEL);
+    }
+
+} /* subscribe_thermal_info() */
+
+
+
 /****
  *
  * Updates widgets in relation to current cooler control state.
@@ -1118,6 +1212,57 @@ static void draw_sensor_gui(GtkWidget *vbox1, CtkThermal *ctk_thermal,
 
 
 
+/*
+ * ctk_thermal_available() - returns whether ctk_thermal_new() would build
+ * a page for the given GPU, without building it.
+ */
+
+gboolean ctk_thermal_available(CtrlTarget *ctrl_target)
+{
+    ReturnStatus ret, ret1;
+    int major = 0, minor = 0, core, len;
+    int *pData = NULL;
+    gint count = 0;
+
+    ret = NvCtrlGetAttribute(ctrl_target,
+                             NV_CTRL_ATTR_NV_MAJOR_VERSION, &major);
+    ret1 = NvCtrlGetAttribute(ctrl_target,
+                              NV_CTRL_ATTR_NV_MINOR_VERSION, &minor);
+
+    if ((ret != NvCtrlSuccess) || (ret1 != NvCtrlSuccess) ||
+        ((major < 1) || ((major == 1) && (minor <= 22)))) {
+        ret = NvCtrlGetAttribute(ctrl_target, NV_CTRL_GPU_CORE_TEMPERATURE,
+                                 &core);
+        return (ret == NvCtrlSuccess);
+    }
+
+    ret = NvCtrlGetBinaryAttribute(ctrl_target, 0,
+                                   NV_CTRL_BINARY_DATA_THERMAL_SENSORS_USED_BY_GPU,
+                                   (unsigned char **)(&pData), &len);
+    if (ret == NvCtrlSuccess) {
+        count = pData[0];
+    }
+    free(pData);
+    pData = NULL;
+
+    if (count) {
+        return TRUE;
+    }
+
+    ret = NvCtrlGetBinaryAttribute(ctrl_target, 0,
+                                   NV_CTRL_BINARY_DATA_COOLERS_USED_BY_GPU,
+                                   (unsigned char **)(&pData), &len);
+    if (ret == NvCtrlSuccess) {
+        count = pData[0];
+    }
+    free(pData);
+
+    return (count != 0);
+
+} /* ctk_thermal_available() */
+
+
+
 GtkWidget* ctk_thermal_new(CtrlTarget *ctrl_target,
                            CtkConfig *ctk_config,
                            CtkEvent *ctk_event)
@@ -1661,17 +1806,9 @@ end:
     sync_gui_to_modify_cooler_level(ctk_thermal);
     update_thermal_info(ctk_thermal);
     
-    /* Register a timer callback to update the temperatures */
-
-    s = g_strdup_printf("Thermal Monitor (GPU %d)",
-                        NvCtrlGetTargetId(ctrl_target));
+    /* Subscribe to the GPU sampler to update the temperatures */
 
-    ctk_config_add_timer(ctk_thermal->ctk_config,
-                         DEFAULT_UPDATE_THERMAL_INFO_TIME_INTERVAL,
-                         s,
-                         (GSourceFunc) update_thermal_info,
-                         (gpointer) ctk_thermal);
-    g_free(s);
+    subscribe_thermal_info(ctk_thermal);
     
     gtk_widget_show_all(GTK_WIDGET(ctk_thermal));
     
@@ -1776,20 +1913,20 @@ void ctk_thermal_start_timer(GtkWidget *widget)
 {
     CtkThermal *ctk_thermal = CTK_THERMAL(widget);
 
-    /* Start the thermal timer */
+    /* Start the thermal updates */
 
-    ctk_config_start_timer(ctk_thermal->ctk_config,
-                           (GSourceFunc) update_thermal_info,
-                           (gpointer) ctk_thermal);
+    ctk_sampler_start(ctk_thermal->sampler,
+                      (GSourceFunc) update_thermal_info,
+                      (gpointer) ctk_thermal);
 }
 
 void ctk_thermal_stop_timer(GtkWidget *widget)
 {
     CtkThermal *ctk_thermal = CTK_THERMAL(widget);
 
-    /* Stop the thermal timer */
+    /* Stop the thermal updates */
 
-    ctk_config_stop_timer(ctk_thermal->ctk_config,
-                          (GSourceFunc) update_thermal_info,
-                          (gpointer) ctk_thermal);
+    ctk_sampler_stop(ctk_thermal->sampler,
+                     (GSourceFunc) update_thermal_info,
+                     (gpointer) ctk_thermal);
 }
@@ -22,6 +22,7 @@
 
 #include "ctkconfig.h"
 #include "ctkevent.h"
+#include "ctksampler.h"
 
 G_BEGIN_DECLS
 
@@ -80,6 +81,7 @@ struct _CtkThermal
 
     CtrlTarget *ctrl_target;
     CtkConfig *ctk_config;
+    CtkSampler *sampler;
 
     GtkWidget *core_label;
     GtkWidget *core_gauge;
@@ -113,6 +115,7 @@ struct _CtkThermalClass
 };
 
 GType          ctk_thermal_get_type    (void) G_GNUC_CONST;
+gboolean       ctk_thermal_available   (CtrlTarget *);
 GtkWidget*     ctk_thermal_new         (CtrlTarget *, CtkConfig *, CtkEvent *);
 GtkTextBuffer* ctk_thermal_create_help (GtkTextTagTable *, CtkThermal *);
 
@@ -1422,6 +1422,65 @@ GType ctk_vdpau_get_type(void)
 
 
 
+/*
+ * ctk_vdpau_available() - returns whether ctk_vdpau_new() would build a
+ * page for the given X screen: the VDPAU library must load, and a VDPAU
+ * device providing the queried functions must be created on the screen.
+ */
+
+gboolean ctk_vdpau_available(CtrlTarget *ctrl_target)
+{
+    void *vdpau_handle = NULL;
+    VdpDevice device;
+    VdpGetProcAddress *getProcAddress = NULL;
+    VdpStatus ret;
+    VdpDeviceCreateX11 *VDPAUDeviceCreateX11 = NULL;
+    VdpDeviceDestroy *VDPAUDeviceDestroy = NULL;
+    struct VDPAUDeviceImpl VDPAUDeviceFunctions;
+    gboolean available = FALSE;
+
+    if ((ctrl_target == NULL) || (ctrl_target->h == NULL)) {
+        return FALSE;
+    }
+
+    vdpau_handle = dlopen("libvdpau.so.1", RTLD_NOW);
+    if (!vdpau_handle) {
+        return FALSE;
+    }
+
+    VDPAUDeviceCreateX11 = dlsym(vdpau_handle, "vdp_device_create_x11");
+    if (!VDPAUDeviceCreateX11) {
+        goto done;
+    }
+
+    ret = VDPAUDeviceCreateX11(NvCtrlGetDisplayPtr(ctrl_target),
+                               NvCtrlGetScreen(ctrl_target),
+                               &device, &getProcAddress);
+
+    if ((ret != VDP_STATUS_OK) || !device || !getProcAddress) {
+        goto done;
+    }
+
+    available = getAddressVDPAUDeviceFunctions(device, getProcAddress,
+                                               &VDPAUDeviceFunctions);
+
+    /* the page creates its own device */
+
+    getProcAddress(device, VDP_FUNC_ID_DEVICE_DESTROY,
+                   (void**)&VDPAUDeviceDestroy);
+    if (VDPAUDeviceDestroy) {
+        VDPAUDeviceDestroy(device);
+    }
+
+ done:
+    dlclose(vdpau_handle);
+
+    return available;
+
+} /* ctk_vdpau_available() */
+
+
+
 GtkWidget* ctk_vdpau_new(CtrlTarget *ctrl_target, CtkConfig *ctk_config,
                          CtkEvent *ctk_event)
 {
@@ -73,6 +73,7 @@ struct _CtkVDPAUClass
 };
 
 GType          ctk_vdpau_get_type    (void) G_GNUC_CONST;
+gboolean       ctk_vdpau_available   (CtrlTarget *);
 GtkWidget*     ctk_vdpau_new         (CtrlTarget *, CtkConfig *, CtkEvent *);
 GtkTextBuffer* ctk_vdpau_create_help (GtkTextTagTable *, CtkVDPAU *);
 
@@ -81,6 +81,7 @@ enum {
     CTK_WINDOW_CONFIG_FILE_ATTRIBUTES_FUNC_COLUMN,
     CTK_WINDOW_SELECT_WIDGET_FUNC_COLUMN,
     CTK_WINDOW_UNSELECT_WIDGET_FUNC_COLUMN,
+    CTK_WINDOW_DEFERRED_PAGE_COLUMN,
     CTK_WINDOW_NUM_COLUMNS
 };
 
@@ -88,6 +89,7 @@ enum {
 typedef struct {
     CtkWindow *window;
     CtrlTarget *gpu_target;
+    CtkEvent *gpu_event;
     GtkTextTagTable *tag_table;
 
     GtkTreeIter parent_iter;
@@ -103,6 +105,24 @@ typedef void (*config_file_attributes_func_t)(GtkWidget *, ParsedAttribute *);
 typedef void (*select_widget_func_t)(GtkWidget *);
 typedef void (*unselect_widget_func_t)(GtkWidget *);
 
+
+/*
+ * Pages which are only built the first time they are selected; see
+ * add_deferred_page().  The create function returns the page widget and
+ * its help buffer, or NULL if the page could not be built.
+ */
+
+typedef struct _DeferredPage DeferredPage;
+
+typedef GtkWidget *(*create_page_func_t)(DeferredPage *, GtkTextBuffer **);
+
+struct _DeferredPage {
+    create_page_func_t create_func;
+    CtkWindow *ctk_window;
+    CtrlTarget *ctrl_target;
+    CtkEvent *ctk_event;
+};
+
 static void ctk_window_class_init(CtkWindowClass *, gpointer);
 
 #ifdef CTK_GTK3
@@ -117,6 +137,23 @@ static void add_page(GtkWidget *, GtkTextBuffer *, CtkWindow *,
                      select_widget_func_t load_func,
                      unselect_widget_func_t unload_func);
 
+static void add_deferred_page(CtkWindow *, GtkTreeIter *, GtkTreeIter *,
+                              const gchar *, create_page_func_t,
+                              CtrlTarget *, CtkEvent *,
+                              select_widget_func_t select_func,
+                              unselect_widget_func_t unselect_func);
+
+static GtkWidget *build_deferred_page(CtkWindow *, GtkTreeIter *);
+
+static GtkWidget *create_gpu_page(DeferredPage *, GtkTextBuffer **);
+static GtkWidget *create_thermal_page(DeferredPage *, GtkTextBuffer **);
+static GtkWidget *create_powermizer_page(DeferredPage *, GtkTextBuffer **);
+static GtkWidget *create_ecc_page(DeferredPage *, GtkTextBuffer **);
+static GtkWidget *create_glx_page(DeferredPage *, GtkTextBuffer **);
+static GtkWidget *create_vdpau_page(DeferredPage *, GtkTextBuffer **);
+static GtkWidget *create_display_config_page(DeferredPage *, GtkTextBuffer **);
+static GtkWidget *create_app_profile_page(DeferredPage *, GtkTextBuffer **);
+
 static GtkWidget *create_quit_dialog(CtkWindow *ctk_window);
 
 static void quit_response(GtkWidget *, gint, gpointer);
@@ -323,6 +360,29 @@ static gboolean ctk_window_delete_event(GObject *object)
 
 
 
+/*
+ * ctk_window_state_event() - suspend the page timers while the window is
+ * iconified or withdrawn, so that nothing is polled while no page is
+ * visible; they are resumed (and fired once) when the window is shown.
+ */
+
+static gboolean ctk_window_state_event(GtkWidget *widget,
+                                       GdkEventWindowState *event,
+                                       gpointer user_data)
+{
+    CtkWindow *ctk_window = CTK_WINDOW(user_data);
+    gboolean hidden;
+
+    hidden = (event->new_window_state &
+              (GDK_WINDOW_STATE_ICONIFIED | GDK_WINDOW_STATE_WITHDRAWN)) != 0;
+
+    ctk_config_suspend_timers(ctk_window->ctk_config, hidden);
+
+    return FALSE;
+}
+
+
+
 /*
  * help_button_toggled() - callback when the help button is toggled;
  * hides or shows the help window.
@@ -373,7 +433,13 @@ static void tree_selection_changed(GtkTreeSelection *selection,
     if (!gtk_tree_selection_get_selected(selection, &model, &iter))
         return;
 
+    /* build the page, if this is the first time it is selected */
+
     gtk_tree_model_get(model, &iter, CTK_WINDOW_WIDGET_COLUMN, &widget, -1);
+    if (!widget) {
+        widget = build_deferred_page(ctk_window, &iter);
+    }
+
     gtk_tree_model_get(model, &iter, CTK_WINDOW_HELP_COLUMN, &help, -1);
     gtk_tree_model_get(model, &iter, CTK_WINDOW_SELECT_WIDGET_FUNC_COLUMN,
                        &select_func, -1);
@@ -607,7 +673,8 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
                            G_TYPE_POINTER,  /* Help widget */
                            G_TYPE_POINTER,  /* Config file attr func */
                            G_TYPE_POINTER,  /* Load widget func */
-                           G_TYPE_POINTER); /* Unload widget func */
+                           G_TYPE_POINTER,  /* Unload widget func */
+                           G_TYPE_POINTER); /* Deferred page */
     model = GTK_TREE_MODEL(ctk_window->tree_store);
 
     /* create the tree view */
@@ -696,33 +763,21 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
                                CTK_WINDOW_CONFIG_FILE_ATTRIBUTES_FUNC_COLUMN,
                                NULL, -1);
 
-            child = ctk_glx_new(default_gpu_target, ctk_config, ctk_event);
-            if (child) {
-                help = ctk_glx_create_help(tag_table, CTK_GLX(child));
-                add_page(child, help, ctk_window, &iter, NULL,
-                             "Graphics Information", NULL, ctk_glx_probe_info, NULL);
-            }
+            add_deferred_page(ctk_window, &iter, NULL,
+                              "Graphics Information", create_glx_page,
+                              default_gpu_target, ctk_event,
+                              ctk_glx_probe_info, NULL);
         }
     }
 
     /* X Server Display Configuration */
 
     if (default_x_target) {
-
-        GtkWidget *child;
-
-        child = ctk_display_config_new(default_x_target, ctk_config);
-        if (child) {
-            ctk_window->display_config_widget = child;
-            add_page(child,
-                     ctk_display_config_create_help(tag_table,
-                                                    CTK_DISPLAY_CONFIG(child)),
-                     ctk_window, NULL, NULL,
-                     "X Server Display Configuration",
-                     NULL, ctk_display_config_selected,
-                     ctk_display_config_unselected);
-
-        }
+        add_deferred_page(ctk_window, NULL, NULL,
+                          "X Server Display Configuration",
+                          create_display_config_page, default_x_target, NULL,
+                          ctk_display_config_selected,
+                          ctk_display_config_unselected);
     }
 
     /* Platform Power Mode */
@@ -816,12 +871,10 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
         /* Graphics Information */
 
         if (system->has_nv_control) {
-            child = ctk_glx_new(screen_target, ctk_config, ctk_event);
-            if (child) {
-                help = ctk_glx_create_help(tag_table, CTK_GLX(child));
-                add_page(child, help, ctk_window, &iter, NULL,
-                         "Graphics Information", NULL, ctk_glx_probe_info, NULL);
-            }
+            add_deferred_page(ctk_window, &iter, NULL,
+                              "Graphics Information", create_glx_page,
+                              screen_target, ctk_event,
+                              ctk_glx_probe_info, NULL);
         }
 
 
@@ -837,11 +890,11 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
 
 
         /* VDPAU Information */
-        child = ctk_vdpau_new(screen_target, ctk_config, ctk_event);
-        if (child) {
-            help = ctk_vdpau_create_help(tag_table, CTK_VDPAU(child));
-            add_page(child, help, ctk_window, &iter, NULL, "VDPAU Information",
-                     NULL, NULL, NULL);
+
+        if (ctk_vdpau_available(screen_target)) {
+            add_deferred_page(ctk_window, &iter, NULL, "VDPAU Information",
+                              create_vdpau_page, screen_target, ctk_event,
+                              NULL, NULL);
         }
     }
 
@@ -850,7 +903,6 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
     for (node = system->targets[GPU_TARGET]; node; node = node->next) {
 
         gchar *gpu_name;
-        GtkWidget *child;
         CtrlTarget *gpu_target = node->t;
         UpdateDisplaysData *data;
 
@@ -868,60 +920,49 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
 
         ctk_event = CTK_EVENT(ctk_event_new(gpu_target));
 
-        /* create the gpu entry */
+        /*
+         * the GPU pages read many of the same attributes; let them share
+         * the values instead of each querying the server
+         */
 
-        gtk_tree_store_append(ctk_window->tree_store, &iter, NULL);
-        gtk_tree_store_set(ctk_window->tree_store, &iter,
-                           CTK_WINDOW_LABEL_COLUMN, gpu_name, -1);
+        NvCtrlEnableAttributeCache(gpu_target, TRUE);
 
-        child = ctk_gpu_new(gpu_target, ctk_event, ctk_config);
+        /* create the gpu entry */
 
-        g_object_ref(G_OBJECT(child));
-        gtk_tree_store_set(ctk_window->tree_store, &iter,
-                           CTK_WINDOW_WIDGET_COLUMN, child, -1);
-        gtk_tree_store_set(ctk_window->tree_store, &iter,
-                           CTK_WINDOW_HELP_COLUMN, 
-                           ctk_gpu_create_help(tag_table, CTK_GPU(child)), -1);
-        gtk_tree_store_set(ctk_window->tree_store, &iter,
-                           CTK_WINDOW_CONFIG_FILE_ATTRIBUTES_FUNC_COLUMN,
-                           NULL, -1);
-        gtk_tree_store_set(ctk_window->tree_store, &iter,
-                           CTK_WINDOW_SELECT_WIDGET_FUNC_COLUMN,
-                           ctk_gpu_page_select, -1);
-        gtk_tree_store_set(ctk_window->tree_store, &iter,
-                           CTK_WINDOW_UNSELECT_WIDGET_FUNC_COLUMN,
-                           ctk_gpu_page_unselect, -1);
+        add_deferred_page(ctk_window, NULL, &iter, gpu_name, create_gpu_page,
+                          gpu_target, ctk_event, ctk_gpu_page_select,
+                          ctk_gpu_page_unselect);
 
         /* thermal information */
 
-        child = ctk_thermal_new(gpu_target, ctk_config, ctk_event);
-        if (child) {
-            help = ctk_thermal_create_help(tag_table, CTK_THERMAL(child));
-            add_page(child, help, ctk_window, &iter, NULL, "Thermal Settings",
-                     NULL, ctk_thermal_start_timer, ctk_thermal_stop_timer);
+        if (ctk_thermal_available(gpu_target)) {
+            add_deferred_page(ctk_window, &iter, NULL, "Thermal Settings",
+                              create_thermal_page, gpu_target, ctk_event,
+                              ctk_thermal_start_timer, ctk_thermal_stop_timer);
         }
 
         /* Powermizer information */
-        child = ctk_powermizer_new(gpu_target, ctk_config, ctk_event);
-        if (child) {
-            help = ctk_powermizer_create_help(tag_table, CTK_POWERMIZER(child));
-            add_page(child, help, ctk_window, &iter, NULL, "PowerMizer",
-                     NULL, ctk_powermizer_start_timer, 
-                     ctk_powermizer_stop_timer);
+
+        if (ctk_powermizer_available(gpu_target)) {
+            add_deferred_page(ctk_window, &iter, NULL, "PowerMizer",
+                              create_powermizer_page, gpu_target, ctk_event,
+                              ctk_powermizer_start_timer,
+                              ctk_powermizer_stop_timer);
         }
 
         /* ECC Information */
-        child = ctk_ecc_new(gpu_target, ctk_config, ctk_event);
-        if (child) {
-            help = ctk_ecc_create_help(tag_table, CTK_ECC(child));
-            add_page(child, help, ctk_window, &iter, NULL, "ECC Settings",
-                     NULL, ctk_ecc_start_timer, ctk_ecc_stop_timer);
+
+        if (ctk_ecc_available(gpu_target)) {
+            add_deferred_page(ctk_window, &iter, NULL, "ECC Settings",
+                              create_ecc_page, gpu_target, ctk_event,
+                              ctk_ecc_start_timer, ctk_ecc_stop_timer);
         }
 
         /* display devices */
         data = calloc(1, sizeof(*data));
         data->window = ctk_window;
         data->gpu_target = gpu_target;
+        data->gpu_event = ctk_event;
         data->parent_iter = iter;
         data->tag_table = tag_table;
 
@@ -941,7 +982,9 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
 
     /*
      * add the frame lock page, if any of the X screens support
-     * frame lock
+     * frame lock; unlike the pages above, it is built up front, since
+     * it applies the frame lock settings of the parsed attribute list
+     * at startup and writes them back when the configuration is saved
      */
 
     for (node = system->targets[X_SCREEN_TARGET]; node; node = node->next) {
@@ -991,12 +1034,8 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
     }
 
     /* app profile configuration */
-    widget = ctk_app_profile_new(ctrl_target, ctk_config);
-    if (widget) {
-        add_page(widget, ctk_app_profile_create_help(CTK_APP_PROFILE(widget), tag_table),
-                 ctk_window, NULL, NULL, "Application Profiles",
-                 NULL, NULL, NULL);
-    }
+    add_deferred_page(ctk_window, NULL, NULL, "Application Profiles",
+                      create_app_profile_page, ctrl_target, NULL, NULL, NULL);
 
     /* Manage GRID License Information */
     for (node = system->targets[GPU_TARGET]; node; node = node->next) {
@@ -1080,6 +1119,11 @@ GtkWidget *ctk_window_new(ParsedAttribute *p, ConfigProperties *conf,
 
     g_signal_connect(G_OBJECT(ctk_window), "delete-event",
                      G_CALLBACK(ctk_window_delete_event), (gpointer) ctk_window);
+
+    /* Stop polling while the window is minimized or unmapped */
+
+    g_signal_connect(G_OBJECT(ctk_window), "window-state-event",
+                     G_CALLBACK(ctk_window_state_event), (gpointer) ctk_window);
     
     return GTK_WIDGET(object);
 
@@ -1219,6 +1263,236 @@ static void add_page(GtkWidget *widget, GtkTextBuffer *help,
 
 
 
+/*
+ * add_deferred_page() - add a new page entry to ctk_window's tree_store,
+ * like add_page(), but without building the page yet: 'create_func' is
+ * called to build it the first time the entry is selected, so that only
+ * the pages actually looked at pay for their queries and timers.
+ */
+
+static void add_deferred_page(CtkWindow *ctk_window, GtkTreeIter *iter,
+                              GtkTreeIter *child_iter, const gchar *label,
+                              create_page_func_t create_func,
+                              CtrlTarget *ctrl_target, CtkEvent *ctk_event,
+                              select_widget_func_t select_func,
+                              unselect_widget_func_t unselect_func)
+{
+    GtkTreeIter tmp_child_iter;
+    DeferredPage *page;
+
+    if (!child_iter) child_iter = &tmp_child_iter;
+
+    page = nvalloc(sizeof(DeferredPage));
+    page->create_func = create_func;
+    page->ctk_window = ctk_window;
+    page->ctrl_target = ctrl_target;
+    page->ctk_event = ctk_event;
+
+    gtk_tree_store_append(ctk_window->tree_store, child_iter, iter);
+
+    gtk_tree_store_set(ctk_window->tree_store, child_iter,
+                       CTK_WINDOW_LABEL_COLUMN, label,
+                       CTK_WINDOW_WIDGET_COLUMN, NULL,
+                       CTK_WINDOW_HELP_COLUMN, NULL,
+                       CTK_WINDOW_CONFIG_FILE_ATTRIBUTES_FUNC_COLUMN, NULL,
+                       CTK_WINDOW_SELECT_WIDGET_FUNC_COLUMN, select_func,
+                       CTK_WINDOW_UNSELECT_WIDGET_FUNC_COLUMN, unselect_func,
+                       CTK_WINDOW_DEFERRED_PAGE_COLUMN, page,
+                       -1);
+
+} /* add_deferred_page() */
+
+
+
+/*
+ * build_deferred_page() - build the page of the deferred entry at 'iter',
+ * and store it in the tree_store in place of the deferred page.  Returns
+ * the page widget, or NULL if the entry has no deferred page.
+ */
+
+static GtkWidget *build_deferred_page(CtkWindow *ctk_window, GtkTreeIter *iter)
+{
+    GtkTreeModel *model = GTK_TREE_MODEL(ctk_window->tree_store);
+    GtkTextBuffer *help = NULL;
+    DeferredPage *page;
+    GtkWidget *widget;
+
+    gtk_tree_model_get(model, iter, CTK_WINDOW_DEFERRED_PAGE_COLUMN, &page,
+                       -1);
+    if (!page) {
+        return NULL;
+    }
+
+    widget = page->create_func(page, &help);
+    if (!widget) {
+
+        /*
+         * the select and unselect functions expect the page widget; do
+         * not hand them the placeholder
+         */
+
+        widget = gtk_label_new("This page is not available.");
+        gtk_widget_show(widget);
+
+        gtk_tree_store_set(ctk_window->tree_store, iter,
+                           CTK_WINDOW_SELECT_WIDGET_FUNC_COLUMN, NULL,
+                           CTK_WINDOW_UNSELECT_WIDGET_FUNC_COLUMN, NULL,
+                           -1);
+    }
+
+    g_object_ref(G_OBJECT(widget));
+    ctk_g_object_ref_sink(G_OBJECT(widget));
+
+    gtk_tree_store_set(ctk_window->tree_store, iter,
+                       CTK_WINDOW_WIDGET_COLUMN, widget,
+                       CTK_WINDOW_HELP_COLUMN, help,
+                       CTK_WINDOW_DEFERRED_PAGE_COLUMN, NULL,
+                       -1);
+
+    free(page);
+
+    return widget;
+
+} /* build_deferred_page() */
+
+
+
+/*
+ * Create functions for the deferred pages
+ */
+
+static GtkWidget *create_gpu_page(DeferredPage *page, GtkTextBuffer **help)
+{
+    CtkWindow *ctk_window = page->ctk_window;
+    GtkWidget *widget;
+
+    widget = ctk_gpu_new(page->ctrl_target, page->ctk_event,
+                         ctk_window->ctk_config);
+    if (widget) {
+        *help = ctk_gpu_create_help(ctk_window->help_tag_table,
+                                    CTK_GPU(widget));
+    }
+
+    return widget;
+}
+
+
+static GtkWidget *create_thermal_page(DeferredPage *page,
+                                      GtkTextBuffer **help)
+{
+    CtkWindow *ctk_window = page->ctk_window;
+    GtkWidget *widget;
+
+    widget = ctk_thermal_new(page->ctrl_target, ctk_window->ctk_config,
+                             page->ctk_event);
+    if (widget) {
+        *help = ctk_thermal_create_help(ctk_window->help_tag_table,
+                                        CTK_THERMAL(widget));
+    }
+
+    return widget;
+}
+
+
+static GtkWidget *create_powermizer_page(DeferredPage *page,
+                                         GtkTextBuffer **help)
+{
+    CtkWindow *ctk_window = page->ctk_window;
+    GtkWidget *widget;
+
+    widget = ctk_powermizer_new(page->ctrl_target, ctk_window->ctk_config,
+                                page->ctk_event);
+    if (widget) {
+        *help = ctk_powermizer_create_help(ctk_window->help_tag_table,
+                                           CTK_POWERMIZER(widget));
+    }
+
+    return widget;
+}
+
+
+static GtkWidget *create_ecc_page(DeferredPage *page, GtkTextBuffer **help)
+{
+    CtkWindow *ctk_window = page->ctk_window;
+    GtkWidget *widget;
+
+    widget = ctk_ecc_new(page->ctrl_target, ctk_window->ctk_config,
+                         page->ctk_event);
+    if (widget) {
+        *help = ctk_ecc_create_help(ctk_window->help_tag_table,
+                                    CTK_ECC(widget));
+    }
+
+    return widget;
+}
+
+
+static GtkWidget *create_glx_page(DeferredPage *page, GtkTextBuffer **help)
+{
+    CtkWindow *ctk_window = page->ctk_window;
+    GtkWidget *widget;
+
+    widget = ctk_glx_new(page->ctrl_target, ctk_window->ctk_config,
+                         page->ctk_event);
+    if (widget) {
+        *help = ctk_glx_create_help(ctk_window->help_tag_table,
+                                    CTK_GLX(widget));
+    }
+
+    return widget;
+}
+
+
+static GtkWidget *create_vdpau_page(DeferredPage *page, GtkTextBuffer **help)
+{
+    CtkWindow *ctk_window = page->ctk_window;
+    GtkWidget *widget;
+
+    widget = ctk_vdpau_new(page->ctrl_target, ctk_window->ctk_config,
+                           page->ctk_event);
+    if (widget) {
+        *help = ctk_vdpau_create_help(ctk_window->help_tag_table,
+                                      CTK_VDPAU(widget));
+    }
+
+    return widget;
+}
+
+
+static GtkWidget *create_display_config_page(DeferredPage *page,
+                                             GtkTextBuffer **help)
+{
+    CtkWindow *ctk_window = page->ctk_window;
+    GtkWidget *widget;
+
+    widget = ctk_display_config_new(page->ctrl_target, ctk_window->ctk_config);
+    if (widget) {
+        ctk_window->display_config_widget = widget;
+        *help = ctk_display_config_create_help(ctk_window->help_tag_table,
+                                               CTK_DISPLAY_CONFIG(widget));
+    }
+
+    return widget;
+}
+
+
+static GtkWidget *create_app_profile_page(DeferredPage *page,
+                                          GtkTextBuffer **help)
+{
+    CtkWindow *ctk_window = page->ctk_window;
+    GtkWidget *widget;
+
+    widget = ctk_app_profile_new(page->ctrl_target, ctk_window->ctk_config);
+    if (widget) {
+        *help = ctk_app_profile_create_help(CTK_APP_PROFILE(widget),
+                                            ctk_window->help_tag_table);
+    }
+
+    return widget;
+}
+
+
+
 /*
  * create_quit_dialog() - create a dialog box to prompt the user
  * whether they really want to quit.
@@ -1602,11 +1876,7 @@ static void update_display_devices(GtkWidget *object,
 
     /* Add back all the connected display devices */
 
-    gtk_tree_model_get(GTK_TREE_MODEL(ctk_window->tree_store), &parent_iter,
-                       CTK_WINDOW_WIDGET_COLUMN, &widget, -1);
-
-    add_display_devices(ctk_window, &parent_iter, gpu_target,
-                        CTK_GPU(widget)->ctk_event,
+    add_display_devices(ctk_window, &parent_iter, gpu_target, data->gpu_event,
                         tag_table, data, ctk_window->attribute_list);
 
     /* Expand the GPU entry if it used to be */
@@ -346,6 +346,128 @@ Bool XNVCTRLSetAttributeAndGetStatus (
 }
 
 
+/*
+ * State shared with the async reply handler of
+ * XNVCTRLSetTargetAttributesAndGetStatus(), as for
+ * XNVCTRLQueryTargetAttributes64().
+ */
+
+typedef struct {
+    unsigned long first_seq;
+    unsigned long last_seq;
+    XNVCTRLAttributeAssignment *assignments;
+} XNVCTRLSetAttributesState;
+
+static Bool SetAttributesHandler(
+    Display *dpy,
+    xReply *rep,
+    char *buf,
+    int len,
+    XPointer data
+){
+    XNVCTRLSetAttributesState *state = (XNVCTRLSetAttributesState *)data;
+    xnvCtrlSetAttributeAndGetStatusReply replbuf, *repl;
+    unsigned long seq = dpy->last_request_read;
+
+    if ((seq < state->first_seq) || (seq > state->last_seq)) {
+        return False;
+    }
+
+    /* Let the error handler report failed assignments; 'success' stays False */
+    if (rep->generic.type == X_Error) {
+        return False;
+    }
+
+    repl = (xnvCtrlSetAttributeAndGetStatusReply *)
+        _XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+                        (SIZEOF(xnvCtrlSetAttributeAndGetStatusReply) -
+                         SIZEOF(xReply)) >> 2,
+                        True);
+
+    state->assignments[seq - state->first_seq].success = repl->flags;
+    return True;
+}
+
+Bool XNVCTRLSetTargetAttributesAndGetStatus (
+    Display *dpy,
+    XNVCTRLAttributeAssignment *assignments,
+    int count
+){
+    XExtDisplayInfo *info = find_display(dpy);
+    XNVCTRLSetAttributesState state;
+    xnvCtrlSetAttributeAndGetStatusReply rep;
+    xnvCtrlSetAttributeAndGetStatusReq *req;
+    _XAsyncHandler async;
+    uintptr_t flags;
+    int i;
+
+    if (!XextHasExtension(info))
+        return False;
+
+    flags = version_flags(dpy, info);
+
+    if (!(flags & NVCTRL_EXT_EXISTS))
+        return False;
+
+    XNVCTRLCheckExtension(dpy, info, False);
+
+    for (i = 0; i < count; i++) {
+        assignments[i].success = False;
+    }
+    if (count <= 0)
+        return True;
+
+    /*
+     * Without target support, the requests for targets other than X
+     * screens are not sent at all; let
+     * XNVCTRLSetTargetAttributeAndGetStatus() sort them out.
+     */
+
+    if (!(flags & NVCTRL_EXT_HAS_TARGET_SET_GET)) {
+        for (i = 0; i < count; i++) {
+            assignments[i].success =
+                XNVCTRLSetTargetAttributeAndGetStatus(
+                    dpy, assignments[i].target_type,
+                    assignments[i].target_id, assignments[i].display_mask,
+                    assignments[i].attribute, assignments[i].value);
+        }
+        return True;
+    }
+
+    state.assignments = assignments;
+
+    LockDisplay(dpy);
+
+    state.first_seq = dpy->request + 1;
+    state.last_seq = state.first_seq + count - 2;
+
+    async.next = dpy->async_handlers;
+    async.handler = SetAttributesHandler;
+    async.data = (XPointer)&state;
+    dpy->async_handlers = &async;
+
+    for (i = 0; i < count; i++) {
+        GetReq(nvCtrlSetAttributeAndGetStatus, req);
+        req->reqType = info->codes->major_opcode;
+        req->nvReqType = X_nvCtrlSetAttributeAndGetStatus;
+        req->target_type = assignments[i].target_type;
+        req->target_id = assignments[i].target_id;
+        req->display_mask = assignments[i].display_mask;
+        req->attribute = assignments[i].attribute;
+        req->value = assignments[i].value;
+    }
+
+    if (_XReply(dpy, (xReply *)&rep, 0, False)) {
+        assignments[count - 1].success = rep.flags;
+    }
+
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    return True;
+}
+
+
 Bool XNVCTRLQueryTargetAttribute (
     Display *dpy,
     int target_type,
@@ -437,6 +559,138 @@ Bool XNVCTRLQueryTargetAttribute64 (
 }
 
 
+/*
+ * State shared with the async reply handler of
+ * XNVCTRLQueryTargetAttributes64(): the replies to the requests with
+ * sequence numbers first_seq through last_seq are stored in the
+ * corresponding entries of 'queries'.
+ */
+
+typedef struct {
+    unsigned long first_seq;
+    unsigned long last_seq;
+    Bool is64;
+    XNVCTRLAttributeQuery *queries;
+} XNVCTRLQueryAttributesState;
+
+typedef union {
+    xnvCtrlQueryAttributeReply rep32;
+    xnvCtrlQueryAttribute64Reply rep64;
+} XNVCTRLQueryAttributeAnyReply;
+
+static void StoreQueryAttributeReply(XNVCTRLAttributeQuery *query, Bool is64,
+                                     const XNVCTRLQueryAttributeAnyReply *rep)
+{
+    if (is64) {
+        query->exists = rep->rep64.flags;
+        query->value = rep->rep64.value_64;
+    } else {
+        query->exists = rep->rep32.flags;
+        query->value = (INT32) rep->rep32.value;
+    }
+}
+
+static Bool QueryAttributesHandler(
+    Display *dpy,
+    xReply *rep,
+    char *buf,
+    int len,
+    XPointer data
+){
+    XNVCTRLQueryAttributesState *state = (XNVCTRLQueryAttributesState *)data;
+    XNVCTRLQueryAttributeAnyReply replbuf, *repl;
+    unsigned long seq = dpy->last_request_read;
+
+    if ((seq < state->first_seq) || (seq > state->last_seq)) {
+        return False;
+    }
+
+    /* Let the error handler report failed queries; 'exists' stays False */
+    if (rep->generic.type == X_Error) {
+        return False;
+    }
+
+    repl = (XNVCTRLQueryAttributeAnyReply *)
+        _XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+                        (SIZEOF(xnvCtrlQueryAttribute64Reply) -
+                         SIZEOF(xReply)) >> 2,
+                        True);
+
+    StoreQueryAttributeReply(&state->queries[seq - state->first_seq],
+                             state->is64, repl);
+    return True;
+}
+
+Bool XNVCTRLQueryTargetAttributes64 (
+    Display *dpy,
+    XNVCTRLAttributeQuery *queries,
+    int count
+){
+    XExtDisplayInfo *info = find_display(dpy);
+    XNVCTRLQueryAttributesState state;
+    XNVCTRLQueryAttributeAnyReply rep;
+    xnvCtrlQueryAttributeReq *req;
+    _XAsyncHandler async;
+    int i;
+
+    if (!XextHasExtension(info))
+        return False;
+
+    XNVCTRLCheckExtension(dpy, info, False);
+
+    for (i = 0; i < count; i++) {
+        queries[i].exists = False;
+    }
+    if (count <= 0)
+        return True;
+
+    state.is64 =
+        (version_flags(dpy, info) & NVCTRL_EXT_64_BIT_ATTRIBUTES) != 0;
+    state.queries = queries;
+
+    LockDisplay(dpy);
+
+    /*
+     * Send all the requests without waiting for any reply; the replies
+     * to all but the last request are picked up by the async handler
+     * while _XReply() waits for the last one.
+     */
+
+    state.first_seq = dpy->request + 1;
+    state.last_seq = state.first_seq + count - 2;
+
+    async.next = dpy->async_handlers;
+    async.handler = QueryAttributesHandler;
+    async.data = (XPointer)&state;
+    dpy->async_handlers = &async;
+
+    for (i = 0; i < count; i++) {
+        int target_type = queries[i].target_type;
+        int target_id = queries[i].target_id;
+
+        XNVCTRLCheckTargetData(dpy, info, &target_type, &target_id);
+
+        GetReq(nvCtrlQueryAttribute, req);
+        req->reqType = info->codes->major_opcode;
+        req->nvReqType = state.is64 ? X_nvCtrlQueryAttribute64 :
+                                      X_nvCtrlQueryAttribute;
+        req->target_type = target_type;
+        req->target_id = target_id;
+        req->display_mask = queries[i].display_mask;
+        req->attribute = queries[i].attribute;
+    }
+
+    if (_XReply(dpy, (xReply *)&rep, 0, xTrue)) {
+        StoreQueryAttributeReply(&queries[count - 1], state.is64, &rep);
+    }
+
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    return True;
+}
+
+
 Bool XNVCTRLQueryTargetStringAttribute (
     Display *dpy,
     int target_type,
@@ -755,6 +1009,159 @@ Bool XNVCTRLQueryValidAttributeValues (
 }
 
 
+/*
+ * State shared with the async reply handler of
+ * XNVCTRLQueryValidTargetAttributesValues(), as for
+ * XNVCTRLQueryTargetAttributes64().
+ */
+
+typedef struct {
+    unsigned long first_seq;
+    unsigned long last_seq;
+    Bool is64;
+    XNVCTRLValidValuesQuery *queries;
+} XNVCTRLQueryValidValuesState;
+
+typedef union {
+    xnvCtrlQueryValidAttributeValuesReply rep32;
+    xnvCtrlQueryValidAttributeValues64Reply rep64;
+} XNVCTRLQueryValidValuesAnyReply;
+
+static void StoreQueryValidValuesReply(
+    XNVCTRLValidValuesQuery *query,
+    Bool is64,
+    const XNVCTRLQueryValidValuesAnyReply *rep
+){
+    NVCTRLAttributeValidValuesRec *values = &query->values;
+
+    if (is64) {
+        query->exists = rep->rep64.flags;
+        if (!query->exists) return;
+        values->type = rep->rep64.attr_type;
+        if (values->type == ATTRIBUTE_TYPE_RANGE) {
+            values->u.range.min = rep->rep64.min_64;
+            values->u.range.max = rep->rep64.max_64;
+        }
+        if (values->type == ATTRIBUTE_TYPE_INT_BITS) {
+            values->u.bits.ints = rep->rep64.bits_64;
+        }
+        values->permissions = rep->rep64.perms;
+    } else {
+        query->exists = rep->rep32.flags;
+        if (!query->exists) return;
+        values->type = rep->rep32.attr_type;
+        if (values->type == ATTRIBUTE_TYPE_RANGE) {
+            values->u.range.min = rep->rep32.min;
+            values->u.range.max = rep->rep32.max;
+        }
+        if (values->type == ATTRIBUTE_TYPE_INT_BITS) {
+            values->u.bits.ints = rep->rep32.bits;
+        }
+        values->permissions = rep->rep32.perms;
+    }
+}
+
+static Bool QueryValidValuesHandler(
+    Display *dpy,
+    xReply *rep,
+    char *buf,
+    int len,
+    XPointer data
+){
+    XNVCTRLQueryValidValuesState *state = (XNVCTRLQueryValidValuesState *)data;
+    XNVCTRLQueryValidValuesAnyReply replbuf, *repl;
+    unsigned long seq = dpy->last_request_read;
+
+    if ((seq < state->first_seq) || (seq > state->last_seq)) {
+        return False;
+    }
+
+    if (rep->generic.type == X_Error) {
+        return False;
+    }
+
+    repl = (XNVCTRLQueryValidValuesAnyReply *)
+        _XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+                        state->is64 ?
+                        sz_xnvCtrlQueryValidAttributeValues64Reply_extra : 0,
+                        True);
+
+    StoreQueryValidValuesReply(&state->queries[seq - state->first_seq],
+                               state->is64, repl);
+    return True;
+}
+
+Bool XNVCTRLQueryValidTargetAttributesValues (
+    Display *dpy,
+    XNVCTRLValidValuesQuery *queries,
+    int count
+){
+    XExtDisplayInfo *info = find_display(dpy);
+    XNVCTRLQueryValidValuesState state;
+    XNVCTRLQueryValidValuesAnyReply rep;
+    xnvCtrlQueryValidAttributeValuesReq *req;
+    _XAsyncHandler async;
+    uintptr_t flags;
+    int i;
+
+    if (!XextHasExtension(info))
+        return False;
+
+    XNVCTRLCheckExtension(dpy, info, False);
+
+    for (i = 0; i < count; i++) {
+        queries[i].exists = False;
+    }
+    if (count <= 0)
+        return True;
+
+    flags = version_flags(dpy, info);
+    if (!(flags & NVCTRL_EXT_EXISTS))
+        return False;
+
+    state.is64 = (flags & NVCTRL_EXT_64_BIT_ATTRIBUTES) != 0;
+    state.queries = queries;
+
+    LockDisplay(dpy);
+
+    state.first_seq = dpy->request + 1;
+    state.last_seq = state.first_seq + count - 2;
+
+    async.next = dpy->async_handlers;
+    async.handler = QueryValidValuesHandler;
+    async.data = (XPointer)&state;
+    dpy->async_handlers = &async;
+
+    for (i = 0; i < count; i++) {
+        int target_type = queries[i].target_type;
+        int target_id = queries[i].target_id;
+
+        XNVCTRLCheckTargetData(dpy, info, &target_type, &target_id);
+
+        GetReq(nvCtrlQueryValidAttributeValues, req);
+        req->reqType = info->codes->major_opcode;
+        req->nvReqType = state.is64 ? X_nvCtrlQueryValidAttributeValues64 :
+                                      X_nvCtrlQueryValidAttributeValues;
+        req->target_type = target_type;
+        req->target_id = target_id;
+        req->display_mask = queries[i].display_mask;
+        req->attribute = queries[i].attribute;
+    }
+
+    if (_XReply(dpy, (xReply *)&rep,
+                state.is64 ?
+                sz_xnvCtrlQueryValidAttributeValues64Reply_extra : 0,
+                xTrue)) {
+        StoreQueryValidValuesReply(&queries[count - 1], state.is64, &rep);
+    }
+
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    return True;
+}
+
+
 static Bool QueryAttributePermissionsInternal (
     Display *dpy,
     unsigned int attribute,
@@ -804,6 +1211,111 @@ Bool XNVCTRLQueryAttributePermissions (
 }
 
 
+/*
+ * State shared with the async reply handler of
+ * XNVCTRLQueryAttributesPermissions(), as for
+ * XNVCTRLQueryTargetAttributes64().
+ */
+
+typedef struct {
+    unsigned long first_seq;
+    unsigned long last_seq;
+    XNVCTRLAttributePermissionsQuery *queries;
+} XNVCTRLQueryPermissionsState;
+
+static void StoreQueryPermissionsReply(
+    XNVCTRLAttributePermissionsQuery *query,
+    const xnvCtrlQueryAttributePermissionsReply *rep
+){
+    query->exists = rep->flags;
+    if (query->exists) {
+        query->permissions.type = rep->attr_type;
+        query->permissions.permissions = rep->perms;
+    }
+}
+
+static Bool QueryPermissionsHandler(
+    Display *dpy,
+    xReply *rep,
+    char *buf,
+    int len,
+    XPointer data
+){
+    XNVCTRLQueryPermissionsState *state = (XNVCTRLQueryPermissionsState *)data;
+    xnvCtrlQueryAttributePermissionsReply replbuf, *repl;
+    unsigned long seq = dpy->last_request_read;
+
+    if ((seq < state->first_seq) || (seq > state->last_seq)) {
+        return False;
+    }
+
+    if (rep->generic.type == X_Error) {
+        return False;
+    }
+
+    repl = (xnvCtrlQueryAttributePermissionsReply *)
+        _XGetAsyncReply(dpy, (char *)&replbuf, rep, buf, len,
+                        (SIZEOF(xnvCtrlQueryAttributePermissionsReply) -
+                         SIZEOF(xReply)) >> 2,
+                        True);
+
+    StoreQueryPermissionsReply(&state->queries[seq - state->first_seq], repl);
+    return True;
+}
+
+Bool XNVCTRLQueryAttributesPermissions (
+    Display *dpy,
+    XNVCTRLAttributePermissionsQuery *queries,
+    int count
+){
+    XExtDisplayInfo *info = find_display(dpy);
+    XNVCTRLQueryPermissionsState state;
+    xnvCtrlQueryAttributePermissionsReply rep;
+    xnvCtrlQueryAttributePermissionsReq *req;
+    _XAsyncHandler async;
+    int i;
+
+    if (!XextHasExtension(info))
+        return False;
+
+    XNVCTRLCheckExtension(dpy, info, False);
+
+    for (i = 0; i < count; i++) {
+        queries[i].exists = False;
+    }
+    if (count <= 0)
+        return True;
+
+    state.queries = queries;
+
+    LockDisplay(dpy);
+
+    state.first_seq = dpy->request + 1;
+    state.last_seq = state.first_seq + count - 2;
+
+    async.next = dpy->async_handlers;
+    async.handler = QueryPermissionsHandler;
+    async.data = (XPointer)&state;
+    dpy->async_handlers = &async;
+
+    for (i = 0; i < count; i++) {
+        GetReq(nvCtrlQueryAttributePermissions, req);
+        req->reqType = info->codes->major_opcode;
+        req->nvReqType = X_nvCtrlQueryAttributePermissions;
+        req->attribute = queries[i].attribute;
+    }
+
+    if (_XReply(dpy, (xReply *)&rep, 0, xTrue)) {
+        StoreQueryPermissionsReply(&queries[count - 1], &rep);
+    }
+
+    DeqAsyncHandler(dpy, &async);
+    UnlockDisplay(dpy);
+    SyncHandle();
+    return True;
+}
+
+
 Bool XNVCTRLQueryStringAttributePermissions (
     Display *dpy,
     unsigned int attribute,
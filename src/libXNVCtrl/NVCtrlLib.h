@@ -184,6 +184,42 @@ Bool XNVCTRLSetTargetAttributeAndGetStatus (
 );
 
 
+/*
+ * XNVCTRLSetTargetAttributesAndGetStatus -
+ *
+ *  Assigns several integer attributes with a single round trip to the
+ *  X server: all the requests are sent at once, in order, and their
+ *  statuses are collected afterwards.  For each entry of the
+ *  'assignments' array, the caller fills in target_type, target_id,
+ *  display_mask, attribute and value; on return, 'success' is True if
+ *  that assignment succeeded, as returned by
+ *  XNVCTRLSetTargetAttributeAndGetStatus().
+ *
+ *  Returns False if the NV-CONTROL extension is not available; True
+ *  otherwise, even if some replies could not be read: the entries whose
+ *  reply is missing are left with 'success' set to False.
+ *
+ *  Possible errors (reported once for each failing entry):
+ *     BadValue - The target doesn't exist.
+ *     BadMatch - The NVIDIA driver does not control the target.
+ */
+
+typedef struct {
+    int target_type;
+    int target_id;
+    unsigned int display_mask;
+    unsigned int attribute;
+    int value;
+    Bool success;
+} XNVCTRLAttributeAssignment;
+
+Bool XNVCTRLSetTargetAttributesAndGetStatus (
+    Display *dpy,
+    XNVCTRLAttributeAssignment *assignments,
+    int count
+);
+
+
 /*
  *  XNVCTRLQueryAttribute -
  *
@@ -265,6 +301,41 @@ Bool XNVCTRLQueryTargetAttribute64 (
 );
 
 
+/*
+ * XNVCTRLQueryTargetAttributes64 -
+ *
+ *  Queries several integer attributes with a single round trip to the
+ *  X server: all the requests are sent at once and the replies are
+ *  collected afterwards.  For each entry of the 'queries' array, the
+ *  caller fills in target_type, target_id, display_mask and attribute;
+ *  on return, 'exists' is True if the attribute exists, in which case
+ *  'value' contains its value.
+ *
+ *  Returns False if the NV-CONTROL extension is not available; True
+ *  otherwise, even if some replies could not be read: the entries whose
+ *  reply is missing are left with 'exists' set to False.
+ *
+ *  Possible errors (reported once for each failing entry):
+ *     BadValue - The target doesn't exist.
+ *     BadMatch - The NVIDIA driver does not control the target.
+ */
+
+typedef struct {
+    int target_type;
+    int target_id;
+    unsigned int display_mask;
+    unsigned int attribute;
+    Bool exists;
+    int64_t value;
+} XNVCTRLAttributeQuery;
+
+Bool XNVCTRLQueryTargetAttributes64 (
+    Display *dpy,
+    XNVCTRLAttributeQuery *queries,
+    int count
+);
+
+
 /*
  *  XNVCTRLQueryStringAttribute -
  *
@@ -398,6 +469,37 @@ Bool XNVCTRLQueryValidTargetAttributeValues (
 );
 
 
+/*
+ * XNVCTRLQueryValidTargetAttributesValues -
+ *
+ *  Queries the valid values of several integer attributes with a single
+ *  round trip to the X server, like XNVCTRLQueryTargetAttributes64().
+ *  For each entry of the 'queries' array, the caller fills in
+ *  target_type, target_id, display_mask and attribute; on return,
+ *  'exists' is True if the attribute exists, in which case 'values'
+ *  contains its valid values.
+ *
+ *  Returns False if the NV-CONTROL extension is not available; True
+ *  otherwise, even if some replies could not be read: the entries whose
+ *  reply is missing are left with 'exists' set to False.
+ */
+
+typedef struct {
+    int target_type;
+    int target_id;
+    unsigned int display_mask;
+    unsigned int attribute;
+    Bool exists;
+    NVCTRLAttributeValidValuesRec values;
+} XNVCTRLValidValuesQuery;
+
+Bool XNVCTRLQueryValidTargetAttributesValues (
+    Display *dpy,
+    XNVCTRLValidValuesQuery *queries,
+    int count
+);
+
+
 /*
  * XNVCTRLQueryValidTargetStringAttributeValues -
  *
@@ -432,6 +534,33 @@ Bool XNVCTRLQueryAttributePermissions (
 );
 
 
+/*
+ * XNVCTRLQueryAttributesPermissions -
+ *
+ *  Queries the permissions of several integer attributes with a single
+ *  round trip to the X server, like XNVCTRLQueryTargetAttributes64().
+ *  For each entry of the 'queries' array, the caller fills in
+ *  attribute; on return, 'exists' is True if the attribute exists, in
+ *  which case 'permissions' contains its permissions.
+ *
+ *  Returns False if the NV-CONTROL extension is not available; True
+ *  otherwise, even if some replies could not be read: the entries whose
+ *  reply is missing are left with 'exists' set to False.
+ */
+
+typedef struct {
+    unsigned int attribute;
+    Bool exists;
+    NVCTRLAttributePermissionsRec permissions;
+} XNVCTRLAttributePermissionsQuery;
+
+Bool XNVCTRLQueryAttributesPermissions (
+    Display *dpy,
+    XNVCTRLAttributePermissionsQuery *queries,
+    int count
+);
+
+
 /*
  * XNVCTRLQueryStringAttributePermissions -
  *
@@ -31,6 +31,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <math.h> /* pow(3) */
+#include <time.h>
 
 #include <sys/utsname.h>
 
@@ -279,7 +280,7 @@ NvCtrlAttributeHandle *NvCtrlAttributeInit(CtrlSystem *system,
     if ((subsystems & NV_CTRL_ATTRIBUTES_NVML_SUBSYSTEM) &&
         TARGET_TYPE_IS_NVML_COMPATIBLE(target_type)) {
 
-        h->nvml = NvCtrlInitNvmlAttributes(h);
+        h->nvml = NvCtrlInitNvmlAttributes(system, h);
     }
 
     return (NvCtrlAttributeHandle *) h;
@@ -306,6 +307,14 @@ void NvCtrlRebuildSubsystems(CtrlTarget *ctrl_target, unsigned int subsystem)
         h->xrandr = NvCtrlInitXrandrAttributes(h);
     }
 
+    /* As in NvCtrlAttributeInit(), EGL is only used by X screens and GPUs */
+    if ((subsystem & NV_CTRL_ATTRIBUTES_EGL_SUBSYSTEM) &&
+        ((h->target_type == X_SCREEN_TARGET) ||
+         (h->target_type == GPU_TARGET))) {
+        NvCtrlEglAttributesClose(h);
+        h->egl = NvCtrlInitEglAttributes(h);
+    }
+
 }
 
 
@@ -701,12 +710,126 @@ ReturnStatus NvCtrlGetValidAttributeValues(const CtrlTarget *ctrl_target,
 } /* NvCtrlGetValidAttributeValues() */
 
 
+/*
+ * Attribute permissions table.  The permissions returned by
+ * NvCtrlGetAttributePerms() for NV-CONTROL and NVML attributes are kept
+ * per (target type, attribute type, attribute) in a hash table hanging off
+ * the CtrlSystem, created on first use and freed with the system.
+ */
+
+#define ATTRIBUTE_PERMS_BUCKETS 256
+
+typedef struct _NvCtrlCachedPerms NvCtrlCachedPerms;
+
+struct _NvCtrlCachedPerms {
+    CtrlTargetType target_type;
+    CtrlAttributeType attr_type;
+    int attr;
+    CtrlAttributePerms perms;
+    NvCtrlCachedPerms *next;
+};
+
+struct __NvCtrlAttributePermsCache {
+    NvCtrlCachedPerms *buckets[ATTRIBUTE_PERMS_BUCKETS];
+};
+
+
+static NvCtrlCachedPerms **PermsBucket(NvCtrlAttributePermsCache *cache,
+                                       CtrlTargetType target_type,
+                                       CtrlAttributeType attr_type, int attr)
+{
+    unsigned int hash;
+
+    hash = ((unsigned int) attr * 31 + attr_type) * 31 + target_type;
+
+    return &cache->buckets[hash % ATTRIBUTE_PERMS_BUCKETS];
+}
+
+
+static const CtrlAttributePerms *PermsLookup(const CtrlTarget *ctrl_target,
+                                             CtrlAttributeType attr_type,
+                                             int attr)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    NvCtrlAttributePermsCache *cache;
+    NvCtrlCachedPerms *entry;
+
+    if (!ctrl_target->system || !ctrl_target->system->attribute_perms) {
+        return NULL;
+    }
+
+    cache = ctrl_target->system->attribute_perms;
+
+    for (entry = *PermsBucket(cache, h->target_type, attr_type, attr);
+         entry; entry = entry->next) {
+        if ((entry->attr == attr) && (entry->attr_type == attr_type) &&
+            (entry->target_type == h->target_type)) {
+            return &entry->perms;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void PermsStore(const CtrlTarget *ctrl_target,
+                       CtrlAttributeType attr_type, int attr,
+                       const CtrlAttributePerms *perms)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlSystem *system = ctrl_target->system;
+    NvCtrlCachedPerms **bucket, *entry;
+
+    if (!system) {
+        return;
+    }
+
+    if (!system->attribute_perms) {
+        system->attribute_perms = nvalloc(sizeof(NvCtrlAttributePermsCache));
+    }
+
+    bucket = PermsBucket(system->attribute_perms,
+                         h->target_type, attr_type, attr);
+
+    entry = nvalloc(sizeof(NvCtrlCachedPerms));
+    entry->target_type = h->target_type;
+    entry->attr_type = attr_type;
+    entry->attr = attr;
+    entry->perms = *perms;
+    entry->next = *bucket;
+    *bucket = entry;
+}
+
+
+void NvCtrlFreeAttributePermsCache(CtrlSystem *system)
+{
+    NvCtrlAttributePermsCache *cache = system->attribute_perms;
+    int i;
+
+    if (!cache) {
+        return;
+    }
+
+    for (i = 0; i < ATTRIBUTE_PERMS_BUCKETS; i++) {
+        while (cache->buckets[i]) {
+            NvCtrlCachedPerms *entry = cache->buckets[i];
+            cache->buckets[i] = entry->next;
+            nvfree(entry);
+        }
+    }
+
+    nvfree(cache);
+    system->attribute_perms = NULL;
+}
+
+
 ReturnStatus NvCtrlGetAttributePerms(const CtrlTarget *ctrl_target,
                                      CtrlAttributeType attr_type,
                                      int attr,
                                      CtrlAttributePerms *perms)
 {
     const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    const CtrlAttributePerms *cached;
     ReturnStatus ret = NvCtrlError;
 
     if (h == NULL) {
@@ -723,12 +846,22 @@ ReturnStatus NvCtrlGetAttributePerms(const CtrlTarget *ctrl_target,
         case CTRL_ATTRIBUTE_TYPE_BINARY_DATA:
         case CTRL_ATTRIBUTE_TYPE_STRING_OPERATION:
 
+            cached = PermsLookup(ctrl_target, attr_type, attr);
+            if (cached) {
+                *perms = *cached;
+                return NvCtrlSuccess;
+            }
+
             ret = NvCtrlNvmlGetAttributePerms(h, attr_type, attr, perms);
 
-            if (ret == NvCtrlSuccess || h->dpy == NULL) {
-                return ret;
+            if (ret != NvCtrlSuccess && h->dpy != NULL) {
+                ret = NvCtrlNvControlGetAttributePerms(h, attr_type, attr,
+                                                       perms);
             }
-            return NvCtrlNvControlGetAttributePerms(h, attr_type, attr, perms);
+            if (ret == NvCtrlSuccess) {
+                PermsStore(ctrl_target, attr_type, attr, perms);
+            }
+            return ret;
 
         case CTRL_ATTRIBUTE_TYPE_COLOR:
             /*
@@ -747,6 +880,65 @@ ReturnStatus NvCtrlGetAttributePerms(const CtrlTarget *ctrl_target,
 
 
 
+ReturnStatus NvCtrlPrefetchAttributePerms(const CtrlTarget *ctrl_target,
+                                          const int *attrs, int count)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    CtrlAttributePerms *perms;
+    ReturnStatus *status;
+    int *pending;
+    int i, numPending = 0;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (attrs == NULL) {
+        return NvCtrlBadArgument;
+    }
+
+    pending = nvalloc(count * sizeof(int));
+    perms = nvalloc(count * sizeof(CtrlAttributePerms));
+    status = nvalloc(count * sizeof(ReturnStatus));
+
+    /* NVML permissions are known locally; set the others aside */
+
+    for (i = 0; i < count; i++) {
+        if (PermsLookup(ctrl_target, CTRL_ATTRIBUTE_TYPE_INTEGER, attrs[i])) {
+            continue;
+        }
+
+        if (NvCtrlNvmlGetAttributePerms(h, CTRL_ATTRIBUTE_TYPE_INTEGER,
+                                        attrs[i], &perms[0]) == NvCtrlSuccess) {
+            PermsStore(ctrl_target, CTRL_ATTRIBUTE_TYPE_INTEGER, attrs[i],
+                       &perms[0]);
+        } else if (h->dpy != NULL) {
+            pending[numPending++] = attrs[i];
+        }
+    }
+
+    if (numPending > 0) {
+        NvCtrlNvControlGetAttributesPermsBatch(h->dpy, pending, perms, status,
+                                               numPending);
+
+        for (i = 0; i < numPending; i++) {
+            if (status[i] == NvCtrlSuccess) {
+                PermsStore(ctrl_target, CTRL_ATTRIBUTE_TYPE_INTEGER,
+                           pending[i], &perms[i]);
+            }
+        }
+    }
+
+    nvfree(status);
+    nvfree(perms);
+    nvfree(pending);
+
+    return NvCtrlSuccess;
+
+} /* NvCtrlPrefetchAttributePerms() */
+
+
+
 ReturnStatus NvCtrlGetStringAttribute(const CtrlTarget *ctrl_target,
                                       int attr, char **ptr)
 {
@@ -763,9 +955,298 @@ ReturnStatus NvCtrlSetStringAttribute(CtrlTarget *ctrl_target,
 } /* NvCtrlSetStringAttribute() */
 
 
-ReturnStatus NvCtrlGetDisplayAttribute64(const CtrlTarget *ctrl_target,
-                                         unsigned int display_mask,
-                                         int attr, int64_t *val)
+/*
+ * Attribute value cache.  When enabled on a target with
+ * NvCtrlEnableAttributeCache(), successful integer and string attribute
+ * reads are remembered: values of attributes that cannot change while the
+ * driver is loaded are kept until the cache is disabled, and other values
+ * are reused for ATTRIBUTE_CACHE_TTL_MS.  Cached values are dropped when
+ * the attribute is set through this library, or when an event reports
+ * that it changed.
+ */
+
+#define ATTRIBUTE_CACHE_BUCKETS 64
+#define ATTRIBUTE_CACHE_TTL_MS  250
+
+typedef struct _NvCtrlCachedAttribute NvCtrlCachedAttribute;
+
+struct _NvCtrlCachedAttribute {
+    int attr;
+    unsigned int display_mask;
+    Bool is_string;
+    int64_t val;
+    char *str;
+    uint64_t expires;   /* in ms, or 0 if the value never expires */
+    NvCtrlCachedAttribute *next;
+};
+
+struct __NvCtrlAttributeCache {
+    const NvCtrlAttributePrivateHandle *h;
+    NvCtrlCachedAttribute *buckets[ATTRIBUTE_CACHE_BUCKETS];
+    unsigned int hits;
+    unsigned int misses;
+    NvCtrlAttributeCache *next;
+};
+
+/*
+ * List of the enabled attribute caches, used to dispatch invalidations
+ */
+static NvCtrlAttributeCache *__attribute_caches = NULL;
+
+
+static uint64_t GetTimeMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/*
+ * Returns whether the attribute 'attr' cannot change value while the
+ * driver is loaded.
+ */
+
+static Bool IsStaticAttribute(Bool is_string, int attr)
+{
+    if (is_string) {
+        switch (attr) {
+            case NV_CTRL_STRING_PRODUCT_NAME:
+            case NV_CTRL_STRING_VBIOS_VERSION:
+            case NV_CTRL_STRING_NVIDIA_DRIVER_VERSION:
+            case NV_CTRL_STRING_GPU_UUID:
+                return True;
+            default:
+                return False;
+        }
+    }
+
+    switch (attr) {
+        case NV_CTRL_BUS_TYPE:
+        case NV_CTRL_IRQ:
+        case NV_CTRL_VIDEO_RAM:
+        case NV_CTRL_ARCHITECTURE:
+        case NV_CTRL_GPU_PCIE_MAX_LINK_WIDTH:
+        case NV_CTRL_GPU_PCIE_MAX_LINK_SPEED:
+        case NV_CTRL_GPU_PCIE_GENERATION:
+        case NV_CTRL_PCI_BUS:
+        case NV_CTRL_PCI_DEVICE:
+        case NV_CTRL_PCI_FUNCTION:
+        case NV_CTRL_PCI_ID:
+        case NV_CTRL_PCI_DOMAIN:
+        case NV_CTRL_GPU_CORES:
+        case NV_CTRL_GPU_MEMORY_BUS_WIDTH:
+        case NV_CTRL_TOTAL_DEDICATED_GPU_MEMORY:
+            return True;
+        default:
+            return False;
+    }
+}
+
+
+static NvCtrlCachedAttribute **CacheBucket(NvCtrlAttributeCache *cache,
+                                           int attr)
+{
+    return &cache->buckets[(unsigned int) attr % ATTRIBUTE_CACHE_BUCKETS];
+}
+
+
+static void FreeCachedAttribute(NvCtrlCachedAttribute *entry)
+{
+    free(entry->str);
+    free(entry);
+}
+
+
+/*
+ * Looks up the cached value of the given attribute, dropping it if it has
+ * expired.  Updates the cache hit/miss counters.
+ */
+
+static NvCtrlCachedAttribute *CacheLookup(NvCtrlAttributeCache *cache,
+                                          Bool is_string,
+                                          unsigned int display_mask, int attr)
+{
+    NvCtrlCachedAttribute **pentry = CacheBucket(cache, attr);
+    NvCtrlCachedAttribute *entry;
+
+    for (entry = *pentry; entry; pentry = &entry->next, entry = entry->next) {
+        if ((entry->attr != attr) || (entry->display_mask != display_mask) ||
+            (entry->is_string != is_string)) {
+            continue;
+        }
+
+        if (entry->expires && (GetTimeMs() >= entry->expires)) {
+            *pentry = entry->next;
+            FreeCachedAttribute(entry);
+            break;
+        }
+
+        cache->hits++;
+        return entry;
+    }
+
+    cache->misses++;
+    return NULL;
+}
+
+
+static void CacheStore(NvCtrlAttributeCache *cache, Bool is_string,
+                       unsigned int display_mask, int attr,
+                       int64_t val, const char *str)
+{
+    NvCtrlCachedAttribute **pbucket = CacheBucket(cache, attr);
+    NvCtrlCachedAttribute *entry;
+
+    /* Refresh the existing entry, if any, so that values sampled
+     * periodically do not pile up in the bucket */
+
+    for (entry = *pbucket; entry; entry = entry->next) {
+        if ((entry->attr == attr) && (entry->display_mask == display_mask) &&
+            (entry->is_string == is_string)) {
+            break;
+        }
+    }
+
+    if (entry) {
+        free(entry->str);
+    } else {
+        entry = nvalloc(sizeof(NvCtrlCachedAttribute));
+        entry->attr = attr;
+        entry->display_mask = display_mask;
+        entry->is_string = is_string;
+        entry->next = *pbucket;
+        *pbucket = entry;
+    }
+
+    entry->val = val;
+    entry->str = str ? nvstrdup(str) : NULL;
+    entry->expires = IsStaticAttribute(is_string, attr) ? 0 :
+                     GetTimeMs() + ATTRIBUTE_CACHE_TTL_MS;
+}
+
+
+/*
+ * Drops all the cached values of the given attribute, for any display mask
+ */
+
+static void CacheInvalidate(NvCtrlAttributeCache *cache, Bool is_string,
+                            int attr)
+{
+    NvCtrlCachedAttribute **pentry = CacheBucket(cache, attr);
+    NvCtrlCachedAttribute *entry;
+
+    while ((entry = *pentry) != NULL) {
+        if ((entry->attr == attr) && (entry->is_string == is_string)) {
+            *pentry = entry->next;
+            FreeCachedAttribute(entry);
+        } else {
+            pentry = &entry->next;
+        }
+    }
+}
+
+
+static void CacheFlush(NvCtrlAttributeCache *cache)
+{
+    int i;
+
+    for (i = 0; i < ATTRIBUTE_CACHE_BUCKETS; i++) {
+        while (cache->buckets[i]) {
+            NvCtrlCachedAttribute *entry = cache->buckets[i];
+            cache->buckets[i] = entry->next;
+            FreeCachedAttribute(entry);
+        }
+    }
+}
+
+
+/*
+ * Drops the cached value of the attribute reported by 'event' from the
+ * caches of the targets it was received for.
+ */
+
+static void InvalidateCachedEventAttribute(const Display *dpy,
+                                           const CtrlEvent *event)
+{
+    NvCtrlAttributeCache *cache;
+
+    for (cache = __attribute_caches; cache; cache = cache->next) {
+        const NvCtrlAttributePrivateHandle *h = cache->h;
+
+        if ((h->dpy != dpy) || (h->target_type != event->target_type) ||
+            (h->target_id != event->target_id)) {
+            continue;
+        }
+
+        if (event->type == CTRL_EVENT_TYPE_INTEGER_ATTRIBUTE) {
+            CacheInvalidate(cache, False, event->int_attr.attribute);
+        } else if (event->type == CTRL_EVENT_TYPE_STRING_ATTRIBUTE) {
+            CacheInvalidate(cache, True, event->str_attr.attribute);
+        }
+    }
+}
+
+
+static void DisableAttributeCache(NvCtrlAttributePrivateHandle *h)
+{
+    NvCtrlAttributeCache **pcache;
+
+    if (!h->cache) {
+        return;
+    }
+
+    for (pcache = &__attribute_caches; *pcache; pcache = &(*pcache)->next) {
+        if (*pcache == h->cache) {
+            *pcache = h->cache->next;
+            break;
+        }
+    }
+
+    CacheFlush(h->cache);
+    free(h->cache);
+    h->cache = NULL;
+}
+
+
+void NvCtrlEnableAttributeCache(CtrlTarget *ctrl_target, Bool enable)
+{
+    NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
+
+    if (h == NULL) {
+        return;
+    }
+
+    if (!enable) {
+        DisableAttributeCache(h);
+        return;
+    }
+
+    if (!h->cache) {
+        h->cache = nvalloc(sizeof(NvCtrlAttributeCache));
+        h->cache->h = h;
+        h->cache->next = __attribute_caches;
+        __attribute_caches = h->cache;
+    }
+
+} /* NvCtrlEnableAttributeCache() */
+
+
+void NvCtrlGetAttributeCacheStats(const CtrlTarget *ctrl_target,
+                                  unsigned int *hits, unsigned int *misses)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+
+    *hits = (h && h->cache) ? h->cache->hits : 0;
+    *misses = (h && h->cache) ? h->cache->misses : 0;
+
+} /* NvCtrlGetAttributeCacheStats() */
+
+
+static ReturnStatus QueryDisplayAttribute64(const CtrlTarget *ctrl_target,
+                                            unsigned int display_mask,
+                                            int attr, int64_t *val)
 {
     const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
 
@@ -835,26 +1316,181 @@ ReturnStatus NvCtrlGetDisplayAttribute64(const CtrlTarget *ctrl_target,
         }
     }
 
-    return NvCtrlNoAttribute;
-    
-} /* NvCtrlGetDisplayAttribute64() */
+    return NvCtrlNoAttribute;
+    
+} /* QueryDisplayAttribute64() */
+
+
+ReturnStatus NvCtrlGetDisplayAttribute64(const CtrlTarget *ctrl_target,
+                                         unsigned int display_mask,
+                                         int attr, int64_t *val)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    const NvCtrlCachedAttribute *entry;
+    ReturnStatus status;
+
+    if ((h == NULL) || (h->cache == NULL)) {
+        return QueryDisplayAttribute64(ctrl_target, display_mask, attr, val);
+    }
+
+    entry = CacheLookup(h->cache, False, display_mask, attr);
+    if (entry) {
+        *val = entry->val;
+        return NvCtrlSuccess;
+    }
+
+    status = QueryDisplayAttribute64(ctrl_target, display_mask, attr, val);
+    if (status == NvCtrlSuccess) {
+        CacheStore(h->cache, False, display_mask, attr, *val, NULL);
+    }
+
+    return status;
+
+} /* NvCtrlGetDisplayAttribute64() */
+
+ReturnStatus NvCtrlGetDisplayAttribute(const CtrlTarget *ctrl_target,
+                                       unsigned int display_mask,
+                                       int attr, int *val)
+{
+    ReturnStatus status;
+    int64_t value_64;
+
+    status = NvCtrlGetDisplayAttribute64(ctrl_target, display_mask, attr,
+                                         &value_64);
+    if (status == NvCtrlSuccess) {
+        *val = value_64;
+    }
+
+    return status;
+
+} /* NvCtrlGetDisplayAttribute() */
+
+
+/*
+ * Returns whether the query can be answered by batching it with other
+ * NV-CONTROL queries: the attribute must be an NV-CONTROL one, and not
+ * already available from NVML for the targets NVML knows about.
+ */
+
+static Bool IsNvControlBatchQuery(CtrlAttributeQuery *query)
+{
+    const NvCtrlAttributePrivateHandle *h =
+        getPrivateHandleConst(query->ctrl_target);
+
+    if ((h == NULL) || !h->nv ||
+        (query->attr < 0) || (query->attr > NV_CTRL_LAST_ATTRIBUTE)) {
+        return False;
+    }
+
+    switch (h->target_type) {
+        case GPU_TARGET:
+        case THERMAL_SENSOR_TARGET:
+        case COOLER_TARGET:
+            if (NvCtrlNvmlGetAttribute(query->ctrl_target, query->attr,
+                                       &query->val) == NvCtrlSuccess) {
+                query->status = NvCtrlSuccess;
+                return False;
+            }
+            /* Fall through */
+        case DISPLAY_TARGET:
+        case X_SCREEN_TARGET:
+        case FRAMELOCK_TARGET:
+        case NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET:
+        case MUX_TARGET:
+            return True;
+        default:
+            return False;
+    }
+}
+
+
+
+ReturnStatus NvCtrlGetAttributesBatch(CtrlAttributeQuery *queries, int count)
+{
+    CtrlAttributeQuery **pending, **batch;
+    int i, j, numPending = 0;
+
+    if (queries == NULL) {
+        return NvCtrlBadArgument;
+    }
+
+    pending = nvalloc(count * sizeof(CtrlAttributeQuery *));
+    batch = nvalloc(count * sizeof(CtrlAttributeQuery *));
+
+    /*
+     * Answer locally whatever does not need an NV-CONTROL round trip, and
+     * set the rest aside.
+     */
+
+    for (i = 0; i < count; i++) {
+        CtrlAttributeQuery *query = &queries[i];
+
+        query->status = NvCtrlError;
+
+        if (IsNvControlBatchQuery(query)) {
+            pending[numPending++] = query;
+        } else if (query->status == NvCtrlSuccess) {
+            const NvCtrlAttributePrivateHandle *h =
+                getPrivateHandleConst(query->ctrl_target);
+
+            /* Answered by NVML; remember it like the NV-CONTROL answers */
+
+            if (h->cache) {
+                CacheStore(h->cache, False, query->display_mask,
+                           query->attr, query->val, NULL);
+            }
+        } else {
+            query->status = NvCtrlGetDisplayAttribute64(query->ctrl_target,
+                                                        query->display_mask,
+                                                        query->attr,
+                                                        &query->val);
+        }
+    }
+
+    /* Send the NV-CONTROL queries, one batch per X server connection */
 
-ReturnStatus NvCtrlGetDisplayAttribute(const CtrlTarget *ctrl_target,
-                                       unsigned int display_mask,
-                                       int attr, int *val)
-{
-    ReturnStatus status;
-    int64_t value_64;
+    for (i = 0; i < numPending; i++) {
+        Display *dpy;
+        int batchCount = 0;
 
-    status = NvCtrlGetDisplayAttribute64(ctrl_target, display_mask, attr,
-                                         &value_64);
-    if (status == NvCtrlSuccess) {
-        *val = value_64;
+        if (pending[i] == NULL) {
+            continue;
+        }
+
+        dpy = getPrivateHandleConst(pending[i]->ctrl_target)->dpy;
+
+        for (j = i; j < numPending; j++) {
+            if ((pending[j] != NULL) &&
+                (getPrivateHandleConst(pending[j]->ctrl_target)->dpy == dpy)) {
+                batch[batchCount++] = pending[j];
+                pending[j] = NULL;
+            }
+        }
+
+        NvCtrlNvControlGetAttributesBatch(dpy, batch, batchCount);
+
+        /*
+         * Remember the answers on targets that have a cache, so that a
+         * batch can be used to prefetch the values read right after it.
+         */
+
+        for (j = 0; j < batchCount; j++) {
+            const NvCtrlAttributePrivateHandle *h =
+                getPrivateHandleConst(batch[j]->ctrl_target);
+
+            if (h->cache && (batch[j]->status == NvCtrlSuccess)) {
+                CacheStore(h->cache, False, batch[j]->display_mask,
+                           batch[j]->attr, batch[j]->val, NULL);
+            }
+        }
     }
 
-    return status;
+    nvfree(batch);
+    nvfree(pending);
 
-} /* NvCtrlGetDisplayAttribute() */
+    return NvCtrlSuccess;
+
+} /* NvCtrlGetAttributesBatch() */
 
 
 ReturnStatus NvCtrlSetDisplayAttribute(CtrlTarget *ctrl_target,
@@ -868,6 +1504,10 @@ ReturnStatus NvCtrlSetDisplayAttribute(CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
+    if (h->cache) {
+        CacheInvalidate(h->cache, False, attr);
+    }
+
     if (((attr >= 0) && (attr <= NV_CTRL_LAST_ATTRIBUTE)) ||
         ((attr >= NV_CTRL_ATTR_NVML_BASE) &&
          (attr <= NV_CTRL_ATTR_NVML_LAST_ATTRIBUTE))) {
@@ -909,6 +1549,130 @@ ReturnStatus NvCtrlSetDisplayAttribute(CtrlTarget *ctrl_target,
 }
 
 
+
+/*
+ * Returns whether the assignment can be made by batching it with other
+ * NV-CONTROL assignments, as for IsNvControlBatchQuery(): the attribute
+ * must be an NV-CONTROL one, and not handled by NVML for the targets
+ * NVML knows about.  In the latter case, the assignment is made right
+ * away and 'done' is set.
+ */
+
+static Bool IsNvControlBatchAssignment(CtrlAttributeAssignment *assignment,
+                                       Bool *done)
+{
+    const NvCtrlAttributePrivateHandle *h =
+        getPrivateHandleConst(assignment->ctrl_target);
+    ReturnStatus ret;
+
+    *done = False;
+
+    if ((h == NULL) || !h->nv ||
+        (assignment->attr < 0) || (assignment->attr > NV_CTRL_LAST_ATTRIBUTE)) {
+        return False;
+    }
+
+    switch (h->target_type) {
+        case GPU_TARGET:
+        case THERMAL_SENSOR_TARGET:
+        case COOLER_TARGET:
+            ret = NvCtrlNvmlSetAttribute(assignment->ctrl_target,
+                                         assignment->attr,
+                                         assignment->display_mask,
+                                         assignment->val);
+            if ((ret != NvCtrlMissingExtension) &&
+                (ret != NvCtrlBadHandle) &&
+                (ret != NvCtrlNotSupported)) {
+                assignment->status = ret;
+                *done = True;
+                return False;
+            }
+            /* Fall through */
+        case DISPLAY_TARGET:
+        case X_SCREEN_TARGET:
+        case FRAMELOCK_TARGET:
+        case NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET:
+        case MUX_TARGET:
+            return True;
+        default:
+            return False;
+    }
+}
+
+
+
+ReturnStatus NvCtrlSetAttributesBatch(CtrlAttributeAssignment *assignments,
+                                      int count)
+{
+    CtrlAttributeAssignment **pending, **batch;
+    int i, j, numPending = 0;
+
+    if (assignments == NULL) {
+        return NvCtrlBadArgument;
+    }
+
+    pending = nvalloc(count * sizeof(CtrlAttributeAssignment *));
+    batch = nvalloc(count * sizeof(CtrlAttributeAssignment *));
+
+    /*
+     * Make whatever does not need an NV-CONTROL round trip right away, and
+     * set the rest aside.
+     */
+
+    for (i = 0; i < count; i++) {
+        CtrlAttributeAssignment *assignment = &assignments[i];
+        NvCtrlAttributePrivateHandle *h =
+            getPrivateHandle(assignment->ctrl_target);
+        Bool done;
+
+        assignment->status = NvCtrlError;
+
+        if (h && h->cache) {
+            CacheInvalidate(h->cache, False, assignment->attr);
+        }
+
+        if (IsNvControlBatchAssignment(assignment, &done)) {
+            pending[numPending++] = assignment;
+        } else if (!done) {
+            assignment->status =
+                NvCtrlSetDisplayAttribute(assignment->ctrl_target,
+                                          assignment->display_mask,
+                                          assignment->attr,
+                                          assignment->val);
+        }
+    }
+
+    /* Send the NV-CONTROL assignments, one batch per X server connection */
+
+    for (i = 0; i < numPending; i++) {
+        Display *dpy;
+        int batchCount = 0;
+
+        if (pending[i] == NULL) {
+            continue;
+        }
+
+        dpy = getPrivateHandleConst(pending[i]->ctrl_target)->dpy;
+
+        for (j = i; j < numPending; j++) {
+            if ((pending[j] != NULL) &&
+                (getPrivateHandleConst(pending[j]->ctrl_target)->dpy == dpy)) {
+                batch[batchCount++] = pending[j];
+                pending[j] = NULL;
+            }
+        }
+
+        NvCtrlNvControlSetAttributesBatch(dpy, batch, batchCount);
+    }
+
+    nvfree(batch);
+    nvfree(pending);
+
+    return NvCtrlSuccess;
+
+} /* NvCtrlSetAttributesBatch() */
+
+
 ReturnStatus NvCtrlGetVoidDisplayAttribute(const CtrlTarget *ctrl_target,
                                            unsigned int display_mask,
                                            int attr, void **ptr)
@@ -991,6 +1755,108 @@ NvCtrlGetValidDisplayAttributeValues(const CtrlTarget *ctrl_target,
 } /* NvCtrlGetValidDisplayAttributeValues() */
 
 
+/*
+ * Returns whether the valid values query can be batched with other
+ * NV-CONTROL queries, as for IsNvControlBatchQuery(); valid values
+ * available from NVML are filled in directly.
+ */
+
+static Bool IsNvControlBatchValidValuesQuery(CtrlAttributeValidValuesQuery *query)
+{
+    const NvCtrlAttributePrivateHandle *h =
+        getPrivateHandleConst(query->ctrl_target);
+
+    if ((h == NULL) || !h->nv ||
+        (query->attr < 0) || (query->attr > NV_CTRL_LAST_ATTRIBUTE)) {
+        return False;
+    }
+
+    switch (h->target_type) {
+        case GPU_TARGET:
+        case THERMAL_SENSOR_TARGET:
+        case COOLER_TARGET:
+            if (NvCtrlNvmlGetValidAttributeValues(query->ctrl_target,
+                                                  query->attr,
+                                                  &query->val) ==
+                NvCtrlSuccess) {
+                query->status = NvCtrlSuccess;
+                return False;
+            }
+            /* Fall through */
+        case DISPLAY_TARGET:
+        case X_SCREEN_TARGET:
+        case FRAMELOCK_TARGET:
+        case NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET:
+        case MUX_TARGET:
+            return True;
+        default:
+            return False;
+    }
+}
+
+
+
+ReturnStatus
+NvCtrlGetValidAttributeValuesBatch(CtrlAttributeValidValuesQuery *queries,
+                                   int count)
+{
+    CtrlAttributeValidValuesQuery **pending, **batch;
+    int i, j, numPending = 0;
+
+    if (queries == NULL) {
+        return NvCtrlBadArgument;
+    }
+
+    pending = nvalloc(count * sizeof(CtrlAttributeValidValuesQuery *));
+    batch = nvalloc(count * sizeof(CtrlAttributeValidValuesQuery *));
+
+    for (i = 0; i < count; i++) {
+        CtrlAttributeValidValuesQuery *query = &queries[i];
+
+        query->status = NvCtrlError;
+
+        if (IsNvControlBatchValidValuesQuery(query)) {
+            pending[numPending++] = query;
+        } else if (query->status != NvCtrlSuccess) {
+            query->status =
+                NvCtrlGetValidDisplayAttributeValues(query->ctrl_target,
+                                                     query->display_mask,
+                                                     query->attr,
+                                                     &query->val);
+        }
+    }
+
+    /* Send the NV-CONTROL queries, one batch per X server connection */
+
+    for (i = 0; i < numPending; i++) {
+        Display *dpy;
+        int batchCount = 0;
+
+        if (pending[i] == NULL) {
+            continue;
+        }
+
+        dpy = getPrivateHandleConst(pending[i]->ctrl_target)->dpy;
+
+        for (j = i; j < numPending; j++) {
+            if ((pending[j] != NULL) &&
+                (getPrivateHandleConst(pending[j]->ctrl_target)->dpy == dpy)) {
+                batch[batchCount++] = pending[j];
+                pending[j] = NULL;
+            }
+        }
+
+        NvCtrlNvControlGetValidAttributeValuesBatch(dpy, batch, batchCount);
+    }
+
+    nvfree(batch);
+    nvfree(pending);
+
+    return NvCtrlSuccess;
+
+} /* NvCtrlGetValidAttributeValuesBatch() */
+
+
 /*
  * GetValidStringDisplayAttributeValuesExtraAttr() -fill the
  * CtrlAttributeValidValues strucure for extra string attributes i.e.
@@ -1106,9 +1972,9 @@ NvCtrlGetValidStringDisplayAttributeValues(const CtrlTarget *ctrl_target,
 } /* NvCtrlGetValidStringDisplayAttributeValues() */
 
 
-ReturnStatus NvCtrlGetStringDisplayAttribute(const CtrlTarget *ctrl_target,
-                                             unsigned int display_mask,
-                                             int attr, char **ptr)
+static ReturnStatus QueryStringDisplayAttribute(const CtrlTarget *ctrl_target,
+                                                unsigned int display_mask,
+                                                int attr, char **ptr)
 {
     const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
 
@@ -1184,6 +2050,35 @@ ReturnStatus NvCtrlGetStringDisplayAttribute(const CtrlTarget *ctrl_target,
             return NvCtrlBadHandle;
     }
 
+} /* QueryStringDisplayAttribute() */
+
+
+ReturnStatus NvCtrlGetStringDisplayAttribute(const CtrlTarget *ctrl_target,
+                                             unsigned int display_mask,
+                                             int attr, char **ptr)
+{
+    const NvCtrlAttributePrivateHandle *h = getPrivateHandleConst(ctrl_target);
+    const NvCtrlCachedAttribute *entry;
+    ReturnStatus status;
+
+    if ((h == NULL) || (h->cache == NULL)) {
+        return QueryStringDisplayAttribute(ctrl_target, display_mask, attr,
+                                           ptr);
+    }
+
+    entry = CacheLookup(h->cache, True, display_mask, attr);
+    if (entry) {
+        *ptr = entry->str ? nvstrdup(entry->str) : NULL;
+        return NvCtrlSuccess;
+    }
+
+    status = QueryStringDisplayAttribute(ctrl_target, display_mask, attr, ptr);
+    if (status == NvCtrlSuccess) {
+        CacheStore(h->cache, True, display_mask, attr, 0, *ptr);
+    }
+
+    return status;
+
 } /* NvCtrlGetStringDisplayAttribute() */
 
 
@@ -1197,6 +2092,10 @@ ReturnStatus NvCtrlSetStringDisplayAttribute(CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
+    if (h->cache) {
+        CacheInvalidate(h->cache, True, attr);
+    }
+
     if ((attr >= 0) && (attr <= NV_CTRL_STRING_LAST_ATTRIBUTE)) {
         switch (h->target_type) {
             case GPU_TARGET:
@@ -1352,6 +2251,9 @@ void NvCtrlAttributeClose(NvCtrlAttributeHandle *handle)
     if ( h->nvml ) {
         NvCtrlNvmlAttributesClose(h);
     }
+    if ( h->cache ) {
+        DisableAttributeCache(h);
+    }
 
     free(h);
 } /* NvCtrlAttributeClose() */
@@ -1501,6 +2403,61 @@ ReturnStatus NvCtrlSetColorAttributes(CtrlTarget *ctrl_target,
 }
 
 
+ReturnStatus NvCtrlQueueColorAttributes(CtrlTarget *ctrl_target,
+                                        float c[3],
+                                        float b[3],
+                                        float g[3],
+                                        unsigned int bitmask,
+                                        Bool *sent)
+{
+    ReturnStatus status;
+    int val = 0;
+
+    NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
+
+    *sent = False;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    /* Only XRandR ramps are coalesced */
+
+    if (h->target_type == DISPLAY_TARGET) {
+        status = NvCtrlGetAttribute(ctrl_target,
+                                    NV_CTRL_ATTR_RANDR_GAMMA_AVAILABLE,
+                                    &val);
+        if (status != NvCtrlSuccess || !val) {
+            return NvCtrlError;
+        }
+        return NvCtrlXrandrQueueColorAttributes(h, c, b, g, bitmask, sent);
+    }
+
+    status = NvCtrlSetColorAttributes(ctrl_target, c, b, g, bitmask);
+    *sent = (status == NvCtrlSuccess);
+
+    return status;
+}
+
+
+ReturnStatus NvCtrlFlushColorAttributes(CtrlTarget *ctrl_target, Bool *sent)
+{
+    NvCtrlAttributePrivateHandle *h = getPrivateHandle(ctrl_target);
+
+    *sent = False;
+
+    if (h == NULL) {
+        return NvCtrlBadHandle;
+    }
+
+    if (h->target_type != DISPLAY_TARGET) {
+        return NvCtrlSuccess;
+    }
+
+    return NvCtrlXrandrFlushColorAttributes(h, sent);
+}
+
+
 ReturnStatus NvCtrlGetColorRamp(const CtrlTarget *ctrl_target,
                                 unsigned int channel,
                                 uint16_t **lut,
@@ -1556,24 +2513,29 @@ void NvCtrlInitGammaInputStruct(NvCtrlGammaInput *pGammaInput)
 }
 
 /*
- * Compute the gammaRamp entry given its index, and the contrast,
+ * Compute the gammaRamp entries of one channel given the contrast,
  * brightness, and gamma.
+ *
+ * Everything that does not depend on the entry index is computed once,
+ * rounded to float where the scaled contrast, brightness and inverse gamma
+ * always were, so that the ramp is identical to what it was when each entry
+ * was computed on its own; pow() is only called for the entries that were
+ * not clamped to either end of the ramp.
  */
-static unsigned short ComputeGammaRampVal(int gammaRampSize,
-                                          int i,
-                                          float contrast,
-                                          float brightness,
-                                          float gamma)
+static void ComputeGammaRamp(int gammaRampSize,
+                             float contrast,
+                             float brightness,
+                             float gamma,
+                             unsigned short *gammaRamp)
 {
-    double j, half, scale;
-    int shift, val, num;
+    double j, half, scale, factor;
+    int i, shift, val, num;
 
     num = gammaRampSize - 1;
     shift = 16 - (ffs(gammaRampSize) - 1);
 
     scale = (double) num / 3.0; /* how much brightness and contrast
                                    affect the value */
-    j = (double) i;
 
     /* contrast */
 
@@ -1581,40 +2543,40 @@ static unsigned short ComputeGammaRampVal(int gammaRampSize,
 
     if (contrast > 0.0) {
         half = ((double) num / 2.0) - 1.0;
-        j -= half;
-        j *= half / (half - contrast);
-        j += half;
+        factor = half / (half - contrast);
     } else {
         half = (double) num / 2.0;
-        j -= half;
-        j *= (half + contrast) / half;
-        j += half;
+        factor = (half + contrast) / half;
     }
 
     /* brightness */
 
     brightness *= scale;
 
-    j += brightness;
-    if (j > (double)num) {
-        j = (double)num;
-    }
-    if (j < 0.0) {
-        j = 0.0;
-    }
-
     /* gamma */
 
     gamma = 1.0 / (double) gamma;
 
-    if (gamma == 1.0) {
-        val = (int) j;
-    } else {
-        val = (int) (pow (j / (double)num, gamma) * (double)num + 0.5);
-    }
+    for (i = 0; i < gammaRampSize; i++) {
+        j = (double) i;
+
+        j -= half;
+        j *= factor;
+        j += half;
 
-    val <<= shift;
-    return (unsigned short) val;
+        j += brightness;
+        if (j >= (double)num) {
+            val = num;
+        } else if (j <= 0.0) {
+            val = 0;
+        } else if (gamma == 1.0) {
+            val = (int) j;
+        } else {
+            val = (int) (pow (j / (double)num, gamma) * (double)num + 0.5);
+        }
+
+        gammaRamp[i] = (unsigned short) (val << shift);
+    }
 }
 
 void NvCtrlUpdateGammaRamp(const NvCtrlGammaInput *pGammaInput,
@@ -1622,7 +2584,7 @@ void NvCtrlUpdateGammaRamp(const NvCtrlGammaInput *pGammaInput,
                            unsigned short *gammaRamp[3],
                            unsigned int bitmask)
 {
-    int i, ch;
+    int ch, other;
 
     /* update the requested channels within the gammaRamp */
 
@@ -1634,14 +2596,32 @@ void NvCtrlUpdateGammaRamp(const NvCtrlGammaInput *pGammaInput,
             continue;
         }
 
-        for (i = 0; i < gammaRampSize; i++) {
-            gammaRamp[ch][i] =
-                ComputeGammaRampVal(gammaRampSize,
-                                    i,
-                                    pGammaInput->contrast[ch],
-                                    pGammaInput->brightness[ch],
-                                    pGammaInput->gamma[ch]);
+        /*
+         * channels are usually adjusted together; reuse the ramp of an
+         * already updated channel with the same input, if any
+         */
+
+        for (other = FIRST_COLOR_CHANNEL; other < ch; other++) {
+            if ((bitmask & (1 << other)) &&
+                (pGammaInput->contrast[other] == pGammaInput->contrast[ch]) &&
+                (pGammaInput->brightness[other] ==
+                 pGammaInput->brightness[ch]) &&
+                (pGammaInput->gamma[other] == pGammaInput->gamma[ch])) {
+                break;
+            }
+        }
+
+        if (other < ch) {
+            memcpy(gammaRamp[ch], gammaRamp[other],
+                   gammaRampSize * sizeof(unsigned short));
+            continue;
         }
+
+        ComputeGammaRamp(gammaRampSize,
+                         pGammaInput->contrast[ch],
+                         pGammaInput->brightness[ch],
+                         pGammaInput->gamma[ch],
+                         gammaRamp[ch]);
     }
 }
 
@@ -1706,18 +2686,22 @@ NvCtrlEventHandle *NvCtrlGetEventHandle(const CtrlTarget *ctrl_target)
         return NULL;
     }
 
-    if (!h->dpy && !h->nv && h->nvml) {
-        /* We are running with NVML lib only. Events not yet supported.*/
+    if (!h->dpy && !h->nv && !h->nvml) {
         return NULL;
     }
 
-    /* Look for the event handle */
+    /*
+     * Look for the event handle.  When running with the NVML lib only,
+     * events come from the NVML instance of the system rather than from
+     * a display connection.
+     */
     evt_h = NULL;
     for (evt_hnode = __event_handles;
          evt_hnode;
          evt_hnode = evt_hnode->next) {
 
-        if (evt_hnode->handle->dpy == h->dpy) {
+        if ((evt_hnode->handle->dpy == h->dpy) &&
+            (h->dpy || (evt_hnode->handle->nvml == h->nvml))) {
             evt_h = evt_hnode->handle;
             break;
         }
@@ -1727,9 +2711,23 @@ NvCtrlEventHandle *NvCtrlGetEventHandle(const CtrlTarget *ctrl_target)
     if (!evt_h) {
         evt_h = nvalloc(sizeof(*evt_h));
         evt_h->dpy = h->dpy;
-        evt_h->fd = ConnectionNumber(h->dpy);
-        evt_h->nvctrl_event_base = (h->nv) ? h->nv->event_base : -1;
-        evt_h->xrandr_event_base = (h->xrandr) ? h->xrandr->event_base : -1;
+
+        if (h->dpy) {
+            evt_h->fd = ConnectionNumber(h->dpy);
+            evt_h->nvctrl_event_base = (h->nv) ? h->nv->event_base : -1;
+            evt_h->xrandr_event_base =
+                (h->xrandr) ? h->xrandr->event_base : -1;
+        } else {
+            evt_h->nvml = h->nvml;
+            evt_h->nvml_events = NvCtrlNvmlCreateEventSource(h->nvml);
+            if (!evt_h->nvml_events) {
+                free(evt_h);
+                return NULL;
+            }
+            evt_h->fd = NvCtrlNvmlEventSourceGetFD(evt_h->nvml_events);
+            evt_h->nvctrl_event_base = -1;
+            evt_h->xrandr_event_base = -1;
+        }
 
         /* Add it to the list of event handles */
         evt_hnode = nvalloc(sizeof(*evt_hnode));
@@ -1792,6 +2790,7 @@ NvCtrlCloseEventHandle(NvCtrlEventHandle *handle)
     return NvCtrlBadHandle;
 
 free_handle:
+    NvCtrlNvmlDestroyEventSource(evt_hnode->handle->nvml_events);
     free(handle);
     free(evt_hnode);
 
@@ -1825,6 +2824,11 @@ NvCtrlEventHandlePending(NvCtrlEventHandle *handle, Bool *pending)
 
     evt_h = (NvCtrlEventPrivateHandle*)handle;
 
+    if (evt_h->nvml_events) {
+        *pending = NvCtrlNvmlEventSourcePending(evt_h->nvml_events);
+        return NvCtrlSuccess;
+    }
+
     if (XPending(evt_h->dpy)) {
         *pending = TRUE;
     } else {
@@ -1866,6 +2870,21 @@ NvCtrlEventHandleNextEvent(NvCtrlEventHandle *handle, CtrlEvent *event)
     memset(event, 0, sizeof(CtrlEvent));
 
 
+    /*
+     * Handle NVML events
+     */
+    if (evt_h->nvml_events) {
+        ReturnStatus status =
+            NvCtrlNvmlEventSourceNextEvent(evt_h->nvml_events, event);
+
+        if (status == NvCtrlSuccess) {
+            InvalidateCachedEventAttribute(NULL, event);
+        }
+
+        return status;
+    }
+
+
     /*
      * if NvCtrlEventHandleNextEvent() is called, then
      * NvCtrlEventHandlePending() returned TRUE, so we
@@ -1897,6 +2916,8 @@ NvCtrlEventHandleNextEvent(NvCtrlEventHandle *handle, CtrlEvent *event)
             event->int_attr.value                   = nvctrlevent->value;
             event->int_attr.is_availability_changed = FALSE;
 
+            InvalidateCachedEventAttribute(evt_h->dpy, event);
+
             return NvCtrlSuccess;
         }
 
@@ -1917,6 +2938,8 @@ NvCtrlEventHandleNextEvent(NvCtrlEventHandle *handle, CtrlEvent *event)
             event->int_attr.value                   = nvctrlevent->value;
             event->int_attr.is_availability_changed = FALSE;
 
+            InvalidateCachedEventAttribute(evt_h->dpy, event);
+
             return NvCtrlSuccess;
         }
 
@@ -1938,6 +2961,8 @@ NvCtrlEventHandleNextEvent(NvCtrlEventHandle *handle, CtrlEvent *event)
             event->int_attr.is_availability_changed = TRUE;
             event->int_attr.availability            = nvctrlevent->availability;
 
+            InvalidateCachedEventAttribute(evt_h->dpy, event);
+
             return NvCtrlSuccess;
         }
 
@@ -1956,6 +2981,8 @@ NvCtrlEventHandleNextEvent(NvCtrlEventHandle *handle, CtrlEvent *event)
 
             event->str_attr.attribute = nvctrlevent->attribute;
 
+            InvalidateCachedEventAttribute(evt_h->dpy, event);
+
             return NvCtrlSuccess;
         }
 
@@ -102,6 +102,7 @@ typedef struct _CtrlTarget CtrlTarget;
 typedef struct _CtrlTargetNode CtrlTargetNode;
 typedef struct _CtrlSystem CtrlSystem;
 typedef struct _CtrlSystemList CtrlSystemList;
+typedef struct _CtrlTargetNameEntry CtrlTargetNameEntry;
 
 struct _CtrlTarget {
     NvCtrlAttributeHandle *h; /* handle for this target */
@@ -141,9 +142,18 @@ struct _CtrlSystem {
     Bool has_nv_control;
     Bool has_nvml;
     void *wayland_output;
+    void *nvml_attributes; /* NVML state shared by all the system's targets */
+    void *attribute_perms; /* permissions shared by the system's targets */
 
     CtrlTargetNode *targets[MAX_TARGET_TYPES]; /* Shadows targetTypeTable */
     CtrlTargetNode *physical_screens;
+
+    /* Lookup indices of 'targets', maintained by nv_add_target() */
+    int target_count[MAX_TARGET_TYPES];
+    CtrlTarget **targets_by_id[MAX_TARGET_TYPES]; /* indexed by target id */
+    int targets_by_id_len[MAX_TARGET_TYPES];
+    CtrlTargetNameEntry **targets_by_name; /* hash table of proto names */
+
     CtrlSystemList *system_list; /* pointer to the system list being tracked */
 };
 
@@ -441,6 +451,50 @@ typedef struct {
 } CtrlAttributeValidValues;
 
 
+/*
+ * Used to query several integer attributes at once with
+ * NvCtrlGetAttributesBatch(); 'val' and 'status' are filled in by the
+ * query.
+ */
+typedef struct {
+    const CtrlTarget *ctrl_target;
+    unsigned int display_mask;
+    int attr;
+
+    int64_t val;
+    ReturnStatus status;
+} CtrlAttributeQuery;
+
+
+/*
+ * Used to query the valid values of several integer attributes at once
+ * with NvCtrlGetValidAttributeValuesBatch(); 'val' and 'status' are
+ * filled in by the query.
+ */
+typedef struct {
+    const CtrlTarget *ctrl_target;
+    unsigned int display_mask;
+    int attr;
+
+    CtrlAttributeValidValues val;
+    ReturnStatus status;
+} CtrlAttributeValidValuesQuery;
+
+
+/*
+ * Used to assign several integer attributes at once with
+ * NvCtrlSetAttributesBatch(); 'status' is filled in by the assignment.
+ */
+typedef struct {
+    CtrlTarget *ctrl_target;
+    unsigned int display_mask;
+    int attr;
+    int val;
+
+    ReturnStatus status;
+} CtrlAttributeAssignment;
+
+
 /*
  * Event handle and event structure used to provide an event mechanism to
  * communicate different backends with the frontend
@@ -618,6 +672,8 @@ int         NvCtrlGetTargetTypeCount    (const CtrlSystem *system,
 CtrlTarget *NvCtrlGetTarget             (const CtrlSystem *system,
                                          CtrlTargetType target_type,
                                          int target_id);
+CtrlTargetNode *NvCtrlGetTargetsByName  (const CtrlSystem *system,
+                                         const char *name);
 CtrlTarget *NvCtrlGetDefaultTarget      (const CtrlSystem *system);
 CtrlTarget *NvCtrlGetDefaultTargetByType(const CtrlSystem *system,
                                          CtrlTargetType target_type);
@@ -671,6 +727,33 @@ ReturnStatus NvCtrlSetColorAttributes(CtrlTarget *ctrl_target,
                                       float gamma[3],
                                       unsigned int flags);
 
+/*
+ * NvCtrlQueueColorAttributes() - same as NvCtrlSetColorAttributes(),
+ * except that the color ramp of a display target is not sent to the X
+ * server if one was sent within the last NV_CTRL_COLOR_UPDATE_INTERVAL
+ * milliseconds; it is then left pending, superseding any earlier pending
+ * ramp, until NvCtrlFlushColorAttributes() is called.  On success, 'sent'
+ * tells whether the ramp was sent.  This lets interactive clients apply
+ * values as often as they change without flooding the server.
+ */
+
+#define NV_CTRL_COLOR_UPDATE_INTERVAL 16 /* ms */
+
+ReturnStatus NvCtrlQueueColorAttributes(CtrlTarget *ctrl_target,
+                                        float contrast[3],
+                                        float brightness[3],
+                                        float gamma[3],
+                                        unsigned int flags,
+                                        Bool *sent);
+
+/*
+ * NvCtrlFlushColorAttributes() - sends the color ramp left pending by
+ * NvCtrlQueueColorAttributes(), if any; 'sent' tells whether there was
+ * one.
+ */
+
+ReturnStatus NvCtrlFlushColorAttributes(CtrlTarget *ctrl_target, Bool *sent);
+
 /*
  * NvCtrlGetColorRamp() - get a pointer to the current color ramp for
  * the specified channel; values in the ramp are scaled [0,65536).  If
@@ -740,7 +823,11 @@ ReturnStatus NvCtrlGetValidAttributeValues(const CtrlTarget *ctrl_target,
 
 
 /*
- * NvCtrlGetAttributePerms() - get the attribute permissions.
+ * NvCtrlGetAttributePerms() - get the attribute permissions.  The
+ * permissions of an attribute are the same for all the targets of a type
+ * and do not change while the driver is loaded: they are queried once per
+ * target type, and then served from a table shared by all the targets of
+ * the system.
  */
 
 ReturnStatus NvCtrlGetAttributePerms(const CtrlTarget *ctrl_target,
@@ -748,6 +835,17 @@ ReturnStatus NvCtrlGetAttributePerms(const CtrlTarget *ctrl_target,
                                      int attr,
                                      CtrlAttributePerms *perms);
 
+/*
+ * NvCtrlPrefetchAttributePerms() - fill the permissions table of the
+ * target's system with the permissions of the 'count' integer attributes
+ * in 'attrs' for the target's type.  The NV-CONTROL queries are sent as a
+ * single batch, so this is cheaper than the NvCtrlGetAttributePerms()
+ * calls it saves.
+ */
+
+ReturnStatus NvCtrlPrefetchAttributePerms(const CtrlTarget *ctrl_target,
+                                          const int *attrs, int count);
+
 
 /*
  * NvCtrlGetStringAttribute() - get the string associated with the
@@ -783,6 +881,50 @@ ReturnStatus NvCtrlGetDisplayAttribute64(const CtrlTarget *ctrl_target,
                                          unsigned int display_mask,
                                          int attr, int64_t *val);
 
+/*
+ * NvCtrlGetAttributesBatch() - behaves like calling
+ * NvCtrlGetDisplayAttribute64() on each of the 'count' queries, except
+ * that the NV-CONTROL queries going to the same X server are sent
+ * together and cost a single round trip.  The result of each query is
+ * returned in its 'status' field; the function itself returns
+ * NvCtrlBadArgument if 'queries' is NULL, and NvCtrlSuccess otherwise.
+ * Successful results are also stored in the attribute cache of the
+ * targets that have one (see NvCtrlEnableAttributeCache()).
+ */
+
+ReturnStatus NvCtrlGetAttributesBatch(CtrlAttributeQuery *queries, int count);
+
+/*
+ * NvCtrlSetAttributesBatch() - behaves like calling
+ * NvCtrlSetDisplayAttribute() on each of the 'count' assignments, except
+ * that the NV-CONTROL assignments going to the same X server are sent
+ * together, in order, and cost a single round trip.  Assignments handled
+ * by NVML are made as they are encountered.  The result of each
+ * assignment is returned in its 'status' field; the function itself
+ * returns NvCtrlBadArgument if 'assignments' is NULL, and NvCtrlSuccess
+ * otherwise.
+ */
+
+ReturnStatus NvCtrlSetAttributesBatch(CtrlAttributeAssignment *assignments,
+                                      int count);
+
+/*
+ * NvCtrlEnableAttributeCache() - enable or disable caching of the integer
+ * and string attribute values read from the given target.  Values of
+ * attributes that cannot change while the driver is loaded (PCI ids, bus
+ * type, VBIOS version, ...) are kept until the cache is disabled; other
+ * values are reused for a short time only.  Setting an attribute, or
+ * receiving an event reporting its change, drops its cached value.
+ *
+ * NvCtrlGetAttributeCacheStats() returns the number of reads served from
+ * the cache and the number of reads that had to query the target.
+ */
+
+void NvCtrlEnableAttributeCache(CtrlTarget *ctrl_target, Bool enable);
+
+void NvCtrlGetAttributeCacheStats(const CtrlTarget *ctrl_target,
+                                  unsigned int *hits, unsigned int *misses);
+
 ReturnStatus NvCtrlGetVoidDisplayAttribute(const CtrlTarget *ctrl_target,
                                            unsigned int display_mask,
                                            int attr, void **val);
@@ -791,6 +933,20 @@ ReturnStatus
 NvCtrlGetValidDisplayAttributeValues(const CtrlTarget *ctrl_target,
                                      unsigned int display_mask, int attr,
                                      CtrlAttributeValidValues *val);
+
+/*
+ * NvCtrlGetValidAttributeValuesBatch() - behaves like calling
+ * NvCtrlGetValidDisplayAttributeValues() on each of the 'count' queries,
+ * except that the NV-CONTROL queries going to the same X server are sent
+ * together and cost a single round trip.  The result of each query is
+ * returned in its 'status' field; the function itself returns
+ * NvCtrlBadArgument if 'queries' is NULL, and NvCtrlSuccess otherwise.
+ */
+
+ReturnStatus
+NvCtrlGetValidAttributeValuesBatch(CtrlAttributeValidValuesQuery *queries,
+                                   int count);
+
 ReturnStatus
 NvCtrlGetValidStringDisplayAttributeValues(const CtrlTarget *ctrl_target,
                                            unsigned int display_mask, int attr,
@@ -239,6 +239,55 @@ ReturnStatus NvCtrlNvControlGetAttribute(const NvCtrlAttributePrivateHandle *h,
 } /* NvCtrlNvControlGetAttribute() */
 
 
+/*
+ * NvCtrlNvControlGetAttributesBatch() - query the 'count' integer
+ * attributes in 'queries' with a single NV-CONTROL round trip.  All the
+ * queries must be for targets sharing the display connection 'dpy' and
+ * for attributes in the NV-CONTROL range; the result of each query is
+ * stored in its 'val' and 'status' fields.
+ */
+
+void NvCtrlNvControlGetAttributesBatch(Display *dpy,
+                                       CtrlAttributeQuery **queries,
+                                       int count)
+{
+    XNVCTRLAttributeQuery *xqueries;
+    int i;
+
+    xqueries = nvalloc(count * sizeof(XNVCTRLAttributeQuery));
+
+    for (i = 0; i < count; i++) {
+        const NvCtrlAttributePrivateHandle *h =
+            getPrivateHandleConst(queries[i]->ctrl_target);
+        const CtrlTargetTypeInfo *targetTypeInfo =
+            NvCtrlGetTargetTypeInfo(h->target_type);
+
+        xqueries[i].target_type = targetTypeInfo->nvctrl;
+        xqueries[i].target_id = h->target_id;
+        xqueries[i].display_mask = queries[i]->display_mask;
+        xqueries[i].attribute = queries[i]->attr;
+    }
+
+    if (!XNVCTRLQueryTargetAttributes64(dpy, xqueries, count)) {
+        for (i = 0; i < count; i++) {
+            xqueries[i].exists = False;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (xqueries[i].exists) {
+            queries[i]->val = xqueries[i].value;
+            queries[i]->status = NvCtrlSuccess;
+        } else {
+            queries[i]->status = NvCtrlAttributeNotAvailable;
+        }
+    }
+
+    nvfree(xqueries);
+
+} /* NvCtrlNvControlGetAttributesBatch() */
+
+
 ReturnStatus NvCtrlNvControlSetAttribute (NvCtrlAttributePrivateHandle *h,
                                           unsigned int display_mask,
                                           int attr, int val)
@@ -266,6 +315,52 @@ ReturnStatus NvCtrlNvControlSetAttribute (NvCtrlAttributePrivateHandle *h,
 }
 
 
+/*
+ * NvCtrlNvControlSetAttributesBatch() - assign the 'count' integer
+ * attributes in 'assignments' with a single NV-CONTROL round trip, in
+ * order.  All the assignments must be for targets sharing the display
+ * connection 'dpy' and for attributes in the NV-CONTROL range; the
+ * result of each assignment is stored in its 'status' field.
+ */
+
+void NvCtrlNvControlSetAttributesBatch(Display *dpy,
+                                       CtrlAttributeAssignment **assignments,
+                                       int count)
+{
+    XNVCTRLAttributeAssignment *xassignments;
+    int i;
+
+    xassignments = nvalloc(count * sizeof(XNVCTRLAttributeAssignment));
+
+    for (i = 0; i < count; i++) {
+        const NvCtrlAttributePrivateHandle *h =
+            getPrivateHandleConst(assignments[i]->ctrl_target);
+        const CtrlTargetTypeInfo *targetTypeInfo =
+            NvCtrlGetTargetTypeInfo(h->target_type);
+
+        xassignments[i].target_type = targetTypeInfo->nvctrl;
+        xassignments[i].target_id = h->target_id;
+        xassignments[i].display_mask = assignments[i]->display_mask;
+        xassignments[i].attribute = assignments[i]->attr;
+        xassignments[i].value = assignments[i]->val;
+    }
+
+    if (!XNVCTRLSetTargetAttributesAndGetStatus(dpy, xassignments, count)) {
+        for (i = 0; i < count; i++) {
+            xassignments[i].success = False;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        assignments[i]->status =
+            xassignments[i].success ? NvCtrlSuccess : NvCtrlError;
+    }
+
+    nvfree(xassignments);
+
+} /* NvCtrlNvControlSetAttributesBatch() */
+
+
 /*
  * Helper function for converting NV-CONTROL specific permission data into
  * CtrlAttributePerms (API agnostic) permission data that the front-end can use.
@@ -345,6 +440,47 @@ NvCtrlNvControlGetAttributePerms(const NvCtrlAttributePrivateHandle *h,
 }
 
 
+/*
+ * NvCtrlNvControlGetAttributesPermsBatch() - query the permissions of the
+ * 'count' integer attributes in 'attrs' with a single NV-CONTROL round
+ * trip.  The permissions of each attribute are stored in the matching
+ * entry of 'perms', and the result of the query in that of 'status'.
+ */
+
+void NvCtrlNvControlGetAttributesPermsBatch(Display *dpy, const int *attrs,
+                                            CtrlAttributePerms *perms,
+                                            ReturnStatus *status, int count)
+{
+    XNVCTRLAttributePermissionsQuery *xqueries;
+    int i;
+
+    xqueries = nvalloc(count * sizeof(XNVCTRLAttributePermissionsQuery));
+
+    for (i = 0; i < count; i++) {
+        xqueries[i].attribute = attrs[i];
+    }
+
+    if (!XNVCTRLQueryAttributesPermissions(dpy, xqueries, count)) {
+        for (i = 0; i < count; i++) {
+            xqueries[i].exists = False;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (xqueries[i].exists) {
+            convertFromNvCtrlPermissions(&perms[i],
+                                         xqueries[i].permissions.permissions);
+            status[i] = NvCtrlSuccess;
+        } else {
+            status[i] = NvCtrlAttributeNotAvailable;
+        }
+    }
+
+    nvfree(xqueries);
+
+} /* NvCtrlNvControlGetAttributesPermsBatch() */
+
+
 /*
  * Helper function for converting NV-CONTROL specific valid values data into
  * CtrlAttributeValidValues (API agnostic) data that the front-end can use.
@@ -432,6 +568,55 @@ NvCtrlNvControlGetValidAttributeValues(const NvCtrlAttributePrivateHandle *h,
 } /* NvCtrlNvControlGetValidAttributeValues() */
 
 
+/*
+ * NvCtrlNvControlGetValidAttributeValuesBatch() - query the valid values
+ * of the 'count' integer attributes in 'queries' with a single NV-CONTROL
+ * round trip, under the same restrictions as
+ * NvCtrlNvControlGetAttributesBatch().
+ */
+
+void NvCtrlNvControlGetValidAttributeValuesBatch(Display *dpy,
+                                                 CtrlAttributeValidValuesQuery **queries,
+                                                 int count)
+{
+    XNVCTRLValidValuesQuery *xqueries;
+    int i;
+
+    xqueries = nvalloc(count * sizeof(XNVCTRLValidValuesQuery));
+
+    for (i = 0; i < count; i++) {
+        const NvCtrlAttributePrivateHandle *h =
+            getPrivateHandleConst(queries[i]->ctrl_target);
+        const CtrlTargetTypeInfo *targetTypeInfo =
+            NvCtrlGetTargetTypeInfo(h->target_type);
+
+        xqueries[i].target_type = targetTypeInfo->nvctrl;
+        xqueries[i].target_id = h->target_id;
+        xqueries[i].display_mask = queries[i]->display_mask;
+        xqueries[i].attribute = queries[i]->attr;
+    }
+
+    if (!XNVCTRLQueryValidTargetAttributesValues(dpy, xqueries, count)) {
+        for (i = 0; i < count; i++) {
+            xqueries[i].exists = False;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if (xqueries[i].exists) {
+            convertFromNvCtrlValidValues(&queries[i]->val,
+                                         &xqueries[i].values);
+            queries[i]->status = NvCtrlSuccess;
+        } else {
+            queries[i]->status = NvCtrlAttributeNotAvailable;
+        }
+    }
+
+    nvfree(xqueries);
+
+} /* NvCtrlNvControlGetValidAttributeValuesBatch() */
+
+
 ReturnStatus
 NvCtrlNvControlGetValidStringDisplayAttributeValues
                                        (const NvCtrlAttributePrivateHandle *h,
@@ -25,6 +25,9 @@
 #include <string.h>
 #include <assert.h>
 #include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
 
 #include "NvCtrlAttributes.h"
 #include "NvCtrlAttributesPrivate.h"
@@ -258,6 +261,11 @@ static Bool LoadNvml(NvCtrlNvmlAttributes *nvml)
     GET_SYMBOL(_OPTIONAL, deviceSetFanControlPolicy,       "nvmlDeviceSetFanControlPolicy");
     GET_SYMBOL(_OPTIONAL, deviceGetFanControlPolicy_v2,    "nvmlDeviceGetFanControlPolicy_v2");
     GET_SYMBOL(_OPTIONAL, deviceSetDefaultFanSpeed_v2,     "nvmlDeviceSetDefaultFanSpeed_v2");
+    GET_SYMBOL(_OPTIONAL, eventSetCreate,                  "nvmlEventSetCreate");
+    GET_SYMBOL(_OPTIONAL, eventSetWait_v2,                 "nvmlEventSetWait_v2");
+    GET_SYMBOL(_OPTIONAL, eventSetFree,                    "nvmlEventSetFree");
+    GET_SYMBOL(_OPTIONAL, deviceRegisterEvents,            "nvmlDeviceRegisterEvents");
+    GET_SYMBOL(_OPTIONAL, deviceGetSupportedEventTypes,    "nvmlDeviceGetSupportedEventTypes");
 
 #undef GET_SYMBOL
 
@@ -290,7 +298,6 @@ static Bool matchNvCtrlWithNvmlIds(const NvCtrlNvmlAttributes *nvml,
 {
     char nvmlUUID[MAX_NVML_STR_LEN];
     char *nvctrlUUID = NULL;
-    nvmlDevice_t device;
     int i, j;
     int nvctrlGpuCount = 0;
 
@@ -326,11 +333,12 @@ static Bool matchNvCtrlWithNvmlIds(const NvCtrlNvmlAttributes *nvml,
 
             /* Look for the same UUID through NVML */
             for (j = 0; j < nvmlGpuCount; j++) {
-                if (NVML_SUCCESS != nvml->lib.deviceGetHandleByIndex(j, &device)) {
+                if (nvml->devices[j] == NULL) {
                     continue;
                 }
 
-                if (NVML_SUCCESS != nvml->lib.deviceGetUUID(device, nvmlUUID,
+                if (NVML_SUCCESS != nvml->lib.deviceGetUUID(nvml->devices[j],
+                                                            nvmlUUID,
                                                             MAX_NVML_STR_LEN)) {
                     continue;
                 }
@@ -357,34 +365,56 @@ static Bool matchNvCtrlWithNvmlIds(const NvCtrlNvmlAttributes *nvml,
 
 fail:
     nvfree(*idsDictionary);
+    *idsDictionary = NULL;
     return FALSE;
 }
 
 
 
 /*
- * Initializes an NVML private handle to hold some information to be used later
- * on
+ * Unloads the NVML library and frees the device information gathered by
+ * LoadNvmlAttributes().  The structure itself is kept, so that a failure to
+ * load NVML is remembered rather than retried for every target.
+ */
+
+static void UnloadNvmlAttributes(NvCtrlNvmlAttributes *nvml)
+{
+    UnloadNvml(nvml);
+
+    nvfree(nvml->devices);
+    nvfree(nvml->nvctrlToNvmlId);
+    nvfree(nvml->sensorCountPerGPU);
+    nvfree(nvml->coolerCountPerGPU);
+
+    nvml->devices = NULL;
+    nvml->nvctrlToNvmlId = NULL;
+    nvml->sensorCountPerGPU = NULL;
+    nvml->coolerCountPerGPU = NULL;
+    nvml->deviceCount = 0;
+    nvml->sensorCount = 0;
+    nvml->coolerCount = 0;
+}
+
+
+
+/*
+ * Loads the NVML library and gathers the information shared by all the NVML
+ * targets of a system: the device handles, the NV-CONTROL to NVML IDs
+ * dictionary and the number of thermal sensors and coolers of each GPU.
+ *
+ * 'h' is the handle of the first NVML target being initialized, and is only
+ * used to reach NV-CONTROL.  On failure, the library handle is left NULL.
  */
 
-NvCtrlNvmlAttributes *NvCtrlInitNvmlAttributes(NvCtrlAttributePrivateHandle *h)
+static void LoadNvmlAttributes(NvCtrlNvmlAttributes *nvml,
+                               const NvCtrlAttributePrivateHandle *h)
 {
-    NvCtrlNvmlAttributes *nvml = NULL;
     unsigned int count;
-    unsigned int *nvctrlToNvmlId;
     int i;
     int nvctrlCoolerCount;
 
-    /* Check parameters */
-    if (h == NULL || !TARGET_TYPE_IS_NVML_COMPATIBLE(h->target_type)) {
-        goto fail;
-    }
-
-    /* Create storage for NVML attributes */
-    nvml = nvalloc(sizeof(NvCtrlNvmlAttributes));
-
     if (!LoadNvml(nvml)) {
-        goto fail;
+        return;
     }
 
     /* Initialize NVML attributes */
@@ -393,63 +423,51 @@ NvCtrlNvmlAttributes *NvCtrlInitNvmlAttributes(NvCtrlAttributePrivateHandle *h)
     }
     nvml->deviceCount = count;
 
+    nvml->devices = nvalloc(count * sizeof(nvmlDevice_t));
     nvml->sensorCountPerGPU = nvalloc(count * sizeof(unsigned int));
     nvml->sensorCount = 0;
     nvml->coolerCountPerGPU = nvalloc(count * sizeof(unsigned int));
     nvml->coolerCount = 0;
 
-    /* Fill the NV-CONTROL to NVML IDs dictionary */
-    if (!matchNvCtrlWithNvmlIds(nvml, h, count, &nvctrlToNvmlId)) {
-        goto fail;
+    for (i = 0; i < count; i++) {
+        if (nvml->lib.deviceGetHandleByIndex(i, &nvml->devices[i]) !=
+            NVML_SUCCESS) {
+            nvml->devices[i] = NULL;
+        }
     }
 
-    /*
-     * Fill 'sensorCountPerGPU', 'coolerCountPerGPU' and properly set
-     * 'deviceIdx'
-     */
-    nvml->deviceIdx = h->target_id; /* Fallback */
-
-    if (h->target_type == GPU_TARGET) {
-        nvml->deviceIdx = nvctrlToNvmlId[h->target_id];
+    /* Fill the NV-CONTROL to NVML IDs dictionary */
+    if (!matchNvCtrlWithNvmlIds(nvml, h, count, &nvml->nvctrlToNvmlId)) {
+        goto fail;
     }
 
+    /* Fill 'sensorCountPerGPU' and 'coolerCountPerGPU' */
     for (i = 0; i < count; i++) {
-        int devIdx = nvctrlToNvmlId[i];
-        nvmlDevice_t device;
-        nvmlReturn_t ret = nvml->lib.deviceGetHandleByIndex(devIdx, &device);
-        if (ret == NVML_SUCCESS) {
-            unsigned int temp;
-            unsigned int fans;
-
-            /*
-             * XXX Currently, NVML only allows to get the GPU temperature so
-             *     check for nvmlDeviceGetTemperature() success to figure
-             *     out if that sensor is available.
-             */
-            ret = nvml->lib.deviceGetTemperature(device, NVML_TEMPERATURE_GPU,
-                                                 &temp);
-            if (ret == NVML_SUCCESS) {
-                if ((h->target_type == THERMAL_SENSOR_TARGET) &&
-                    (h->target_id == nvml->sensorCount)) {
+        nvmlDevice_t device = nvml->devices[nvml->nvctrlToNvmlId[i]];
+        nvmlReturn_t ret;
+        unsigned int temp;
+        unsigned int fans;
 
-                    nvml->deviceIdx = devIdx;
-                }
-
-                nvml->sensorCountPerGPU[i] = 1;
-                nvml->sensorCount++;
-            }
-
-            ret = nvml->lib.deviceGetNumFans(device, &fans);
-            if (ret == NVML_SUCCESS) {
-                if ((h->target_type == COOLER_TARGET) &&
-                    (h->target_id == nvml->coolerCount)) {
+        if (device == NULL) {
+            continue;
+        }
 
-                    nvml->deviceIdx = devIdx;
-                }
+        /*
+         * XXX Currently, NVML only allows to get the GPU temperature so
+         *     check for nvmlDeviceGetTemperature() success to figure
+         *     out if that sensor is available.
+         */
+        ret = nvml->lib.deviceGetTemperature(device, NVML_TEMPERATURE_GPU,
+                                             &temp);
+        if (ret == NVML_SUCCESS) {
+            nvml->sensorCountPerGPU[i] = 1;
+            nvml->sensorCount++;
+        }
 
-                nvml->coolerCountPerGPU[i] = fans;
-                nvml->coolerCount += fans;
-            }
+        ret = nvml->lib.deviceGetNumFans(device, &fans);
+        if (ret == NVML_SUCCESS) {
+            nvml->coolerCountPerGPU[i] = fans;
+            nvml->coolerCount += fans;
         }
     }
 
@@ -463,22 +481,151 @@ NvCtrlNvmlAttributes *NvCtrlInitNvmlAttributes(NvCtrlAttributePrivateHandle *h)
         nv_warning_msg("Inconsistent number of fans detected.");
     }
 
-    nvfree(nvctrlToNvmlId);
-
-    return nvml;
+    return;
 
  fail:
-    UnloadNvml(nvml);
-    nvfree(nvml->sensorCountPerGPU);
-    nvfree(nvml->coolerCountPerGPU);
+    UnloadNvmlAttributes(nvml);
+}
+
+
+
+/*
+ * References to the shared NVML attributes may be taken concurrently, by the
+ * threads initializing the targets of X-less systems.
+ */
+
+static pthread_mutex_t __nvml_refcount_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void RetainNvmlAttributes(NvCtrlNvmlAttributes *nvml)
+{
+    pthread_mutex_lock(&__nvml_refcount_lock);
+    nvml->refcount++;
+    pthread_mutex_unlock(&__nvml_refcount_lock);
+}
+
+
+
+/*
+ * Drops a reference to the shared NVML attributes, unloading the NVML library
+ * once the last reference is gone.
+ */
+
+static void ReleaseNvmlAttributes(NvCtrlNvmlAttributes *nvml)
+{
+    int refcount;
+
+    if (nvml == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&__nvml_refcount_lock);
+    refcount = --nvml->refcount;
+    pthread_mutex_unlock(&__nvml_refcount_lock);
+
+    if (refcount > 0) {
+        return;
+    }
+
+    UnloadNvmlAttributes(nvml);
     nvfree(nvml);
-    return NULL;
 }
 
 
 
 /*
- * Frees any resource hold by the NVML private handle
+ * Returns the NVML index of the GPU the 'targetId'-th thermal sensor or cooler
+ * belongs to, given the number of such targets on each GPU.  Returns
+ * 'fallback' if no GPU provides that target.
+ */
+
+static unsigned int getNvmlIndexOfTarget(const NvCtrlNvmlAttributes *nvml,
+                                         const unsigned int *targetCountPerGPU,
+                                         int targetId,
+                                         unsigned int fallback)
+{
+    int i, count = 0;
+
+    for (i = 0; i < nvml->deviceCount; i++) {
+        count += targetCountPerGPU[i];
+        if (targetId < count) {
+            return nvml->nvctrlToNvmlId[i];
+        }
+    }
+
+    return fallback;
+}
+
+
+
+/*
+ * Initializes the NVML private handle of the given target.  NVML is loaded
+ * and probed only once per system, by the first NVML target initialized;
+ * the resulting NvCtrlNvmlAttributes are reference counted and shared by
+ * all the NVML targets of the system, each target only keeping the NVML
+ * index of its device.
+ */
+
+NvCtrlNvmlAttributes *NvCtrlInitNvmlAttributes(CtrlSystem *system,
+                                               NvCtrlAttributePrivateHandle *h)
+{
+    NvCtrlNvmlAttributes *nvml;
+
+    /* Check parameters */
+    if (system == NULL || h == NULL ||
+        !TARGET_TYPE_IS_NVML_COMPATIBLE(h->target_type)) {
+        return NULL;
+    }
+
+    nvml = system->nvml_attributes;
+
+    if (nvml == NULL) {
+        /* Create storage for NVML attributes; the system holds a reference */
+        nvml = nvalloc(sizeof(NvCtrlNvmlAttributes));
+        nvml->refcount = 1;
+        LoadNvmlAttributes(nvml, h);
+
+        system->nvml_attributes = nvml;
+    }
+
+    if (nvml->lib.handle == NULL) {
+        return NULL;
+    }
+
+    /* Properly set the NVML index of this target's device */
+    h->nvml_device_idx = h->target_id; /* Fallback */
+
+    switch (h->target_type) {
+        case GPU_TARGET:
+            if ((h->target_id >= 0) && (h->target_id < nvml->deviceCount)) {
+                h->nvml_device_idx = nvml->nvctrlToNvmlId[h->target_id];
+            }
+            break;
+
+        case THERMAL_SENSOR_TARGET:
+            h->nvml_device_idx =
+                getNvmlIndexOfTarget(nvml, nvml->sensorCountPerGPU,
+                                     h->target_id, h->nvml_device_idx);
+            break;
+
+        case COOLER_TARGET:
+            h->nvml_device_idx =
+                getNvmlIndexOfTarget(nvml, nvml->coolerCountPerGPU,
+                                     h->target_id, h->nvml_device_idx);
+            break;
+
+        default:
+            break;
+    }
+
+    RetainNvmlAttributes(nvml);
+
+    return nvml;
+}
+
+
+
+/*
+ * Releases the target's reference to the shared NVML private handle
  */
 
 void NvCtrlNvmlAttributesClose(NvCtrlAttributePrivateHandle *h)
@@ -488,15 +635,112 @@ void NvCtrlNvmlAttributesClose(NvCtrlAttributePrivateHandle *h)
         return;
     }
 
-    UnloadNvml(h->nvml);
-    nvfree(h->nvml->sensorCountPerGPU);
-    nvfree(h->nvml->coolerCountPerGPU);
-    nvfree(h->nvml);
+    ReleaseNvmlAttributes(h->nvml);
     h->nvml = NULL;
 }
 
 
 
+/*
+ * Releases the system's reference to the shared NVML private handle; the NVML
+ * library is unloaded once all the targets using it are closed as well.
+ */
+
+void NvCtrlNvmlSystemClose(CtrlSystem *system)
+{
+    if (system == NULL) {
+        return;
+    }
+
+    ReleaseNvmlAttributes(system->nvml_attributes);
+    system->nvml_attributes = NULL;
+}
+
+
+
+/*
+ * The cached NVML device handles are shared by all the targets of a system,
+ * which may be used concurrently by the threads initializing them, and are
+ * refilled lazily once invalidated.
+ */
+
+static pthread_mutex_t __nvml_devices_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+/*
+ * Drops all the cached NVML device handles, so that they are looked up again
+ * the next time they are used.  This is needed after a GPU has fallen off the
+ * bus or been reset, since its previous handle is no longer valid.
+ */
+
+void NvCtrlNvmlInvalidateDevices(NvCtrlNvmlAttributes *nvml)
+{
+    unsigned int i;
+
+    if (nvml == NULL || nvml->devices == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&__nvml_devices_lock);
+    for (i = 0; i < nvml->deviceCount; i++) {
+        nvml->devices[i] = NULL;
+    }
+    pthread_mutex_unlock(&__nvml_devices_lock);
+}
+
+
+
+/*
+ * Returns the cached NVML device handle for the NVML device index 'idx',
+ * querying it from NVML if it is not cached yet or has been invalidated.
+ */
+
+static nvmlReturn_t getNvmlDevice(const NvCtrlNvmlAttributes *nvml,
+                                  unsigned int idx, nvmlDevice_t *device)
+{
+    nvmlReturn_t ret = NVML_SUCCESS;
+
+    if (idx >= nvml->deviceCount) {
+        return NVML_ERROR_INVALID_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&__nvml_devices_lock);
+
+    if (nvml->devices[idx] == NULL) {
+        ret = nvml->lib.deviceGetHandleByIndex(idx, &nvml->devices[idx]);
+        if (ret != NVML_SUCCESS) {
+            nvml->devices[idx] = NULL;
+        }
+    }
+
+    *device = nvml->devices[idx];
+
+    pthread_mutex_unlock(&__nvml_devices_lock);
+
+    return ret;
+}
+
+
+
+/*
+ * Reports an NVML error and, if it indicates that a GPU went away, drops the
+ * cached device handles so that they are not reused.
+ */
+
+static void handleNvmlError(const NvCtrlNvmlAttributes *nvml,
+                            nvmlReturn_t error)
+{
+    printNvmlError(error);
+
+    if (error == NVML_ERROR_GPU_IS_LOST ||
+        error == NVML_ERROR_RESET_REQUIRED) {
+        NvCtrlNvmlInvalidateDevices((NvCtrlNvmlAttributes *) nvml);
+    }
+}
+
+
+
 /*
  * Get the number of 'target_type' targets according to NVML
  */
@@ -576,7 +820,7 @@ static ReturnStatus NvCtrlNvmlGetGeneralStringAttribute(const CtrlTarget *ctrl_t
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(h->nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -601,7 +845,7 @@ static ReturnStatus NvCtrlNvmlGetGPUStringAttribute(const CtrlTarget *ctrl_targe
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = getNvmlDevice(nvml, h->nvml_device_idx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_STRING_PRODUCT_NAME:
@@ -665,7 +909,7 @@ static ReturnStatus NvCtrlNvmlGetGPUStringAttribute(const CtrlTarget *ctrl_targe
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -734,7 +978,7 @@ static ReturnStatus NvCtrlNvmlSetGPUStringAttribute(CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = getNvmlDevice(nvml, h->nvml_device_idx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_STRING_GPU_CURRENT_CLOCK_FREQS:
@@ -758,7 +1002,7 @@ static ReturnStatus NvCtrlNvmlSetGPUStringAttribute(CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -822,7 +1066,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = getNvmlDevice(nvml, h->nvml_device_idx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_TOTAL_DEDICATED_GPU_MEMORY:
@@ -1129,7 +1373,7 @@ static ReturnStatus NvCtrlNvmlGetGPUAttribute(const CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -1146,7 +1390,7 @@ static ReturnStatus NvCtrlNvmlGetGridLicensableFeatures(const CtrlTarget *ctrl_t
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = getNvmlDevice(nvml, h->nvml_device_idx, &device);
         if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_ATTR_NVML_GPU_GRID_LICENSABLE_FEATURES:
@@ -1176,7 +1420,7 @@ static ReturnStatus NvCtrlNvmlGetGridLicensableFeatures(const CtrlTarget *ctrl_t
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -1193,7 +1437,7 @@ static ReturnStatus NvCtrlNvmlDeviceGetGspFeatures(const CtrlTarget *ctrl_target
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = getNvmlDevice(nvml, h->nvml_device_idx, &device);
     if (ret == NVML_SUCCESS) {
     switch (attr) {
         case NV_CTRL_ATTR_NVML_GSP_FIRMWARE_MODE:
@@ -1224,7 +1468,7 @@ static ReturnStatus NvCtrlNvmlDeviceGetGspFeatures(const CtrlTarget *ctrl_target
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -1278,7 +1522,7 @@ static ReturnStatus NvCtrlNvmlGetThermalAttribute(const CtrlTarget *ctrl_target,
     }
 
 
-    ret = nvml->lib.deviceGetHandleByIndex(deviceId, &device);
+    ret = getNvmlDevice(nvml, deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_SENSOR_READING:
@@ -1306,7 +1550,7 @@ static ReturnStatus NvCtrlNvmlGetThermalAttribute(const CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -1332,7 +1576,7 @@ static ReturnStatus NvCtrlNvmlGetCoolerAttribute(const CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(deviceId, &device);
+    ret = getNvmlDevice(nvml, deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_COOLER_LEVEL:
@@ -1366,7 +1610,7 @@ static ReturnStatus NvCtrlNvmlGetCoolerAttribute(const CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -1464,7 +1708,7 @@ static ReturnStatus NvCtrlNvmlSetGPUAttribute(CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = getNvmlDevice(nvml, h->nvml_device_idx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_GPU_ECC_CONFIGURATION:
@@ -1490,7 +1734,7 @@ static ReturnStatus NvCtrlNvmlSetGPUAttribute(CtrlTarget *ctrl_target,
             case NV_CTRL_GPU_COOLER_MANUAL_CONTROL:
                 {
                     int i = 0;
-                    int count = nvml->coolerCountPerGPU[nvml->deviceIdx];
+                    int count = nvml->coolerCountPerGPU[h->nvml_device_idx];
 
                     for (i = 0; i < count; i++) {
                         ret = nvml->lib.deviceSetFanControlPolicy(device, i, val);
@@ -1527,7 +1771,7 @@ static ReturnStatus NvCtrlNvmlSetGPUAttribute(CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -1552,7 +1796,7 @@ static ReturnStatus NvCtrlNvmlSetCoolerAttribute(CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(deviceId, &device);
+    ret = getNvmlDevice(nvml, deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_COOLER_LEVEL:
@@ -1577,7 +1821,7 @@ static ReturnStatus NvCtrlNvmlSetCoolerAttribute(CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -1669,7 +1913,7 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
         return NvCtrlBadHandle;
     }
 
-    ret = nvml->lib.deviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = getNvmlDevice(nvml, h->nvml_device_idx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_BINARY_DATA_COOLERS_USED_BY_GPU:
@@ -1697,7 +1941,7 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
                 *data = (unsigned char *) fan_data;
 
                 /* Calculate global fan index offset for this GPU */
-                for (i = 0; i < nvml->deviceIdx; i++) {
+                for (i = 0; i < h->nvml_device_idx; i++) {
                     offset += nvml->coolerCountPerGPU[i];
                 }
 
@@ -1757,7 +2001,7 @@ NvCtrlNvmlGetGPUBinaryAttribute(const CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNotSupported;
 }
 
@@ -1948,7 +2192,7 @@ NvCtrlNvmlGetGPUValidAttributeValues(const CtrlTarget *ctrl_target, int attr,
 
     val->permissions.write = NV_FALSE;
 
-    ret = nvml->lib.deviceGetHandleByIndex(nvml->deviceIdx, &device);
+    ret = getNvmlDevice(nvml, h->nvml_device_idx, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_TOTAL_DEDICATED_GPU_MEMORY:
@@ -2052,7 +2296,7 @@ NvCtrlNvmlGetGPUValidAttributeValues(const CtrlTarget *ctrl_target, int attr,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNoAttribute;
 }
 
@@ -2080,7 +2324,7 @@ NvCtrlNvmlGetThermalValidAttributeValues(const CtrlTarget *ctrl_target,
     }
 
 
-    ret = nvml->lib.deviceGetHandleByIndex(deviceId, &device);
+    ret = getNvmlDevice(nvml, deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_SENSOR_READING:
@@ -2103,7 +2347,7 @@ NvCtrlNvmlGetThermalValidAttributeValues(const CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNoAttribute;
 }
 
@@ -2132,7 +2376,7 @@ NvCtrlNvmlGetCoolerValidAttributeValues(const CtrlTarget *ctrl_target,
     }
 
 
-    ret = nvml->lib.deviceGetHandleByIndex(deviceId, &device);
+    ret = getNvmlDevice(nvml, deviceId, &device);
     if (ret == NVML_SUCCESS) {
         switch (attr) {
             case NV_CTRL_THERMAL_COOLER_CURRENT_LEVEL:
@@ -2172,7 +2416,7 @@ NvCtrlNvmlGetCoolerValidAttributeValues(const CtrlTarget *ctrl_target,
     }
 
     /* An NVML error occurred */
-    printNvmlError(ret);
+    handleNvmlError(nvml, ret);
     return NvCtrlNoAttribute;
 }
 
@@ -2355,3 +2599,352 @@ NvCtrlNvmlGetAttributePerms(const NvCtrlAttributePrivateHandle *h,
 
 }
 
+
+
+
+/*
+ * NVML event source
+ *
+ * NVML has no file descriptor to poll for events: nvmlEventSetWait() blocks
+ * until an event is recorded or a timeout expires.  On systems without an X
+ * server, events are therefore waited for by a helper thread, which queues
+ * them and writes a byte to a pipe for each one; the read end of the pipe is
+ * what event loops poll.  The queued events are translated into CtrlEvents
+ * by the thread that dequeues them, so that the NVML queries this involves
+ * are not made concurrently with the main thread's.
+ */
+
+#define NVML_EVENT_WAIT_TIMEOUT_MS 500
+
+#define NVML_EVENT_TYPES (nvmlEventTypeSingleBitEccError | \
+                          nvmlEventTypeDoubleBitEccError | \
+                          nvmlEventTypeClock             | \
+                          nvmlEventTypePowerSourceChange)
+
+typedef struct __NvCtrlNvmlEventNode {
+    unsigned int nvml_device_idx;
+    unsigned long long type;
+    struct __NvCtrlNvmlEventNode *next;
+} NvCtrlNvmlEventNode;
+
+struct __NvCtrlNvmlEventSource {
+    NvCtrlNvmlAttributes *nvml;
+    nvmlEventSet_t set;
+    nvmlDevice_t *devices;   /* registered devices, indexed by NVML index */
+
+    pthread_t thread;
+    pthread_mutex_t lock;    /* protects the fields below */
+    Bool stop;
+    NvCtrlNvmlEventNode *head;
+    NvCtrlNvmlEventNode *tail;
+
+    int fds[2];              /* pipe; one byte per queued event */
+};
+
+
+
+/*
+ * Waits for NVML events until asked to stop, queueing each of them.
+ */
+
+static void *NvmlEventThread(void *arg)
+{
+    NvCtrlNvmlEventSource *src = arg;
+    const NvCtrlNvmlAttributes *nvml = src->nvml;
+
+    while (True) {
+        nvmlEventData_t data;
+        NvCtrlNvmlEventNode *node;
+        nvmlReturn_t ret;
+        unsigned int i;
+        Bool stop;
+        char c = 0;
+
+        pthread_mutex_lock(&src->lock);
+        stop = src->stop;
+        pthread_mutex_unlock(&src->lock);
+
+        if (stop) {
+            break;
+        }
+
+        ret = nvml->lib.eventSetWait_v2(src->set, &data,
+                                        NVML_EVENT_WAIT_TIMEOUT_MS);
+        if (ret == NVML_ERROR_TIMEOUT) {
+            continue;
+        }
+        if (ret != NVML_SUCCESS) {
+            /* Typically a GPU fell off the bus; there is nothing to wait for */
+            break;
+        }
+
+        for (i = 0; i < nvml->deviceCount; i++) {
+            if ((src->devices[i] != NULL) && (src->devices[i] == data.device)) {
+                break;
+            }
+        }
+        if (i == nvml->deviceCount) {
+            continue;
+        }
+
+        node = nvalloc(sizeof(*node));
+        node->nvml_device_idx = i;
+        node->type = data.eventType;
+
+        pthread_mutex_lock(&src->lock);
+        if (src->tail) {
+            src->tail->next = node;
+        } else {
+            src->head = node;
+        }
+        src->tail = node;
+        pthread_mutex_unlock(&src->lock);
+
+        if (write(src->fds[1], &c, 1) < 0) {
+            /* The queue, not the pipe, is what tells if an event is pending */
+        }
+    }
+
+    return NULL;
+}
+
+
+
+/*
+ * Creates an NVML event source recording events on all the GPUs of 'nvml'
+ * and starts waiting for them.  Returns NULL if NVML does not support
+ * events on any of them.
+ */
+
+NvCtrlNvmlEventSource *NvCtrlNvmlCreateEventSource(NvCtrlNvmlAttributes *nvml)
+{
+    NvCtrlNvmlEventSource *src;
+    Bool registered = False;
+    unsigned int i;
+
+    if ((nvml == NULL) || (nvml->lib.handle == NULL)) {
+        return NULL;
+    }
+
+    src = nvalloc(sizeof(*src));
+    src->nvml = nvml;
+    src->fds[0] = src->fds[1] = -1;
+
+    if (nvml->lib.eventSetCreate(&src->set) != NVML_SUCCESS) {
+        nvfree(src);
+        return NULL;
+    }
+
+    src->devices = nvalloc(nvml->deviceCount * sizeof(nvmlDevice_t));
+
+    for (i = 0; i < nvml->deviceCount; i++) {
+        unsigned long long types;
+        nvmlDevice_t device;
+
+        if ((getNvmlDevice(nvml, i, &device) != NVML_SUCCESS) ||
+            (nvml->lib.deviceGetSupportedEventTypes(device, &types) !=
+             NVML_SUCCESS)) {
+            continue;
+        }
+
+        types &= NVML_EVENT_TYPES;
+
+        if ((types != 0) &&
+            (nvml->lib.deviceRegisterEvents(device, types, src->set) ==
+             NVML_SUCCESS)) {
+            src->devices[i] = device;
+            registered = True;
+        }
+    }
+
+    if (!registered || (pipe(src->fds) != 0)) {
+        goto fail;
+    }
+
+    fcntl(src->fds[0], F_SETFL, fcntl(src->fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(src->fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(src->fds[1], F_SETFD, FD_CLOEXEC);
+
+    pthread_mutex_init(&src->lock, NULL);
+
+    if (pthread_create(&src->thread, NULL, NvmlEventThread, src) != 0) {
+        pthread_mutex_destroy(&src->lock);
+        goto fail;
+    }
+
+    /* Keep NVML loaded for as long as the thread may use it */
+    RetainNvmlAttributes(nvml);
+
+    return src;
+
+ fail:
+    if (src->fds[0] != -1) {
+        close(src->fds[0]);
+        close(src->fds[1]);
+    }
+    nvml->lib.eventSetFree(src->set);
+    nvfree(src->devices);
+    nvfree(src);
+
+    return NULL;
+}
+
+
+
+/*
+ * Stops the event thread and frees the event source, along with the events
+ * that were not dequeued.
+ */
+
+void NvCtrlNvmlDestroyEventSource(NvCtrlNvmlEventSource *src)
+{
+    NvCtrlNvmlEventNode *node;
+
+    if (src == NULL) {
+        return;
+    }
+
+    /* The thread notices within NVML_EVENT_WAIT_TIMEOUT_MS */
+    pthread_mutex_lock(&src->lock);
+    src->stop = True;
+    pthread_mutex_unlock(&src->lock);
+
+    pthread_join(src->thread, NULL);
+    pthread_mutex_destroy(&src->lock);
+
+    while (src->head) {
+        node = src->head;
+        src->head = node->next;
+        nvfree(node);
+    }
+
+    close(src->fds[0]);
+    close(src->fds[1]);
+
+    src->nvml->lib.eventSetFree(src->set);
+    ReleaseNvmlAttributes(src->nvml);
+
+    nvfree(src->devices);
+    nvfree(src);
+}
+
+
+
+int NvCtrlNvmlEventSourceGetFD(NvCtrlNvmlEventSource *src)
+{
+    return src->fds[0];
+}
+
+
+
+Bool NvCtrlNvmlEventSourcePending(NvCtrlNvmlEventSource *src)
+{
+    Bool pending;
+
+    pthread_mutex_lock(&src->lock);
+    pending = (src->head != NULL);
+    pthread_mutex_unlock(&src->lock);
+
+    return pending;
+}
+
+
+
+/*
+ * Dequeues the next NVML event and translates it into the attribute change
+ * it reports.  The event is left as CTRL_EVENT_TYPE_UNKNOWN if no event was
+ * pending or it does not map to any attribute.
+ */
+
+ReturnStatus NvCtrlNvmlEventSourceNextEvent(NvCtrlNvmlEventSource *src,
+                                            CtrlEvent *event)
+{
+    const NvCtrlNvmlAttributes *nvml = src->nvml;
+    NvCtrlNvmlEventNode *node;
+    nvmlDevice_t device = NULL;
+    unsigned int i;
+    char c;
+
+    memset(event, 0, sizeof(CtrlEvent));
+
+    pthread_mutex_lock(&src->lock);
+    node = src->head;
+    if (node) {
+        src->head = node->next;
+        if (src->head == NULL) {
+            src->tail = NULL;
+        }
+    }
+    pthread_mutex_unlock(&src->lock);
+
+    if (node == NULL) {
+        return NvCtrlSuccess;
+    }
+
+    if (read(src->fds[0], &c, 1) < 0) {
+        /* Nothing to drain if the byte was lost */
+    }
+
+    /* Report the event on the GPU target with the matching NV-CONTROL ID */
+    event->target_type = GPU_TARGET;
+    event->target_id = node->nvml_device_idx;
+    for (i = 0; i < nvml->deviceCount; i++) {
+        if (nvml->nvctrlToNvmlId[i] == node->nvml_device_idx) {
+            event->target_id = i;
+            break;
+        }
+    }
+
+    if (getNvmlDevice(nvml, node->nvml_device_idx, &device) != NVML_SUCCESS) {
+        device = NULL;
+    }
+
+    switch (node->type) {
+        case nvmlEventTypeSingleBitEccError:
+        case nvmlEventTypeDoubleBitEccError:
+            {
+                unsigned long long count = 0;
+                Bool single = (node->type == nvmlEventTypeSingleBitEccError);
+
+                if (device) {
+                    nvml->lib.deviceGetTotalEccErrors(device,
+                        single ? NVML_MEMORY_ERROR_TYPE_CORRECTED :
+                                 NVML_MEMORY_ERROR_TYPE_UNCORRECTED,
+                        NVML_VOLATILE_ECC, &count);
+                }
+
+                event->type = CTRL_EVENT_TYPE_INTEGER_ATTRIBUTE;
+                event->int_attr.attribute =
+                    single ? NV_CTRL_GPU_ECC_SINGLE_BIT_ERRORS :
+                             NV_CTRL_GPU_ECC_DOUBLE_BIT_ERRORS;
+                event->int_attr.value = count;
+            }
+            break;
+
+        case nvmlEventTypeClock:
+            event->type = CTRL_EVENT_TYPE_STRING_ATTRIBUTE;
+            event->str_attr.attribute = NV_CTRL_STRING_GPU_CURRENT_CLOCK_FREQS;
+            break;
+
+        case nvmlEventTypePowerSourceChange:
+            {
+                nvmlPowerSource_t source;
+
+                if (device &&
+                    (nvml->lib.deviceGetPowerSource(device, &source) ==
+                     NVML_SUCCESS)) {
+                    event->type = CTRL_EVENT_TYPE_INTEGER_ATTRIBUTE;
+                    event->int_attr.attribute = NV_CTRL_GPU_POWER_SOURCE;
+                    event->int_attr.value = source;
+                }
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    nvfree(node);
+
+    return NvCtrlSuccess;
+}
@@ -119,6 +119,9 @@ typedef struct __NvCtrlXrandrAttributes NvCtrlXrandrAttributes;
 typedef struct __NvCtrlNvmlAttributes NvCtrlNvmlAttributes;
 typedef struct __NvCtrlEventPrivateHandle NvCtrlEventPrivateHandle;
 typedef struct __NvCtrlEventPrivateHandleNode NvCtrlEventPrivateHandleNode;
+typedef struct __NvCtrlNvmlEventSource NvCtrlNvmlEventSource;
+typedef struct __NvCtrlAttributeCache NvCtrlAttributeCache;
+typedef struct __NvCtrlAttributePermsCache NvCtrlAttributePermsCache;
 
 typedef struct {
     float brightness[3];
@@ -158,6 +161,8 @@ struct __NvCtrlXrandrAttributes {
     RRCrtc gammaCrtc;
     NvCtrlGammaInput gammaInput;
     XRRCrtcGamma *pGammaRamp;
+    Bool gammaPending;          /* pGammaRamp not yet sent to the server */
+    uint64_t gammaSentTime;     /* when pGammaRamp was last sent, in ms */
 };
 
 struct __NvCtrlNvmlAttributes {
@@ -203,10 +208,17 @@ struct __NvCtrlNvmlAttributes {
         typeof(nvmlDeviceSetFanControlPolicy)           (*deviceSetFanControlPolicy);
         typeof(nvmlDeviceGetFanControlPolicy_v2)        (*deviceGetFanControlPolicy_v2);
         typeof(nvmlDeviceSetDefaultFanSpeed_v2)         (*deviceSetDefaultFanSpeed_v2);
+        typeof(nvmlEventSetCreate)                      (*eventSetCreate);
+        typeof(nvmlEventSetWait_v2)                     (*eventSetWait_v2);
+        typeof(nvmlEventSetFree)                        (*eventSetFree);
+        typeof(nvmlDeviceRegisterEvents)                (*deviceRegisterEvents);
+        typeof(nvmlDeviceGetSupportedEventTypes)        (*deviceGetSupportedEventTypes);
 
     } lib;
 
-    unsigned int deviceIdx; /* XXX Needed while using NV-CONTROL as fallback */
+    int refcount;           /* CtrlSystem + each NVML target using it */
+    nvmlDevice_t *devices;  /* device handles, indexed by NVML index */
+    unsigned int *nvctrlToNvmlId; /* XXX Needed while using NV-CONTROL as fallback */
     unsigned int deviceCount;
     unsigned int sensorCount;
     unsigned int *sensorCountPerGPU;
@@ -231,10 +243,14 @@ struct __NvCtrlAttributePrivateHandle {
     NvCtrlXrandrAttributes *xrandr; /* XRandR extension info */
 
     /* NVML-specific attributes */
-    NvCtrlNvmlAttributes *nvml;
+    NvCtrlNvmlAttributes *nvml;     /* shared by all targets of the system */
+    unsigned int nvml_device_idx;   /* NVML index of the target's device */
 
     /* Wayland display ptr */
     void *wayland_dpy;
+
+    /* Attribute values cache, if enabled */
+    NvCtrlAttributeCache *cache;
 };
 
 struct __NvCtrlEventPrivateHandle {
@@ -242,6 +258,10 @@ struct __NvCtrlEventPrivateHandle {
     int fd;                /* file descriptor to poll for new events */
     int nvctrl_event_base; /* NV-CONTROL base for indexing & identifying evts */
     int xrandr_event_base; /* RandR base for indexing & identifying evts */
+
+    /* NVML-only systems, where dpy is NULL */
+    NvCtrlNvmlAttributes *nvml;          /* NVML instance events come from */
+    NvCtrlNvmlEventSource *nvml_events;  /* NVML event thread and queue */
 };
 
 struct __NvCtrlEventPrivateHandleNode {
@@ -350,6 +370,16 @@ ReturnStatus NvCtrlXrandrSetColorAttributes(NvCtrlAttributePrivateHandle *h,
                                             float g[3],
                                             unsigned int bitmask);
 
+ReturnStatus NvCtrlXrandrQueueColorAttributes(NvCtrlAttributePrivateHandle *h,
+                                              float c[3],
+                                              float b[3],
+                                              float g[3],
+                                              unsigned int bitmask,
+                                              Bool *sent);
+
+ReturnStatus NvCtrlXrandrFlushColorAttributes(NvCtrlAttributePrivateHandle *h,
+                                              Bool *sent);
+
 ReturnStatus NvCtrlXrandrGetColorRamp(const NvCtrlAttributePrivateHandle *h,
                                       unsigned int channel,
                                       uint16_t **lut,
@@ -392,6 +422,8 @@ NvCtrlAttributeHandle *NvCtrlAttributeInit(CtrlSystem *system,
                                            int target_id,
                                            unsigned int subsystems);
 
+void NvCtrlFreeAttributePermsCache(CtrlSystem *system);
+
 ReturnStatus
 NvCtrlNvControlQueryTargetCount(const NvCtrlAttributePrivateHandle *, int,
                                 int *);
@@ -399,10 +431,15 @@ NvCtrlNvControlQueryTargetCount(const NvCtrlAttributePrivateHandle *, int,
 ReturnStatus NvCtrlNvControlGetAttribute(const NvCtrlAttributePrivateHandle *,
                                          unsigned int, int, int64_t *);
 
+void NvCtrlNvControlGetAttributesBatch(Display *, CtrlAttributeQuery **, int);
+
 ReturnStatus
 NvCtrlNvControlSetAttribute (NvCtrlAttributePrivateHandle *, unsigned int,
                              int, int);
 
+void NvCtrlNvControlSetAttributesBatch(Display *, CtrlAttributeAssignment **,
+                                       int);
+
 ReturnStatus
 NvCtrlNvControlSetAttributeWithReply (NvCtrlAttributePrivateHandle *,
                                       unsigned int, int, int);
@@ -412,11 +449,19 @@ NvCtrlNvControlGetAttributePerms(const NvCtrlAttributePrivateHandle *,
                                  CtrlAttributeType, int,
                                  CtrlAttributePerms *);
 
+void NvCtrlNvControlGetAttributesPermsBatch(Display *, const int *,
+                                            CtrlAttributePerms *,
+                                            ReturnStatus *, int);
+
 ReturnStatus
 NvCtrlNvControlGetValidAttributeValues(const NvCtrlAttributePrivateHandle *,
                                        unsigned int, int,
                                        CtrlAttributeValidValues *);
 
+void NvCtrlNvControlGetValidAttributeValuesBatch(Display *,
+                                                 CtrlAttributeValidValuesQuery **,
+                                                 int);
+
 ReturnStatus
 NvCtrlNvControlGetValidStringDisplayAttributeValues
                                       (const NvCtrlAttributePrivateHandle *,
@@ -458,8 +503,18 @@ void NvCtrlAssignGammaInput(NvCtrlGammaInput *pGammaInput,
 
 /* NVML backend functions */
 
-NvCtrlNvmlAttributes *NvCtrlInitNvmlAttributes(NvCtrlAttributePrivateHandle *);
+NvCtrlNvmlAttributes *NvCtrlInitNvmlAttributes(CtrlSystem *,
+                                               NvCtrlAttributePrivateHandle *);
 void                  NvCtrlNvmlAttributesClose(NvCtrlAttributePrivateHandle *);
+void                  NvCtrlNvmlSystemClose(CtrlSystem *);
+void                  NvCtrlNvmlInvalidateDevices(NvCtrlNvmlAttributes *);
+
+NvCtrlNvmlEventSource *NvCtrlNvmlCreateEventSource(NvCtrlNvmlAttributes *);
+void                   NvCtrlNvmlDestroyEventSource(NvCtrlNvmlEventSource *);
+int                    NvCtrlNvmlEventSourceGetFD(NvCtrlNvmlEventSource *);
+Bool                   NvCtrlNvmlEventSourcePending(NvCtrlNvmlEventSource *);
+ReturnStatus           NvCtrlNvmlEventSourceNextEvent(NvCtrlNvmlEventSource *,
+                                                      CtrlEvent *);
 
 ReturnStatus NvCtrlNvmlQueryTargetCount(const CtrlTarget *ctrl_target,
                                         int target_type, int *val);
@@ -26,6 +26,8 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <pthread.h>
 
 #include <X11/Xlib.h>
 
@@ -92,6 +94,122 @@ static void nv_free_ctrl_target(CtrlTarget *target)
 
 
 
+/*
+ * Targets are looked up by target type and id, and by name, for each
+ * attribute processed on the command line or read from the configuration
+ * file; with hundreds of display devices, walking the target lists for
+ * each lookup does not scale.  Each CtrlSystem therefore also indexes its
+ * targets by id, per target type, and by proto name, in a hash table.
+ */
+
+#define TARGET_NAME_HASH_BUCKETS 1024
+
+struct _CtrlTargetNameEntry {
+    const char *name;   /* one of the target's protoNames */
+    CtrlTarget *t;
+    CtrlTargetNameEntry *next;
+};
+
+static unsigned int target_name_hash(const char *name)
+{
+    unsigned int hash = 5381;
+
+    /* Proto names are matched case-insensitively */
+    while (*name) {
+        hash = (hash * 33) + tolower((unsigned char) *name);
+        name++;
+    }
+
+    return hash % TARGET_NAME_HASH_BUCKETS;
+}
+
+
+
+static void index_target(CtrlSystem *system, CtrlTarget *target)
+{
+    CtrlTargetType target_type = NvCtrlGetTargetType(target);
+    int target_id = NvCtrlGetTargetId(target);
+    int i;
+
+    system->target_count[target_type]++;
+
+    /* Index by id; the first target with a given id wins */
+
+    if (target_id >= 0) {
+        int len = system->targets_by_id_len[target_type];
+
+        if (target_id >= len) {
+            int new_len = NV_MAX(target_id + 1, 2 * len);
+
+            system->targets_by_id[target_type] =
+                nvrealloc(system->targets_by_id[target_type],
+                          new_len * sizeof(CtrlTarget *));
+            memset(system->targets_by_id[target_type] + len, 0,
+                   (new_len - len) * sizeof(CtrlTarget *));
+            system->targets_by_id_len[target_type] = new_len;
+        }
+
+        if (!system->targets_by_id[target_type][target_id]) {
+            system->targets_by_id[target_type][target_id] = target;
+        }
+    }
+
+    /* Index by name, appending to keep the order targets were added in */
+
+    if (!system->targets_by_name) {
+        system->targets_by_name =
+            nvalloc(TARGET_NAME_HASH_BUCKETS * sizeof(CtrlTargetNameEntry *));
+    }
+
+    for (i = 0; i < NV_PROTO_NAME_MAX; i++) {
+        CtrlTargetNameEntry **pentry;
+        CtrlTargetNameEntry *entry;
+
+        if (!target->protoNames[i]) {
+            continue;
+        }
+
+        pentry = &system->targets_by_name[
+                     target_name_hash(target->protoNames[i])];
+        while (*pentry) {
+            pentry = &(*pentry)->next;
+        }
+
+        entry = nvalloc(sizeof(*entry));
+        entry->name = target->protoNames[i];
+        entry->t = target;
+        *pentry = entry;
+    }
+}
+
+
+
+static void free_target_indices(CtrlSystem *system)
+{
+    int i;
+
+    for (i = 0; i < MAX_TARGET_TYPES; i++) {
+        nvfree(system->targets_by_id[i]);
+        system->targets_by_id[i] = NULL;
+        system->targets_by_id_len[i] = 0;
+        system->target_count[i] = 0;
+    }
+
+    if (system->targets_by_name) {
+        for (i = 0; i < TARGET_NAME_HASH_BUCKETS; i++) {
+            while (system->targets_by_name[i]) {
+                CtrlTargetNameEntry *entry = system->targets_by_name[i];
+                system->targets_by_name[i] = entry->next;
+                nvfree(entry);
+            }
+        }
+        nvfree(system->targets_by_name);
+        system->targets_by_name = NULL;
+    }
+}
+
+
+
 static void nv_free_ctrl_system(CtrlSystem *system)
 {
     int target_type;
@@ -117,6 +235,8 @@ static void nv_free_ctrl_system(CtrlSystem *system)
 
     /* cleanup targets */
 
+    free_target_indices(system);
+
     for (target_type = 0;
          target_type < MAX_TARGET_TYPES;
          target_type++) {
@@ -141,8 +261,14 @@ static void nv_free_ctrl_system(CtrlSystem *system)
         nvfree(node);
     }
 
+    /* release the NVML library once no target uses it anymore */
+
+    NvCtrlNvmlSystemClose(system);
+
     /* cleanup everything else */
 
+    NvCtrlFreeAttributePermsCache(system);
+
     free(system->display);
     system->display = NULL;
 
@@ -269,18 +395,11 @@ static void load_target_proto_names(CtrlTarget *t)
 
 int NvCtrlGetTargetTypeCount(const CtrlSystem *system, CtrlTargetType target_type)
 {
-    int count = 0;
-    CtrlTargetNode *node;
-
     if (!system || !NvCtrlIsTargetTypeValid(target_type)) {
         return 0;
     }
 
-    for (node = system->targets[target_type]; node; node = node->next) {
-        count++;
-    }
-
-    return count;
+    return system->target_count[target_type];
 }
 
 
@@ -301,22 +420,50 @@ CtrlTarget *NvCtrlGetTarget(const CtrlSystem *system,
                             CtrlTargetType target_type,
                             int target_id)
 {
-    CtrlTargetNode *node;
-
     if (!system || !NvCtrlIsTargetTypeValid(target_type)) {
         return NULL;
     }
 
-    for (node = system->targets[target_type];
-         node;
-         node = node->next) {
-        CtrlTarget *target = node->t;
-        if (NvCtrlGetTargetId(target) == target_id) {
-            return target;
+    if ((target_id < 0) ||
+        (target_id >= system->targets_by_id_len[target_type])) {
+        return NULL;
+    }
+
+    return system->targets_by_id[target_type][target_id];
+}
+
+
+
+/*!
+ * Returns the list of the CtrlTargets from a CtrlSystem that have the given
+ * (case-insensitive) proto name, in the order they were added to the system.
+ *
+ * \param[in]  system  Container for all the CtrlTargets to search.
+ * \param[in]  name    The name to match against.
+ *
+ * \return  Returns a list of the matching CtrlTargets, or NULL if none
+ *          match; the list should be freed with NvCtrlTargetListFree().
+ */
+
+CtrlTargetNode *NvCtrlGetTargetsByName(const CtrlSystem *system,
+                                       const char *name)
+{
+    CtrlTargetNameEntry *entry;
+    CtrlTargetNode *head = NULL;
+
+    if (!system || !name || !system->targets_by_name) {
+        return NULL;
+    }
+
+    for (entry = system->targets_by_name[target_name_hash(name)];
+         entry;
+         entry = entry->next) {
+        if (nv_strcasecmp(entry->name, name)) {
+            NvCtrlTargetListAdd(&head, entry->t, FALSE);
         }
     }
 
-    return NULL;
+    return head;
 }
 
 
@@ -786,11 +933,111 @@ CtrlTarget *nv_add_target(CtrlSystem *system, CtrlTargetType target_type,
     }
 
     NvCtrlTargetListAdd(&(system->targets[target_type]), target, FALSE);
+    index_target(system, target);
 
     return target;
 }
 
 
+/*
+ * On systems without an X server, GPU, cooler and thermal sensor targets
+ * only talk to NVML, which is thread-safe, and initializing them mostly
+ * consists of waiting for NVML; they are therefore initialized by a few
+ * threads at once, and then added to the system in order by the calling
+ * thread.
+ */
+
+#define MAX_TARGET_INIT_THREADS 8
+
+typedef struct {
+    CtrlSystem *system;
+    CtrlTargetType target_type;
+    CtrlTarget **targets;   /* indexed by target id */
+    int count;
+    int next;               /* next target id to initialize */
+    pthread_mutex_t lock;
+} TargetInitQueue;
+
+static void *init_targets_thread(void *arg)
+{
+    TargetInitQueue *q = arg;
+
+    while (1) {
+        int i;
+
+        pthread_mutex_lock(&q->lock);
+        i = q->next++;
+        pthread_mutex_unlock(&q->lock);
+
+        if (i >= q->count) {
+            break;
+        }
+
+        /* libEGL's bookkeeping is not thread-safe; see below */
+        q->targets[i] =
+            nv_alloc_ctrl_target(q->system, q->target_type, i,
+                                 NV_CTRL_ATTRIBUTES_ALL_SUBSYSTEMS &
+                                 ~NV_CTRL_ATTRIBUTES_EGL_SUBSYSTEM);
+    }
+
+    return NULL;
+}
+
+
+
+static void nv_add_nvml_targets(CtrlSystem *system,
+                                CtrlTargetType target_type,
+                                int target_count)
+{
+    TargetInitQueue q;
+    pthread_t threads[MAX_TARGET_INIT_THREADS - 1];
+    int num_threads = 0;
+    int i;
+
+    q.system = system;
+    q.target_type = target_type;
+    q.targets = nvalloc(target_count * sizeof(CtrlTarget *));
+    q.count = target_count;
+    q.next = 0;
+    pthread_mutex_init(&q.lock, NULL);
+
+    /* The calling thread does its share of the work as well */
+
+    for (i = 1; i < NV_MIN(target_count, MAX_TARGET_INIT_THREADS); i++) {
+        if (pthread_create(&threads[num_threads], NULL,
+                           init_targets_thread, &q) != 0) {
+            break;
+        }
+        num_threads++;
+    }
+
+    init_targets_thread(&q);
+
+    for (i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&q.lock);
+
+    for (i = 0; i < target_count; i++) {
+        CtrlTarget *target = q.targets[i];
+
+        if (!target) {
+            continue;
+        }
+
+        if (target_type == GPU_TARGET) {
+            NvCtrlRebuildSubsystems(target, NV_CTRL_ATTRIBUTES_EGL_SUBSYSTEM);
+        }
+
+        NvCtrlTargetListAdd(&(system->targets[target_type]), target, FALSE);
+        index_target(system, target);
+    }
+
+    nvfree(q.targets);
+}
+
+
 /*
  * Returns whether the NV-CONTROL protocol version is equal or greater than
  * 'major'.'minor'
@@ -975,6 +1222,14 @@ static Bool load_system_info(CtrlSystem *system, const char *display)
 
         /* Add all the targets of this type to the CtrlSystem */
 
+        if (!system->dpy && (target_count > 1) &&
+            ((target_type == GPU_TARGET) ||
+             (target_type == COOLER_TARGET) ||
+             (target_type == THERMAL_SENSOR_TARGET))) {
+            nv_add_nvml_targets(system, target_type, target_count);
+            continue;
+        }
+
         for (i = 0; i < target_count; i++) {
             int targetId;
             CtrlTarget *target;
@@ -26,6 +26,7 @@
 #include <stdlib.h> /* 64 bit malloc */
 #include <assert.h>
 #include <string.h>
+#include <time.h>
 
 #include <dlfcn.h> /* To dynamically load libXrandr.so.2 */
 #include <X11/Xlib.h>
@@ -455,11 +456,24 @@ ReturnStatus NvCtrlXrandrGetColorAttributes(const NvCtrlAttributePrivateHandle *
 
 }
 
-ReturnStatus NvCtrlXrandrSetColorAttributes(NvCtrlAttributePrivateHandle *h,
-                                            float c[3],
-                                            float b[3],
-                                            float g[3],
-                                            unsigned int bitmask)
+static uint64_t GetTimeMs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * UpdateGammaRamp() - apply the given color attributes to the gamma
+ * input and recompute the gamma ramp, without sending it to the server.
+ */
+
+static ReturnStatus UpdateGammaRamp(NvCtrlAttributePrivateHandle *h,
+                                    float c[3],
+                                    float b[3],
+                                    float g[3],
+                                    unsigned int bitmask)
 {
     unsigned short *tmpGammaArray[3];
 
@@ -490,11 +504,92 @@ ReturnStatus NvCtrlXrandrSetColorAttributes(NvCtrlAttributePrivateHandle *h,
                           tmpGammaArray,
                           bitmask);
 
+    return NvCtrlSuccess;
+}
+
+static void SendGammaRamp(NvCtrlAttributePrivateHandle *h)
+{
     __libXrandr->XRRSetCrtcGamma(h->dpy, h->xrandr->gammaCrtc,
                                  h->xrandr->pGammaRamp);
 
     XFlush(h->dpy);
 
+    h->xrandr->gammaPending = False;
+    h->xrandr->gammaSentTime = GetTimeMs();
+}
+
+ReturnStatus NvCtrlXrandrSetColorAttributes(NvCtrlAttributePrivateHandle *h,
+                                            float c[3],
+                                            float b[3],
+                                            float g[3],
+                                            unsigned int bitmask)
+{
+    ReturnStatus status;
+
+    status = UpdateGammaRamp(h, c, b, g, bitmask);
+    if (status != NvCtrlSuccess) {
+        return status;
+    }
+
+    SendGammaRamp(h);
+
+    return NvCtrlSuccess;
+}
+
+/*
+ * NvCtrlXrandrQueueColorAttributes() - like
+ * NvCtrlXrandrSetColorAttributes(), but if a ramp was sent less than
+ * NV_CTRL_COLOR_UPDATE_INTERVAL ms ago, the new ramp is only marked
+ * pending; since the ramp is always computed from the accumulated gamma
+ * input, a later flush sends the most recent values.
+ */
+
+ReturnStatus NvCtrlXrandrQueueColorAttributes(NvCtrlAttributePrivateHandle *h,
+                                              float c[3],
+                                              float b[3],
+                                              float g[3],
+                                              unsigned int bitmask,
+                                              Bool *sent)
+{
+    ReturnStatus status;
+
+    *sent = False;
+
+    status = UpdateGammaRamp(h, c, b, g, bitmask);
+    if (status != NvCtrlSuccess) {
+        return status;
+    }
+
+    if (GetTimeMs() - h->xrandr->gammaSentTime <
+        NV_CTRL_COLOR_UPDATE_INTERVAL) {
+        h->xrandr->gammaPending = True;
+        return NvCtrlSuccess;
+    }
+
+    SendGammaRamp(h);
+    *sent = True;
+
+    return NvCtrlSuccess;
+}
+
+ReturnStatus NvCtrlXrandrFlushColorAttributes(NvCtrlAttributePrivateHandle *h,
+                                              Bool *sent)
+{
+    *sent = False;
+
+    if (!h || !h->dpy) {
+        return NvCtrlBadHandle;
+    }
+
+    if (!h->xrandr) {
+        return NvCtrlMissingExtension;
+    }
+
+    if (h->xrandr->gammaPending) {
+        SendGammaRamp(h);
+        *sent = True;
+    }
+
     return NvCtrlSuccess;
 }
 
@@ -547,6 +642,7 @@ ReturnStatus NvCtrlXrandrReloadColorRamp(NvCtrlAttributePrivateHandle *h)
         h->xrandr->pGammaRamp =
             __libXrandr->XRRGetCrtcGamma(h->dpy, h->xrandr->gammaCrtc);
         NvCtrlInitGammaInputStruct(&h->xrandr->gammaInput);
+        h->xrandr->gammaPending = False;
     } else {
         return NvCtrlError;
     }
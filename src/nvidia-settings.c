@@ -367,13 +367,20 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    /* Allocate handle for ctrl_display */
+    /*
+     * Allocate handle for ctrl_display, unless queries and assignments are
+     * to be fanned out to several displays: each of them is then connected
+     * to by its own worker.
+     */
 
-    NvCtrlConnectToSystem(op->ctrl_display, &systems);
+    if ((op->num_ctrl_displays <= 1) ||
+        !(op->num_assignments || op->num_queries)) {
+        NvCtrlConnectToSystem(op->ctrl_display, &systems);
+    }
 
     /* process any query or assignment commandline options */
 
-    if (op->num_assignments || op->num_queries) {
+    if (op->num_assignments || op->num_queries || op->num_monitors) {
         ret = nv_process_assignments_and_queries(op, &systems);
         NvCtrlFreeAllSystems(&systems);
         return ret ? 0 : 1;
@@ -416,11 +423,12 @@ int main(int argc, char **argv)
     }
 
     /*
-     * if the user requested that we only load the config file, or that
-     * we only list the resolved targets, then exit now.
+     * if the user requested that we only load the config file, that we
+     * only list the resolved targets, or only print the assignments of
+     * the config file, then exit now.
      */
 
-    if (op->only_load || op->list_targets) {
+    if (op->only_load || op->list_targets || op->dry_run) {
         return ret ? 0 : 1;
     }
 
@@ -49,7 +49,11 @@ static const NVGetoptOption __options[] = {
       "Control the specified X display.  If this option is not given, then "
       "^nvidia-settings^ will control the display specified by ^'--display'^; "
       "if that is not given, then the &$DISPLAY& environment "
-      "variable is used." },
+      "variable is used.  This option may be given multiple times, in which "
+      "case the queries and assignments given with ^--query^ and "
+      "^--assign^ are processed on all the displays concurrently, and their "
+      "results are printed in the order the displays were given; other "
+      "operations only control the first display." },
 
     /*
      * This is a silent, hidden option for the GTK argument that we treat
@@ -142,6 +146,46 @@ static const NVGetoptOption __options[] = {
       "Devices, respectively, that are present on the X Display {DISPLAY}.  "
       "Specify ^'-q all'^ to query all attributes." },
 
+    { "monitor", MONITOR_OPTION,
+      NVGETOPT_STRING_ARGUMENT | NVGETOPT_HELP_ALWAYS, NULL,
+      "Sample attributes periodically until interrupted.  The &MONITOR& "
+      "argument is a comma separated list of queries, using the same syntax "
+      "as the ^'--query'^ option; only integer and string attributes can be "
+      "monitored.  The control display is connected to once, and every "
+      "sample prints one line per target, with the sample number, the time "
+      "elapsed since the first sample, how late the sample ran compared to "
+      "its schedule (both in milliseconds), the target name and the values "
+      "of its monitored attributes.  For example:\n"
+      "\n"
+      TAB "--monitor=\"[gpu:0]/GPUCoreTemp,[gpu:0]/GPUCurrentPerfLevel\"\n"
+      "\n"
+      "See the ^'--interval'^ and ^'--monitor-format'^ options." },
+
+    { "interval", MONITOR_INTERVAL_OPTION,
+      NVGETOPT_INTEGER_ARGUMENT | NVGETOPT_HELP_ALWAYS, NULL,
+      "Sample the attributes given to ^'--monitor'^ every &INTERVAL& "
+      "milliseconds (1000 by default).  Samples are scheduled on a monotonic "
+      "clock; if a sample runs more than one interval late, the samples "
+      "that were missed are skipped." },
+
+    { "monitor-format", MONITOR_FORMAT_OPTION,
+      NVGETOPT_STRING_ARGUMENT | NVGETOPT_HELP_ALWAYS, NULL,
+      "Print the samples taken by ^'--monitor'^ either as CSV with a header "
+      "line (^'csv'^, the default), or as one JSON object per line "
+      "(^'json'^)." },
+
+    { "match-app-profiles", APP_PROFILE_MATCH_OPTION,
+      NVGETOPT_STRING_ARGUMENT | NVGETOPT_HELP_ALWAYS, "PROCESS",
+      "Print the application profile rules which match the process described "
+      "by &PROCESS&, and the driver settings which they apply, then exit.  "
+      "&PROCESS& is a comma separated list of ^'procname='^, ^'commname='^ "
+      "and ^'dso='^ items, giving the name of the process, its command name "
+      "and the shared objects it loads; e.g.,\n"
+      "\n"
+      TAB "--match-app-profiles=\"procname=foo,dso=libbar.so\"\n"
+      "\n"
+      "Rules using the ^'true'^ feature match any process." },
+
     { "terse", 't', NVGETOPT_HELP_ALWAYS, NULL,
       "When querying attribute values with the '--query' command line option, "
       "only print the current value, rather than the more verbose description "
@@ -193,6 +237,14 @@ static const NVGetoptOption __options[] = {
       "targets on which the query/assign operation would have been performed, "
       "without actually performing the operation(s), and exit." },
 
+    { "dry-run", DRY_RUN_OPTION, NVGETOPT_HELP_ALWAYS, NULL,
+      "Read the configuration file and print the assignments which loading "
+      "it would make, without making them, and exit.  Assignments which are "
+      "overridden by later lines of the file for the same target are left "
+      "out, as they are when the file is loaded.  This option cannot be "
+      "combined with the '--assign', '--query', '--monitor', '--no-config' or "
+      "'--rewrite-config-file' options." },
+
     { "write-config", 'w', NVGETOPT_IS_BOOLEAN | NVGETOPT_HELP_ALWAYS, NULL,
       "Save the configuration file on exit (enabled by default)." },
 
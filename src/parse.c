@@ -365,6 +365,85 @@ const int attributeTableLen = ARRAY_LEN(attributeTable);
 
 
 
+/*
+ * Hash indices into attributeTable[], built on first use: one keyed by
+ * (attr, type) and one keyed by the case-folded attribute name.  Each
+ * slot holds an attributeTable[] index plus one, or 0 if the slot is
+ * empty.  Only the first entry with a given key is indexed, so lookups
+ * return the same entry as a linear scan of the table would.
+ */
+
+static unsigned int *attributeIndexByAttr;
+static unsigned int *attributeIndexByName;
+static unsigned int attributeIndexMask;
+
+static unsigned int hash_attribute(const int attr,
+                                   const CtrlAttributeType type)
+{
+    return ((unsigned int) attr * 2654435761U) ^ (unsigned int) type;
+}
+
+static unsigned int hash_attribute_name(const char *name)
+{
+    unsigned int hash = 2166136261U;
+
+    for (; *name; name++) {
+        hash = (hash ^ (unsigned char) toupper((unsigned char) *name)) *
+            16777619U;
+    }
+
+    return hash;
+}
+
+static void build_attribute_indices(void)
+{
+    unsigned int size = 1;
+    int i;
+
+    /* Keep the tables at most half full */
+
+    while (size < 2 * attributeTableLen) {
+        size <<= 1;
+    }
+
+    attributeIndexMask = size - 1;
+    attributeIndexByAttr = nvalloc(size * sizeof(unsigned int));
+    attributeIndexByName = nvalloc(size * sizeof(unsigned int));
+
+    for (i = 0; i < attributeTableLen; i++) {
+        const AttributeTableEntry *a = attributeTable + i;
+        unsigned int slot;
+
+        for (slot = hash_attribute(a->attr, a->type) & attributeIndexMask;
+             attributeIndexByAttr[slot];
+             slot = (slot + 1) & attributeIndexMask) {
+            const AttributeTableEntry *t =
+                attributeTable + attributeIndexByAttr[slot] - 1;
+            if ((t->attr == a->attr) && (t->type == a->type)) {
+                break;
+            }
+        }
+        if (!attributeIndexByAttr[slot]) {
+            attributeIndexByAttr[slot] = i + 1;
+        }
+
+        for (slot = hash_attribute_name(a->name) & attributeIndexMask;
+             attributeIndexByName[slot];
+             slot = (slot + 1) & attributeIndexMask) {
+            const AttributeTableEntry *t =
+                attributeTable + attributeIndexByName[slot] - 1;
+            if (nv_strcasecmp(a->name, t->name)) {
+                break;
+            }
+        }
+        if (!attributeIndexByName[slot]) {
+            attributeIndexByName[slot] = i + 1;
+        }
+    }
+}
+
+
+
 /*
  * returns the corresponding attribute entry for the given attribute constant.
  *
@@ -372,10 +451,17 @@ const int attributeTableLen = ARRAY_LEN(attributeTable);
 const AttributeTableEntry *nv_get_attribute_entry(const int attr,
                                                   const CtrlAttributeType type)
 {
-    int i;
+    unsigned int slot;
 
-    for (i = 0; i < attributeTableLen; i++) {
-        const AttributeTableEntry *a = attributeTable + i;
+    if (!attributeIndexByAttr) {
+        build_attribute_indices();
+    }
+
+    for (slot = hash_attribute(attr, type) & attributeIndexMask;
+         attributeIndexByAttr[slot];
+         slot = (slot + 1) & attributeIndexMask) {
+        const AttributeTableEntry *a =
+            attributeTable + attributeIndexByAttr[slot] - 1;
         if ((a->attr == attr) && (a->type == type)) {
             return a;
         }
@@ -392,10 +478,21 @@ const AttributeTableEntry *nv_get_attribute_entry(const int attr,
  */
 static const AttributeTableEntry *nv_get_attribute_entry_by_name(const char *name)
 {
-    int i;
+    unsigned int slot;
 
-    for (i = 0; i < attributeTableLen; i++) {
-        const AttributeTableEntry *t = attributeTable + i;
+    if (!name) {
+        return NULL;
+    }
+
+    if (!attributeIndexByName) {
+        build_attribute_indices();
+    }
+
+    for (slot = hash_attribute_name(name) & attributeIndexMask;
+         attributeIndexByName[slot];
+         slot = (slot + 1) & attributeIndexMask) {
+        const AttributeTableEntry *t =
+            attributeTable + attributeIndexByName[slot] - 1;
         if (nv_strcasecmp(name, t->name)) {
             return t;
         }
@@ -491,6 +588,8 @@ static int nv_parse_special_xscreen_target(ParsedAttribute *p,
  * \param[out] p      ParsedAttribute to be modified with the X Display and/or
  *                    target type + target id or generic specification
  *                    information.
+ * \param[in]  arena  If not NULL, the arena in which to intern the strings
+ *                    stored in p.
  *
  * \return  Return NV_PARSER_STATUS_SUCCESS if the string was successfully
  *          parsed; Else, one of the NV_PARSER_STATUS_XXX errors that describes
@@ -499,7 +598,8 @@ static int nv_parse_special_xscreen_target(ParsedAttribute *p,
 
 static int nv_parse_display_and_target(const char *start,
                                        const char *end, /* exclusive */
-                                       ParsedAttribute *p)
+                                       ParsedAttribute *p,
+                                       ParserArena *arena)
 {
     int len;
     const char *s, *pOpen, *pClose;
@@ -558,7 +658,9 @@ static int nv_parse_display_and_target(const char *start,
 
         len = pClose - pOpen - 1;
 
-        p->target_specification = nvstrndup(pOpen + 1, len);
+        p->target_specification =
+            arena ? nv_parser_arena_intern(arena, pOpen + 1, len) :
+                    nvstrndup(pOpen + 1, len);
 
         /*
          * The X Display name should end on the opening bracket of the target
@@ -572,8 +674,11 @@ static int nv_parse_display_and_target(const char *start,
 
     if (startDisplayName < endDisplayName) {
 
-        p->display = nvstrndup(startDisplayName,
-                               endDisplayName - startDisplayName);
+        len = endDisplayName - startDisplayName;
+
+        p->display = arena ? nv_parser_arena_intern(arena, startDisplayName,
+                                                    len) :
+                             nvstrndup(startDisplayName, len);
         p->parser_flags.has_x_display = NV_TRUE;
 
         /*
@@ -594,13 +699,40 @@ static int nv_parse_display_and_target(const char *start,
  */
 
 int nv_parse_attribute_string(const char *str, int query, ParsedAttribute *p)
+{
+    return nv_parse_attribute_slice(str, str ? strlen(str) : 0, query, p,
+                                    NULL);
+}
+
+
+
+/*
+ * Parsed lines that fit in this many characters are copied to the stack
+ * rather than to the heap, while removing their white space.
+ */
+
+#define NV_PARSER_LINE_BUF_LEN 256
+
+/*
+ * nv_parse_attribute_slice() - see comments in parse.h
+ */
+
+int nv_parse_attribute_slice(const char *str, size_t str_len, int query,
+                             ParsedAttribute *p, ParserArena *arena)
 {
     char *s, *tmp, *name, *start, *equal_sign, *no_spaces = NULL;
     char tmpname[NV_PARSER_MAX_NAME_LEN];
+    char line_buf[NV_PARSER_LINE_BUF_LEN];
     int len, ret;
+    size_t i;
     const AttributeTableEntry *a;
 
-#define stop(x) { if (no_spaces) free(no_spaces); return (x); }
+#define stop(x) {                                        \
+        if (no_spaces && (no_spaces != line_buf)) {      \
+            free(no_spaces);                             \
+        }                                                \
+        return (x);                                      \
+    }
 
     if (!p) {
         stop(NV_PARSER_STATUS_BAD_ARGUMENT);
@@ -612,10 +744,17 @@ int nv_parse_attribute_string(const char *str, int query, ParsedAttribute *p)
     p->target_id = -1;
     p->target_type = INVALID_TARGET;
 
+    if (!str) stop(NV_PARSER_STATUS_EMPTY_STRING);
+
     /* remove any white space from the string, to simplify parsing */
 
-    no_spaces = remove_spaces(str);
-    if (!no_spaces) stop(NV_PARSER_STATUS_EMPTY_STRING);
+    no_spaces = (str_len < sizeof(line_buf)) ? line_buf :
+                                               nvalloc(str_len + 1);
+    s = no_spaces;
+    for (i = 0; (i < str_len) && str[i]; i++) {
+        if (!isspace(str[i])) *s++ = str[i];
+    }
+    *s = '\0';
 
     /*
      * temporarily terminate the string at the equal sign, so that the
@@ -645,7 +784,7 @@ int nv_parse_attribute_string(const char *str, int query, ParsedAttribute *p)
 
     if ((s) && (s != no_spaces)) {
 
-        ret = nv_parse_display_and_target(no_spaces, s, p);
+        ret = nv_parse_display_and_target(no_spaces, s, p, arena);
 
         if (ret != NV_PARSER_STATUS_SUCCESS) {
             stop(ret);
@@ -799,7 +938,162 @@ int nv_parse_attribute_string(const char *str, int query, ParsedAttribute *p)
 
     stop(NV_PARSER_STATUS_SUCCESS);
 
-} /* nv_parse_attribute_string() */
+#undef stop
+
+} /* nv_parse_attribute_slice() */
+
+
+
+/*
+ * ParserArena - see comments in parse.h.  Allocations are rounded up to
+ * PARSER_ARENA_ALIGN bytes, which is enough for the pointers, integers
+ * and floats held by parsed attributes.  Interned strings are found
+ * through an open addressing hash table of PARSER_ARENA_MIN_STRINGS
+ * entries or more, kept at most half full.
+ */
+
+#define PARSER_ARENA_BLOCK_SIZE  (64 * 1024)
+#define PARSER_ARENA_ALIGN       8
+#define PARSER_ARENA_MIN_STRINGS 64
+
+typedef struct _ParserArenaBlock ParserArenaBlock;
+
+struct _ParserArenaBlock {
+    ParserArenaBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+struct _ParserArena {
+    ParserArenaBlock *blocks;
+    char **strings;
+    size_t num_strings;
+    size_t strings_size;    /* a power of two */
+};
+
+
+ParserArena *nv_parser_arena_new(void)
+{
+    return nvalloc(sizeof(ParserArena));
+}
+
+
+void *nv_parser_arena_alloc(ParserArena *arena, size_t size)
+{
+    ParserArenaBlock *block = arena->blocks;
+    void *ptr;
+
+    size = (size + PARSER_ARENA_ALIGN - 1) & ~(size_t)(PARSER_ARENA_ALIGN - 1);
+
+    if (!block || (block->size - block->used < size)) {
+        size_t block_size = NV_MAX(size, PARSER_ARENA_BLOCK_SIZE);
+
+        block = nvalloc(sizeof(ParserArenaBlock) + block_size);
+        block->size = block_size;
+
+        /*
+         * Keep allocating from the current block if the new one was only
+         * made for this (large) allocation.
+         */
+
+        if (arena->blocks && (block_size > PARSER_ARENA_BLOCK_SIZE)) {
+            block->next = arena->blocks->next;
+            arena->blocks->next = block;
+        } else {
+            block->next = arena->blocks;
+            arena->blocks = block;
+        }
+    }
+
+    ptr = block->data + block->used;
+    block->used += size;
+
+    /* Blocks are zeroed by nvalloc() and never reused */
+
+    return ptr;
+}
+
+
+static size_t parser_arena_hash(const char *s, size_t len)
+{
+    size_t hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        hash = (hash ^ (unsigned char) s[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+
+char *nv_parser_arena_intern(ParserArena *arena, const char *s, size_t len)
+{
+    size_t mask, i;
+    char *str;
+
+    if (2 * (arena->num_strings + 1) > arena->strings_size) {
+        char **old = arena->strings;
+        size_t old_size = arena->strings_size;
+
+        arena->strings_size = old_size ? 2 * old_size :
+                                         PARSER_ARENA_MIN_STRINGS;
+        arena->strings = nvalloc(arena->strings_size * sizeof(char *));
+        mask = arena->strings_size - 1;
+
+        for (i = 0; i < old_size; i++) {
+            size_t j;
+
+            if (!old[i]) continue;
+
+            j = parser_arena_hash(old[i], strlen(old[i])) & mask;
+            while (arena->strings[j]) {
+                j = (j + 1) & mask;
+            }
+            arena->strings[j] = old[i];
+        }
+
+        nvfree(old);
+    }
+
+    mask = arena->strings_size - 1;
+
+    for (i = parser_arena_hash(s, len) & mask; arena->strings[i];
+         i = (i + 1) & mask) {
+        str = arena->strings[i];
+        if ((strncmp(str, s, len) == 0) && (str[len] == '\0')) {
+            return str;
+        }
+    }
+
+    str = nv_parser_arena_alloc(arena, len + 1);
+    memcpy(str, s, len);
+    str[len] = '\0';
+
+    arena->strings[i] = str;
+    arena->num_strings++;
+
+    return str;
+}
+
+
+void nv_parser_arena_free(ParserArena *arena)
+{
+    if (!arena) {
+        return;
+    }
+
+    while (arena->blocks) {
+        ParserArenaBlock *block = arena->blocks;
+
+        arena->blocks = block->next;
+        nvfree(block);
+    }
+
+    nvfree(arena->strings);
+    nvfree(arena);
+}
 
 
 
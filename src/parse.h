@@ -219,6 +219,34 @@ extern const int attributeTableLen;
 int nv_parse_attribute_string(const char *, int, ParsedAttribute *);
 
 
+/*
+ * ParserArena - memory for parsed attributes and the strings they
+ * refer to, carved out of large blocks and freed all at once.  Strings
+ * added with nv_parser_arena_intern() are stored only once, however many
+ * times they are interned, so that interned strings can be compared by
+ * address.  Nothing allocated from an arena may be passed to free().
+ */
+
+typedef struct _ParserArena ParserArena;
+
+ParserArena *nv_parser_arena_new(void);
+void *nv_parser_arena_alloc(ParserArena *, size_t);
+char *nv_parser_arena_intern(ParserArena *, const char *, size_t);
+void nv_parser_arena_free(ParserArena *);
+
+
+/*
+ * nv_parse_attribute_slice() - like nv_parse_attribute_string(), but
+ * parses the 'len' characters at 'str', which need not be NUL
+ * terminated.  If 'arena' is not NULL, the X Display name and target
+ * specification are interned in it rather than allocated, and must not
+ * be freed.
+ */
+
+int nv_parse_attribute_slice(const char *str, size_t len, int query,
+                             ParsedAttribute *p, ParserArena *arena);
+
+
 /*
  * nv_assign_default_display() - assigns the display name to the
  * ParsedAttribute struct.  As a side affect, also assigns the screen
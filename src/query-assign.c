@@ -29,6 +29,11 @@
 #include <ctype.h>
 #include <string.h>
 #include <inttypes.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
 
 #include <X11/Xlib.h>
 #include "NVCtrlLib.h"
@@ -38,6 +43,8 @@
 #include "query-assign.h"
 #include "common-utils.h"
 
+#include <jansson.h>
+
 /* local prototypes */
 
 #define PRODUCT_NAME_LEN 64
@@ -50,6 +57,11 @@ static int process_attribute_assignments(const Options *,
                                          int, char**, const char *,
                                          CtrlSystemList *);
 
+static int monitor_attributes(const Options *, int, char **, const char *,
+                              CtrlSystemList *);
+
+static void flush_assignment_batch(void);
+
 static int query_all(const Options *, const char *, CtrlSystemList *);
 static int query_all_targets(const char *display_name, const int target_type,
                              CtrlSystemList *);
@@ -66,20 +78,19 @@ static ReturnStatus get_framelock_sync_state(CtrlTarget *target,
                                              int *enabled);
 
 /*
- * nv_process_assignments_and_queries() - process any assignments or
- * queries specified on the commandline.  If an error occurs, return
- * NV_FALSE.  On success return NV_TRUE.
+ * process_display() - process the queries and assignments specified on
+ * the commandline, using 'display' as the default display.
  */
 
-int nv_process_assignments_and_queries(const Options *op,
-                                       CtrlSystemList *systems)
+static int process_display(const Options *op, const char *display,
+                           CtrlSystemList *systems)
 {
     int ret;
 
     if (op->num_queries) {
         ret = process_attribute_queries(op,
                                         op->num_queries,
-                                        op->queries, op->ctrl_display,
+                                        op->queries, display,
                                         systems);
         if (!ret) return NV_FALSE;
     }
@@ -88,10 +99,167 @@ int nv_process_assignments_and_queries(const Options *op,
         ret = process_attribute_assignments(op,
                                             op->num_assignments,
                                             op->assignments,
-                                            op->ctrl_display,
+                                            display,
                                             systems);
         if (!ret) return NV_FALSE;
     }
+
+    return NV_TRUE;
+
+} /* process_display() */
+
+
+
+/*
+ * When several displays are given with --ctrl-display, the queries and
+ * assignments are processed on each of them by a worker of its own, so
+ * that the X servers are waited for concurrently rather than one after
+ * the other.  The workers are processes rather than threads: this keeps
+ * Xlib and the NvCtrl state private to each display, and lets the output
+ * of each worker be captured and printed once it is done, in the order
+ * the displays were given.
+ */
+
+typedef struct {
+    pid_t pid;
+    FILE *out;      /* captured stdout of the worker */
+    FILE *err;      /* captured stderr of the worker */
+} DisplayWorker;
+
+
+
+static void print_worker_output(FILE *from, FILE *to)
+{
+    char buf[4096];
+    size_t n;
+
+    if (!from) {
+        return;
+    }
+
+    rewind(from);
+    while ((n = fread(buf, 1, sizeof(buf), from)) > 0) {
+        fwrite(buf, 1, n, to);
+    }
+    fflush(to);
+    fclose(from);
+}
+
+
+
+/*
+ * process_displays() - fork one worker per display to process the
+ * queries and assignments, then wait for them in order and print their
+ * output.  Returns NV_TRUE only if all the workers succeeded.
+ */
+
+static int process_displays(const Options *op)
+{
+    DisplayWorker *workers;
+    int i, ret = NV_TRUE;
+
+    workers = nvalloc(sizeof(DisplayWorker) * op->num_ctrl_displays);
+
+    /* Flush pending output, so that the workers don't print it again */
+
+    fflush(stdout);
+    fflush(stderr);
+
+    for (i = 0; i < op->num_ctrl_displays; i++) {
+        DisplayWorker *w = &workers[i];
+
+        w->pid = -1;
+        w->out = tmpfile();
+        w->err = tmpfile();
+
+        if (!w->out || !w->err) {
+            nv_error_msg("Unable to create a temporary file to process "
+                         "display '%s' (%s).", op->ctrl_displays[i],
+                         strerror(errno));
+            ret = NV_FALSE;
+            continue;
+        }
+
+        w->pid = fork();
+
+        if (w->pid == 0) {
+            CtrlSystemList systems;
+            int status;
+
+            systems.n = 0;
+            systems.array = NULL;
+
+            dup2(fileno(w->out), STDOUT_FILENO);
+            dup2(fileno(w->err), STDERR_FILENO);
+
+            status = process_display(op, op->ctrl_displays[i], &systems);
+            NvCtrlFreeAllSystems(&systems);
+
+            fflush(stdout);
+            fflush(stderr);
+            _exit(status ? 0 : 1);
+        }
+
+        if (w->pid < 0) {
+            nv_error_msg("Unable to start processing display '%s' (%s).",
+                         op->ctrl_displays[i], strerror(errno));
+            ret = NV_FALSE;
+        }
+    }
+
+    for (i = 0; i < op->num_ctrl_displays; i++) {
+        DisplayWorker *w = &workers[i];
+        int status;
+
+        if (w->pid > 0) {
+            while ((waitpid(w->pid, &status, 0) < 0) && (errno == EINTR));
+
+            if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
+                ret = NV_FALSE;
+            }
+        }
+
+        print_worker_output(w->out, stdout);
+        print_worker_output(w->err, stderr);
+    }
+
+    nvfree(workers);
+
+    return ret;
+
+} /* process_displays() */
+
+
+
+/*
+ * nv_process_assignments_and_queries() - process any assignments or
+ * queries specified on the commandline.  If an error occurs, return
+ * NV_FALSE.  On success return NV_TRUE.
+ */
+
+int nv_process_assignments_and_queries(const Options *op,
+                                       CtrlSystemList *systems)
+{
+    int ret;
+
+    if (op->num_ctrl_displays > 1) {
+        if (op->num_queries || op->num_assignments) {
+            ret = process_displays(op);
+            if (!ret) return NV_FALSE;
+        }
+    } else {
+        ret = process_display(op, op->ctrl_display, systems);
+        if (!ret) return NV_FALSE;
+    }
+
+    if (op->num_monitors) {
+        ret = monitor_attributes(op,
+                                 op->num_monitors,
+                                 op->monitors,
+                                 op->ctrl_display,
+                                 systems);
+        if (!ret) return NV_FALSE;
+    }
     
     return NV_TRUE;
 
@@ -314,6 +482,7 @@ static int nv_infer_targets_from_specification(ParsedAttribute *p,
     char *specification;
 
     int target_type;
+    CtrlTargetNode *named = NULL;
 
     const CtrlTargetTypeInfo *matchTargetTypeInfo;
     int matchTargetId;
@@ -392,12 +561,19 @@ static int nv_infer_targets_from_specification(ParsedAttribute *p,
         goto done;
     }
 
+    /* Look the named targets up once, rather than for each target type */
+    if (matchTargetName) {
+        named = NvCtrlGetTargetsByName(system, matchTargetName);
+    }
+
     /* Iterate over the target types */
     for (target_type = 0;
          target_type < MAX_TARGET_TYPES;
          target_type++) {
         const CtrlTargetTypeInfo *targetTypeInfo =
             NvCtrlGetTargetTypeInfo(target_type);
+        CtrlTargetNode *candidates;
+        CtrlTargetNode by_id;
         CtrlTargetNode *node;
 
         if (matchTargetTypeInfo &&
@@ -405,16 +581,25 @@ static int nv_infer_targets_from_specification(ParsedAttribute *p,
             continue;
         }
 
-        /* For each target of this type, match the id and/or name */
-        for (node = system->targets[target_type]; node; node = node->next) {
+        /* Only consider the targets that can match the id and/or name */
+        if (matchTargetName) {
+            candidates = named;
+        } else if (matchTargetId >= 0) {
+            by_id.next = NULL;
+            by_id.t = NvCtrlGetTarget(system, target_type, matchTargetId);
+            candidates = by_id.t ? &by_id : NULL;
+        } else {
+            candidates = system->targets[target_type];
+        }
+
+        for (node = candidates; node; node = node->next) {
             CtrlTarget *t = node->t;
 
-            if ((matchTargetId >= 0) &&
-                matchTargetId != NvCtrlGetTargetId(t)) {
+            if (NvCtrlGetTargetType(t) != target_type) {
                 continue;
             }
-            if (matchTargetName &&
-                !nv_target_has_name(t, matchTargetName)) {
+            if ((matchTargetId >= 0) &&
+                matchTargetId != NvCtrlGetTargetId(t)) {
                 continue;
             }
 
@@ -432,6 +617,7 @@ static int nv_infer_targets_from_specification(ParsedAttribute *p,
     }
 
  done:
+    NvCtrlTargetListFree(named);
     free(specification);
     return ret;
 }
@@ -495,6 +681,7 @@ static void resolve_display_mask_string(ParsedAttribute *p, const char *whence)
 
             /* Warn that this usage is deprecated */
 
+            flush_assignment_batch();
             nv_deprecated_msg("Display mask usage as specified %s has been "
                               "deprecated and will be removed in the future.  "
                               "Please use display names and/or display target "
@@ -704,6 +891,40 @@ static int resolve_attribute_targets(ParsedAttribute *p, CtrlSystem *system,
 
 
 
+/*
+ * nv_resolve_parsed_attribute_targets() - resolves the list of targets
+ * of the ParsedAttribute 'p' ahead of processing it, so that callers
+ * can inspect or trim that list before calling
+ * nv_process_parsed_attribute(), which then uses it as is.
+ *
+ * Returns one of the NV_PARSER_STATUS_XXX codes; on failure, 'p' is left
+ * unresolved.
+ */
+
+int nv_resolve_parsed_attribute_targets(ParsedAttribute *p,
+                                        CtrlSystem *system,
+                                        const char *whence)
+{
+    ParsedAttribute resolved = *p;
+    int ret;
+
+    resolved.targets = NULL;
+
+    ret = resolve_attribute_targets(&resolved, system, whence);
+    if ((ret != NV_PARSER_STATUS_SUCCESS) || !resolved.targets) {
+        NvCtrlTargetListFree(resolved.targets);
+        return (ret != NV_PARSER_STATUS_SUCCESS) ? ret :
+            NV_PARSER_STATUS_TARGET_SPEC_NO_TARGETS;
+    }
+
+    *p = resolved;
+
+    return NV_PARSER_STATUS_SUCCESS;
+
+} /* nv_resolve_parsed_attribute_targets() */
+
+
+
 /*
  * process_attribute_queries() - parse the list of queries, and call
  * nv_ctrl_process_parsed_attribute() to process each query.
@@ -763,141 +984,794 @@ static int process_attribute_queries(const Options *op,
             continue;
         }
 
-        if (nv_strcasecmp(queries[query], "thermalsensors")) {
-            query_all_targets(display_name, THERMAL_SENSOR_TARGET, systems);
-            continue;
-        }
+        if (nv_strcasecmp(queries[query], "thermalsensors")) {
+            query_all_targets(display_name, THERMAL_SENSOR_TARGET, systems);
+            continue;
+        }
+
+        if (nv_strcasecmp(queries[query], "svps")) {
+            query_all_targets(display_name, 
+                              NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET, 
+                              systems);
+            continue;
+        }
+
+        if (nv_strcasecmp(queries[query], "dpys")) {
+            query_all_targets(display_name, DISPLAY_TARGET, systems);
+            continue;
+        }
+
+        if (nv_strcasecmp(queries[query], "muxes")) {
+            query_all_targets(display_name, MUX_TARGET, systems);
+            continue;
+        }
+
+        /* call the parser to parse queries[query] */
+
+        ret = nv_parse_attribute_string(queries[query], NV_PARSER_QUERY, &a);
+        if (ret != NV_PARSER_STATUS_SUCCESS) {
+            nv_error_msg("Error parsing query '%s' (%s).",
+                         queries[query], nv_parse_strerror(ret));
+            goto done;
+        }
+        
+        /* make sure we have a display */
+
+        nv_assign_default_display(&a, display_name);
+
+        /* connect to all the systems */
+
+        system = NvCtrlConnectToSystem(a.display, systems);
+        if (!system) {
+            goto done;
+        }
+
+        /* call the processing engine to process the parsed query */
+
+        ret = nv_process_parsed_attribute(op, &a, system, NV_FALSE, NV_FALSE,
+                                          "in query '%s'", queries[query]);
+        if (ret == NV_FALSE) goto done;
+
+        /* print a newline at the end */
+        if (!op->terse) {
+            nv_msg(NULL, "");
+        }
+
+    } /* query */
+
+    val = NV_TRUE;
+    
+ done:
+    
+    return val;
+    
+} /* process_attribute_queries() */
+
+
+
+/*
+ * Batch of integer assignments.  Between nv_start_assignment_batch() and
+ * nv_end_assignment_batch(), process_parsed_attribute_internal()
+ * validates the assignments that can_batch_assignment() accepts but adds
+ * them to the batch rather than making them; flush_assignment_batch()
+ * then makes all of them with NvCtrlSetAttributesBatch(), and reports
+ * their errors, or their values when verbose, in order.  Entries without
+ * an attribute stand for the newline printed after each assignment.
+ *
+ * So that messages come out in the same order as when assignments are
+ * made right away, the batch is flushed before any message is printed
+ * while processing an integer assignment, and before processing any
+ * other attribute.
+ */
+
+typedef struct {
+    CtrlAttributeAssignment assignment;
+    const AttributeTableEntry *a;
+    char *whence;
+    char str[32];
+    int verbose;
+} BatchedAssignment;
+
+static int __batch_active = NV_FALSE;
+static BatchedAssignment *__batch = NULL;
+static int __batch_count = 0;
+static int __batch_size = 0;
+
+
+
+/*
+ * can_batch_assignment() - returns whether assignments of the attribute
+ * 'a' can be batched: integer attributes, except frame lock attributes,
+ * whose processing depends on the frame lock state left by previous
+ * assignments.
+ */
+
+static int can_batch_assignment(const AttributeTableEntry *a)
+{
+    return (a->type == CTRL_ATTRIBUTE_TYPE_INTEGER) &&
+        !a->flags.is_framelock_attribute;
+}
+
+
+
+static BatchedAssignment *add_batch_entry(void)
+{
+    BatchedAssignment *b;
+
+    if (__batch_count == __batch_size) {
+        __batch_size = __batch_size ? __batch_size * 2 : 16;
+        __batch = nvrealloc(__batch, __batch_size * sizeof(BatchedAssignment));
+    }
+
+    b = &__batch[__batch_count++];
+    memset(b, 0, sizeof(*b));
+
+    return b;
+}
+
+
+
+static void add_batched_assignment(CtrlTarget *t, uint32 d,
+                                   const AttributeTableEntry *a, int val,
+                                   const char *whence, const char *str,
+                                   int verbose)
+{
+    BatchedAssignment *b = add_batch_entry();
+
+    b->assignment.ctrl_target = t;
+    b->assignment.display_mask = d;
+    b->assignment.attr = a->attr;
+    b->assignment.val = val;
+    b->a = a;
+    b->whence = nvstrdup(whence);
+    snprintf(b->str, sizeof(b->str), "%s", str);
+    b->verbose = verbose;
+}
+
+
+
+/*
+ * flush_assignment_batch() - make the batched assignments, and report
+ * their results as process_parsed_attribute_internal() does for
+ * assignments made right away.
+ */
+
+static void flush_assignment_batch(void)
+{
+    CtrlAttributeAssignment *assignments;
+    int i, count = 0;
+
+    if (__batch_count == 0) {
+        return;
+    }
+
+    assignments = nvalloc(__batch_count * sizeof(CtrlAttributeAssignment));
+
+    for (i = 0; i < __batch_count; i++) {
+        if (__batch[i].a) {
+            assignments[count++] = __batch[i].assignment;
+        }
+    }
+
+    NvCtrlSetAttributesBatch(assignments, count);
+
+    for (i = 0, count = 0; i < __batch_count; i++) {
+        const BatchedAssignment *b = &__batch[i];
+        const AttributeTableEntry *a = b->a;
+        CtrlTarget *t = b->assignment.ctrl_target;
+        int val = b->assignment.val;
+        ReturnStatus status;
+
+        if (!a) {
+            nv_msg(NULL, "");
+            continue;
+        }
+
+        status = assignments[count++].status;
+
+        if (status != NvCtrlSuccess) {
+            nv_error_msg("Error assigning value %d to attribute '%s' "
+                         "(%s%s) as specified %s (%s).",
+                         val, a->name, t->name, b->str, b->whence,
+                         NvCtrlAttributesStrError(status));
+        } else if (b->verbose) {
+            if (a->f.int_flags.is_packed) {
+                nv_msg("  ", "Attribute '%s' (%s%s) assigned value %d,%d.",
+                       a->name, t->name, b->str, val >> 16, val & 0xffff);
+            } else {
+                nv_msg("  ", "Attribute '%s' (%s%s) assigned value %d.",
+                       a->name, t->name, b->str, val);
+            }
+        }
+
+        nvfree(b->whence);
+    }
+
+    nvfree(assignments);
+
+    __batch_count = 0;
+
+} /* flush_assignment_batch() */
+
+
+
+/*
+ * nv_start_assignment_batch() - start batching the integer assignments
+ * made by nv_process_parsed_attribute().
+ */
+
+void nv_start_assignment_batch(void)
+{
+    __batch_active = NV_TRUE;
+}
+
+
+
+/*
+ * nv_end_assignment_batch() - make the assignments batched since
+ * nv_start_assignment_batch(), and stop batching.
+ */
+
+void nv_end_assignment_batch(void)
+{
+    flush_assignment_batch();
+    __batch_active = NV_FALSE;
+}
+
+
+
+/*
+ * process_attribute_assignments() - parse the list of
+ * assignments, and call nv_process_parsed_attribute() to process
+ * each assignment.
+ *
+ * Runs of integer assignments are sent to the X server in batches (see
+ * flush_assignment_batch()): each assignment is validated as it is
+ * processed, but the values are only sent, and the results reported,
+ * once the run ends.
+ *
+ * If any errors are encountered, an error message is printed and
+ * NV_FALSE is returned.  Otherwise, NV_TRUE is returned.
+ */
+
+static int process_attribute_assignments(const Options *op,
+                                         int num, char **assignments,
+                                         const char *display_name,
+                                         CtrlSystemList *systems)
+{
+    int assignment, ret, val, batch;
+    ParsedAttribute a;
+    CtrlSystem *system = NULL;
+
+    val = NV_FALSE;
+
+    /* print a newline before we begin */
+
+    nv_msg(NULL, "");
+
+    if (!op->list_targets) {
+        nv_start_assignment_batch();
+    }
+
+    /* loop over each requested assignment */
+
+    for (assignment = 0; assignment < num; assignment++) {
+        
+        /* call the parser to parse assignments[assignment] */
+
+        ret = nv_parse_attribute_string(assignments[assignment],
+                                        NV_PARSER_ASSIGNMENT, &a);
+
+        if (ret != NV_PARSER_STATUS_SUCCESS) {
+            flush_assignment_batch();
+            nv_error_msg("Error parsing assignment '%s' (%s).",
+                         assignments[assignment], nv_parse_strerror(ret));
+            goto done;
+        }
+        
+        /* make sure we have a display */
+
+        nv_assign_default_display(&a, display_name);
+
+        /*
+         * the previous assignments are made before connecting to another
+         * system, which may fail with an error
+         */
+
+        batch = !op->list_targets && can_batch_assignment(a.attr_entry);
+
+        if (system && !nv_strcasecmp(system->display, a.display)) {
+            flush_assignment_batch();
+        }
+
+        /* allocate the CtrlSystem */
+
+        system = NvCtrlConnectToSystem(a.display, systems);
+        if (!system) {
+            goto done;
+        }
+
+        /* call the processing engine to process the parsed assignment */
+
+        ret = nv_process_parsed_attribute(op, &a, system, NV_TRUE, NV_TRUE,
+                                          "in assignment '%s'",
+                                          assignments[assignment]);
+
+        if (ret == NV_FALSE) goto done;
+
+        /*
+         * print a newline at the end; for batched assignments, this is
+         * done once they are made
+         */
+
+        if (batch) {
+            add_batch_entry();
+        } else {
+            nv_msg(NULL, "");
+        }
+
+    } /* assignment */
+
+    val = NV_TRUE;
+
+ done:
+
+    nv_end_assignment_batch();
+
+    return val;
+
+} /* nv_process_attribute_assignments() */
+
+
+/*
+ * Monitoring state for '--monitor': the set of (target, attribute) pairs
+ * to sample, and the rows (targets) and columns (attributes) they are
+ * reported in.  An attribute monitored for several display devices gets
+ * a column for each of them, named after the attribute and the display
+ * device.
+ */
+
+typedef struct {
+    CtrlTarget *t;
+    const AttributeTableEntry *a;
+    uint32 d;
+    int row;
+    int column;
+
+    ReturnStatus status;
+    int64_t val;
+    char *str;
+} MonitorItem;
+
+typedef struct {
+    const AttributeTableEntry *a;
+    uint32 d;
+    char *name;
+} MonitorColumn;
+
+typedef struct {
+    MonitorItem *items;
+    int num_items;
+
+    CtrlTarget **rows;
+    int num_rows;
+
+    MonitorColumn *columns;
+    int num_columns;
+} MonitorState;
+
+
+
+/*
+ * monitor_add_item() - add the attribute 'a' on target 't' and display
+ * devices 'd' to the list of sampled items, allocating a row for the
+ * target and a column for the attribute and display devices if they are
+ * new.
+ */
+
+static void monitor_add_item(MonitorState *m, CtrlTarget *t,
+                             const AttributeTableEntry *a, uint32 d)
+{
+    MonitorItem *item;
+    int row, column, i;
+
+    for (row = 0; row < m->num_rows; row++) {
+        if (m->rows[row] == t) break;
+    }
+    if (row == m->num_rows) {
+        m->rows = nvrealloc(m->rows, sizeof(*m->rows) * (row + 1));
+        m->rows[m->num_rows++] = t;
+    }
+
+    for (column = 0; column < m->num_columns; column++) {
+        if ((m->columns[column].a == a) && (m->columns[column].d == d)) break;
+    }
+    if (column == m->num_columns) {
+        MonitorColumn *c;
+
+        m->columns = nvrealloc(m->columns,
+                               sizeof(*m->columns) * (column + 1));
+        c = &m->columns[m->num_columns++];
+        c->a = a;
+        c->d = d;
+        if (d) {
+            char *tmp_d_str = display_device_mask_to_display_device_name(d);
+            c->name = nvstrcat(a->name, "[", tmp_d_str, "]", NULL);
+            free(tmp_d_str);
+        } else {
+            c->name = nvstrdup(a->name);
+        }
+    }
+
+    /* the same attribute may be requested twice for a target */
+
+    for (i = 0; i < m->num_items; i++) {
+        if ((m->items[i].row == row) && (m->items[i].column == column)) {
+            return;
+        }
+    }
+
+    m->items = nvrealloc(m->items, sizeof(*m->items) * (m->num_items + 1));
+    item = &m->items[m->num_items++];
+    memset(item, 0, sizeof(*item));
+
+    item->t = t;
+    item->a = a;
+    item->d = d;
+    item->row = row;
+    item->column = column;
+}
+
+
+
+/*
+ * monitor_add_query() - parse a single query string given to '--monitor'
+ * and add the attribute on each of the targets it resolves to.
+ */
+
+static int monitor_add_query(MonitorState *m, const char *query,
+                             const char *display_name,
+                             CtrlSystemList *systems)
+{
+    ParsedAttribute a;
+    CtrlSystem *system;
+    CtrlTargetNode *n;
+    char *whence;
+    int ret;
+
+    ret = nv_parse_attribute_string(query, NV_PARSER_QUERY, &a);
+    if (ret != NV_PARSER_STATUS_SUCCESS) {
+        nv_error_msg("Error parsing monitored attribute '%s' (%s).",
+                     query, nv_parse_strerror(ret));
+        return NV_FALSE;
+    }
+
+    if ((a.attr_entry->type != CTRL_ATTRIBUTE_TYPE_INTEGER) &&
+        (a.attr_entry->type != CTRL_ATTRIBUTE_TYPE_STRING)) {
+        nv_error_msg("The attribute '%s' cannot be monitored; only integer "
+                     "and string attributes can be.", a.attr_entry->name);
+        return NV_FALSE;
+    }
+
+    nv_assign_default_display(&a, display_name);
+
+    system = NvCtrlConnectToSystem(a.display, systems);
+    if (!system) {
+        return NV_FALSE;
+    }
+
+    whence = nvstrcat("in monitored attribute '", query, "'", NULL);
+
+    ret = resolve_attribute_targets(&a, system, whence);
+    if (ret != NV_PARSER_STATUS_SUCCESS) {
+        nv_error_msg("Error resolving target specification '%s' "
+                     "(%s), specified %s.",
+                     a.target_specification ? a.target_specification : "",
+                     nv_parse_strerror(ret), whence);
+        nvfree(whence);
+        return NV_FALSE;
+    }
+    nvfree(whence);
+
+    for (n = a.targets; n; n = n->next) {
+        if (!n->t->h) continue; /* no handle on this target; silently skip */
+
+        monitor_add_item(m, n->t, a.attr_entry,
+                         a.parser_flags.has_display_device ?
+                         a.display_device_mask : 0);
+    }
+
+    NvCtrlTargetListFree(a.targets);
+
+    return NV_TRUE;
+}
+
+
+
+/*
+ * monitor_add_list() - split a comma separated list of queries given to
+ * '--monitor' and add each of them.  Commas within brackets belong to a
+ * target or display device specification and do not separate queries.
+ */
+
+static int monitor_add_list(MonitorState *m, const char *list,
+                            const char *display_name,
+                            CtrlSystemList *systems)
+{
+    char *buf = nvstrdup(list);
+    char *start, *c;
+    int depth = 0;
+    int ret = NV_TRUE;
+
+    for (start = c = buf; ret; c++) {
+        if (*c == '[') {
+            depth++;
+        } else if (*c == ']' && depth > 0) {
+            depth--;
+        } else if ((*c == ',' && depth == 0) || (*c == '\0')) {
+            int end = (*c == '\0');
+
+            *c = '\0';
+            start = nv_trim_space(start);
+            if (*start) {
+                ret = monitor_add_query(m, start, display_name, systems);
+            }
+            if (end) break;
+            start = c + 1;
+        }
+    }
+
+    nvfree(buf);
+
+    return ret;
+}
+
+
+
+static double timespec_to_ms(const struct timespec *ts)
+{
+    return (double) ts->tv_sec * 1000.0 + (double) ts->tv_nsec / 1000000.0;
+}
+
+
+
+/*
+ * monitor_sample() - query all the monitored items.  The integer
+ * attributes are sent as a single batch per X server.
+ */
+
+static void monitor_sample(MonitorState *m, CtrlAttributeQuery *queries)
+{
+    int i, count = 0;
+
+    for (i = 0; i < m->num_items; i++) {
+        MonitorItem *item = &m->items[i];
+
+        nvfree(item->str);
+        item->str = NULL;
+
+        if (item->a->type == CTRL_ATTRIBUTE_TYPE_INTEGER) {
+            queries[count].ctrl_target = item->t;
+            queries[count].display_mask = item->d;
+            queries[count].attr = item->a->attr;
+            count++;
+        } else {
+            item->status = NvCtrlGetStringDisplayAttribute(item->t, item->d,
+                                                           item->a->attr,
+                                                           &item->str);
+        }
+    }
+
+    NvCtrlGetAttributesBatch(queries, count);
+
+    for (i = 0, count = 0; i < m->num_items; i++) {
+        MonitorItem *item = &m->items[i];
+
+        if (item->a->type == CTRL_ATTRIBUTE_TYPE_INTEGER) {
+            item->status = queries[count].status;
+            item->val = queries[count].val;
+            count++;
+        }
+    }
+}
+
+
+
+/*
+ * monitor_print_csv_field() - print a string CSV field, quoting it if
+ * needed.
+ */
+
+static void monitor_print_csv_field(const char *str)
+{
+    const char *c;
+
+    if (!strpbrk(str, ",\"\n")) {
+        printf(",%s", str);
+        return;
+    }
+
+    printf(",\"");
+    for (c = str; *c; c++) {
+        if (*c == '"') putchar('"');
+        putchar(*c);
+    }
+    putchar('"');
+}
 
-        if (nv_strcasecmp(queries[query], "svps")) {
-            query_all_targets(display_name, 
-                              NVIDIA_3D_VISION_PRO_TRANSCEIVER_TARGET, 
-                              systems);
-            continue;
-        }
 
-        if (nv_strcasecmp(queries[query], "dpys")) {
-            query_all_targets(display_name, DISPLAY_TARGET, systems);
-            continue;
-        }
 
-        if (nv_strcasecmp(queries[query], "muxes")) {
-            query_all_targets(display_name, MUX_TARGET, systems);
-            continue;
-        }
+/*
+ * monitor_print() - print one line per target for the current sample,
+ * either as CSV or as a JSON object.
+ */
 
-        /* call the parser to parse queries[query] */
+static void monitor_print(const Options *op, const MonitorState *m,
+                          int sample, double elapsed, double lag)
+{
+    int row, column, i;
 
-        ret = nv_parse_attribute_string(queries[query], NV_PARSER_QUERY, &a);
-        if (ret != NV_PARSER_STATUS_SUCCESS) {
-            nv_error_msg("Error parsing query '%s' (%s).",
-                         queries[query], nv_parse_strerror(ret));
-            goto done;
-        }
-        
-        /* make sure we have a display */
+    for (row = 0; row < m->num_rows; row++) {
+        const CtrlTarget *t = m->rows[row];
 
-        nv_assign_default_display(&a, display_name);
+        if (op->monitor_json) {
+            json_t *obj = json_object();
+            char *line;
 
-        /* connect to all the systems */
+            json_object_set_new(obj, "sample", json_integer(sample));
+            json_object_set_new(obj, "elapsed_ms", json_real(elapsed));
+            json_object_set_new(obj, "lag_ms", json_real(lag));
+            json_object_set_new(obj, "target", json_string(t->name));
 
-        system = NvCtrlConnectToSystem(a.display, systems);
-        if (!system) {
-            goto done;
-        }
+            for (i = 0; i < m->num_items; i++) {
+                const MonitorItem *item = &m->items[i];
+                json_t *value;
 
-        /* call the processing engine to process the parsed query */
+                if (item->row != row) continue;
 
-        ret = nv_process_parsed_attribute(op, &a, system, NV_FALSE, NV_FALSE,
-                                          "in query '%s'", queries[query]);
-        if (ret == NV_FALSE) goto done;
+                if (item->status != NvCtrlSuccess) {
+                    value = json_null();
+                } else if (item->a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+                    value = json_string(item->str);
+                } else {
+                    value = json_integer(item->val);
+                }
+                json_object_set_new(obj, m->columns[item->column].name, value);
+            }
 
-        /* print a newline at the end */
-        if (!op->terse) {
-            nv_msg(NULL, "");
+            line = json_dumps(obj, JSON_COMPACT | JSON_PRESERVE_ORDER);
+            if (line) {
+                printf("%s\n", line);
+                free(line);
+            }
+            json_decref(obj);
+            continue;
         }
 
-    } /* query */
+        printf("%d,%.3f,%.3f", sample, elapsed, lag);
+        monitor_print_csv_field(t->name);
 
-    val = NV_TRUE;
-    
- done:
-    
-    return val;
-    
-} /* process_attribute_queries() */
+        for (column = 0; column < m->num_columns; column++) {
+            const MonitorItem *item = NULL;
+
+            for (i = 0; i < m->num_items; i++) {
+                if ((m->items[i].row == row) &&
+                    (m->items[i].column == column)) {
+                    item = &m->items[i];
+                    break;
+                }
+            }
+
+            if (!item || item->status != NvCtrlSuccess) {
+                printf(",");
+            } else if (item->a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
+                monitor_print_csv_field(item->str ? item->str : "");
+            } else {
+                printf(",%" PRId64, item->val);
+            }
+        }
+        printf("\n");
+    }
+}
 
 
 
 /*
- * process_attribute_assignments() - parse the list of
- * assignments, and call nv_process_parsed_attribute() to process
- * each assignment.
+ * monitor_attributes() - sample the attributes given to '--monitor' every
+ * op->monitor_interval milliseconds, until interrupted.
  *
- * If any errors are encountered, an error message is printed and
- * NV_FALSE is returned.  Otherwise, NV_TRUE is returned.
+ * Samples are scheduled on the monotonic clock relative to the first one,
+ * so that the time spent querying does not make the period drift; each
+ * line reports how late its sample ran compared to that schedule.  If a
+ * sample runs later than a whole period, the samples that could not be
+ * taken in time are skipped rather than taken back to back.
  */
 
-static int process_attribute_assignments(const Options *op,
-                                         int num, char **assignments,
-                                         const char *display_name,
-                                         CtrlSystemList *systems)
+static int monitor_attributes(const Options *op,
+                              int num, char **lists,
+                              const char *display_name,
+                              CtrlSystemList *systems)
 {
-    int assignment, ret, val;
-    ParsedAttribute a;
-    CtrlSystem *system;
-
-    val = NV_FALSE;
+    MonitorState m;
+    CtrlAttributeQuery *queries;
+    struct timespec start, next, now;
+    double elapsed, lag, interval_ms = op->monitor_interval;
+    int i, sample;
 
-    /* print a newline before we begin */
+    memset(&m, 0, sizeof(m));
 
-    nv_msg(NULL, "");
+    for (i = 0; i < num; i++) {
+        if (!monitor_add_list(&m, lists[i], display_name, systems)) {
+            return NV_FALSE;
+        }
+    }
 
-    /* loop over each requested assignment */
+    if (m.num_items == 0) {
+        nv_error_msg("No attributes to monitor.");
+        return NV_FALSE;
+    }
 
-    for (assignment = 0; assignment < num; assignment++) {
-        
-        /* call the parser to parse assignments[assignment] */
+    queries = nvalloc(sizeof(CtrlAttributeQuery) * m.num_items);
 
-        ret = nv_parse_attribute_string(assignments[assignment],
-                                        NV_PARSER_ASSIGNMENT, &a);
+    /* print the CSV header */
 
-        if (ret != NV_PARSER_STATUS_SUCCESS) {
-            nv_error_msg("Error parsing assignment '%s' (%s).",
-                         assignments[assignment], nv_parse_strerror(ret));
-            goto done;
+    if (!op->monitor_json) {
+        printf("sample,elapsed_ms,lag_ms,target");
+        for (i = 0; i < m.num_columns; i++) {
+            printf(",%s", m.columns[i].name);
         }
-        
-        /* make sure we have a display */
+        printf("\n");
+    }
 
-        nv_assign_default_display(&a, display_name);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    next = start;
 
-        /* allocate the CtrlSystem */
+    for (sample = 0; ; sample++) {
 
-        system = NvCtrlConnectToSystem(a.display, systems);
-        if (!system) {
-            goto done;
-        }
+        /* wait for the scheduled time of this sample */
 
-        /* call the processing engine to process the parsed assignment */
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+                               &next, NULL) == EINTR);
 
-        ret = nv_process_parsed_attribute(op, &a, system, NV_TRUE, NV_TRUE,
-                                          "in assignment '%s'",
-                                          assignments[assignment]);
-        if (ret == NV_FALSE) goto done;
+        clock_gettime(CLOCK_MONOTONIC, &now);
 
-        /* print a newline at the end */
+        elapsed = timespec_to_ms(&now) - timespec_to_ms(&start);
+        lag = timespec_to_ms(&now) - timespec_to_ms(&next);
 
-        nv_msg(NULL, "");
+        monitor_sample(&m, queries);
+        monitor_print(op, &m, sample, elapsed, lag);
 
-    } /* assignment */
+        if (fflush(stdout) != 0) {
+            break;
+        }
 
-    val = NV_TRUE;
+        /* schedule the next sample, skipping the ones already missed */
 
- done:
+        do {
+            next.tv_sec += op->monitor_interval / 1000;
+            next.tv_nsec += (op->monitor_interval % 1000) * 1000000;
+            if (next.tv_nsec >= 1000000000) {
+                next.tv_sec++;
+                next.tv_nsec -= 1000000000;
+            }
+            clock_gettime(CLOCK_MONOTONIC, &now);
+        } while (timespec_to_ms(&now) - timespec_to_ms(&next) >= interval_ms);
+    }
 
-    return val;
+    for (i = 0; i < m.num_items; i++) {
+        nvfree(m.items[i].str);
+    }
+    for (i = 0; i < m.num_columns; i++) {
+        nvfree(m.columns[i].name);
+    }
+    nvfree(m.items);
+    nvfree(m.rows);
+    nvfree(m.columns);
+    nvfree(queries);
 
-} /* nv_process_attribute_assignments() */
+    return NV_TRUE;
+
+} /* monitor_attributes() */
 
 
 
@@ -924,6 +1798,7 @@ static int validate_value(const Options *op, CtrlTarget *t,
 
     status = NvCtrlGetValidDisplayAttributeValues(t, d, a->attr, &valid);
     if (status != NvCtrlSuccess) {
+        flush_assignment_batch();
         nv_error_msg("Unable to query valid values for attribute %s (%s).",
                      a->name, NvCtrlAttributesStrError(status));
         return NV_FALSE;
@@ -997,6 +1872,7 @@ static int validate_value(const Options *op, CtrlTarget *t,
     /* if the value is bad, print why */
 
     if (bad_val) {
+        flush_assignment_batch();
         if (a->f.int_flags.is_packed) {
             nv_warning_msg("The value pair %d,%d for attribute '%s' (%s%s) "
                            "specified %s is invalid.",
@@ -1361,6 +2237,241 @@ static void print_additional_info(const char *name,
 
 
 
+/*
+ * query_all_skip_entry() - returns whether the attribute table entry 'a' is
+ * left out of the query_all() listing.
+ */
+
+static int query_all_skip_entry(const AttributeTableEntry *a)
+{
+    /* skip the color attributes */
+
+    if (a->type == CTRL_ATTRIBUTE_TYPE_COLOR) {
+        return NV_TRUE;
+    }
+
+    /* skip attributes that shouldn't be queried here */
+
+    return a->flags.no_query_all;
+}
+
+
+
+/*
+ * query_all_skip_mask() - returns whether query_all() skips the display
+ * device 'mask' of target 't': if the bit is not present in the target's
+ * enabled display device mask (and the target has enabled display devices),
+ * it moves on to the next bit.
+ */
+
+static int query_all_skip_mask(const CtrlTarget *t,
+                               const CtrlTargetTypeInfo *targetTypeInfo,
+                               uint32 mask)
+{
+    return targetTypeInfo->uses_display_devices &&
+        ((t->d & mask) == 0x0) && (t->d);
+}
+
+
+
+/*
+ * The valid values and value of an integer attribute for one display
+ * device bit, as prefetched for query_all().
+ */
+
+typedef struct {
+    CtrlAttributeValidValuesQuery valid;
+    CtrlAttributeQuery value;
+} PrefetchedValue;
+
+/*
+ * The prefetched values of a target: the values of attribute table entry
+ * 'entry' are values[first[entry]] through values[first[entry] +
+ * count[entry] - 1], in the order of the display device bits query_all()
+ * visits.
+ */
+
+typedef struct {
+    PrefetchedValue *values;
+    int *first;
+    int *count;
+} PrefetchedValues;
+
+
+
+/*
+ * prefetch_attribute_values() - query_all() needs the valid values and
+ * the value of nearly every integer attribute of a target, for each
+ * display device bit it visits.  Rather than waiting for each of them in
+ * turn, send them as a few batches up front:
+ *
+ *  - the valid values for the first display device bit of each attribute;
+ *  - the valid values for the other display device bits of the attributes
+ *    query_all() goes on to query per display device;
+ *  - the values for each display device bit whose valid values query
+ *    succeeded and that query_all() reaches.
+ */
+
+static void prefetch_attribute_values(CtrlTarget *t,
+                                      const CtrlTargetTypeInfo *targetTypeInfo,
+                                      int target_type,
+                                      PrefetchedValues *p)
+{
+    CtrlAttributeValidValuesQuery *valid;
+    CtrlAttributeQuery *values;
+    int *slots;
+    uint32 bits = 0;
+    int entry, bit, i, n, count, total, numBits, firstBit = -1;
+
+    p->values = NULL;
+    p->first = nvalloc(attributeTableLen * sizeof(int));
+    p->count = nvalloc(attributeTableLen * sizeof(int));
+
+    for (bit = 0; bit < 24; bit++) {
+        if (!query_all_skip_mask(t, targetTypeInfo, 1 << bit)) {
+            bits |= 1 << bit;
+            if (firstBit < 0) {
+                firstBit = bit;
+            }
+        }
+    }
+
+    if (firstBit < 0) {
+        return;
+    }
+
+    numBits = count_number_of_bits(bits);
+
+    /* Valid values for the first display device bit of each attribute */
+
+    valid = nvalloc(attributeTableLen * numBits *
+                    sizeof(CtrlAttributeValidValuesQuery));
+    slots = nvalloc(attributeTableLen * numBits * sizeof(int));
+    count = 0;
+
+    for (entry = 0; entry < attributeTableLen; entry++) {
+        const AttributeTableEntry *a = &attributeTable[entry];
+
+        if (query_all_skip_entry(a) ||
+            a->type != CTRL_ATTRIBUTE_TYPE_INTEGER) {
+            continue;
+        }
+
+        valid[count].ctrl_target = t;
+        valid[count].display_mask = 1 << firstBit;
+        valid[count].attr = a->attr;
+        slots[count] = entry;
+        count++;
+    }
+
+    NvCtrlGetValidAttributeValuesBatch(valid, count);
+
+    /*
+     * Lay out the slots of each attribute: one per display device bit
+     * for the attributes that query_all() queries per display device,
+     * one otherwise.
+     */
+
+    total = 0;
+    for (i = 0; i < count; i++) {
+        entry = slots[i];
+
+        p->first[entry] = total;
+        p->count[entry] = 1;
+
+        if ((valid[i].status == NvCtrlSuccess) &&
+            (valid[i].val.permissions.valid_targets &
+             CTRL_TARGET_PERM_BIT(DISPLAY_TARGET)) &&
+            (target_type != DISPLAY_TARGET)) {
+            p->count[entry] = numBits;
+        }
+        total += p->count[entry];
+    }
+
+    p->values = nvalloc(total * sizeof(PrefetchedValue));
+
+    for (i = 0; i < count; i++) {
+        p->values[p->first[slots[i]]].valid = valid[i];
+    }
+
+    /* Valid values for the other display device bits */
+
+    n = 0;
+    for (i = 0; i < count; i++) {
+        int k;
+
+        entry = slots[i];
+        k = p->first[entry] + 1;
+
+        for (bit = firstBit + 1; k < p->first[entry] + p->count[entry];
+             bit++) {
+            if (!(bits & (1 << bit))) continue;
+
+            valid[n].ctrl_target = t;
+            valid[n].display_mask = 1 << bit;
+            valid[n].attr = attributeTable[entry].attr;
+            slots[n] = k;
+            n++;
+            k++;
+        }
+    }
+
+    NvCtrlGetValidAttributeValuesBatch(valid, n);
+
+    for (i = 0; i < n; i++) {
+        p->values[slots[i]].valid = valid[i];
+    }
+
+    nvfree(slots);
+    nvfree(valid);
+
+    /*
+     * query_all() stops at the first display device bit whose valid
+     * values query fails, or which is not queried per display device;
+     * drop the slots past it, and query the values of the rest.
+     */
+
+    values = nvalloc(total * sizeof(CtrlAttributeQuery));
+    slots = nvalloc(total * sizeof(int));
+    n = 0;
+
+    for (entry = 0; entry < attributeTableLen; entry++) {
+        for (i = 0; i < p->count[entry]; i++) {
+            int k = p->first[entry] + i;
+            const CtrlAttributeValidValuesQuery *v = &p->values[k].valid;
+
+            if (v->status != NvCtrlSuccess) {
+                p->count[entry] = i + 1;
+                break;
+            }
+
+            values[n].ctrl_target = t;
+            values[n].display_mask = v->display_mask;
+            values[n].attr = v->attr;
+            slots[n] = k;
+            n++;
+
+            if (!(v->val.permissions.valid_targets &
+                  CTRL_TARGET_PERM_BIT(DISPLAY_TARGET))) {
+                p->count[entry] = i + 1;
+                break;
+            }
+        }
+    }
+
+    NvCtrlGetAttributesBatch(values, n);
+
+    for (i = 0; i < n; i++) {
+        p->values[slots[i]].value = values[i];
+    }
+
+    nvfree(slots);
+    nvfree(values);
+
+} /* prefetch_attribute_values() */
+
+
+
 /*
  * query_all() - loop through all target types, and query all attributes
  * for those targets.  The current attribute values for all display
@@ -1399,9 +2510,13 @@ static int query_all(const Options *op, const char *display_name,
 
         for (node = system->targets[target_type]; node; node = node->next) {
             CtrlTarget *t = node->t;
+            PrefetchedValues prefetched;
 
             if (!t->h) continue;
 
+            prefetch_attribute_values(t, targetTypeInfo, target_type,
+                                      &prefetched);
+
             nv_msg(NULL, "Attributes queryable via %s:", t->name);
 
             if (!op->terse) {
@@ -1410,30 +2525,17 @@ static int query_all(const Options *op, const char *display_name,
 
             for (entry = 0; entry < attributeTableLen; entry++) {
                 const AttributeTableEntry *a = &attributeTable[entry];
+                int slot = prefetched.first[entry];
+                int end = slot + prefetched.count[entry];
 
-                /* skip the color attributes */
-
-                if (a->type == CTRL_ATTRIBUTE_TYPE_COLOR) {
-                    continue;
-                }
-
-                /* skip attributes that shouldn't be queried here */
-
-                if (a->flags.no_query_all) {
+                if (query_all_skip_entry(a)) {
                     continue;
                 }
 
                 for (bit = 0; bit < 24; bit++) {
                     mask = 1 << bit;
 
-                    /*
-                     * if this bit is not present in the screens's enabled
-                     * display device mask (and the X screen has enabled
-                     * display devices), skip to the next bit
-                     */
-
-                    if (targetTypeInfo->uses_display_devices &&
-                        ((t->d & mask) == 0x0) && (t->d)) continue;
+                    if (query_all_skip_mask(t, targetTypeInfo, mask)) continue;
 
                     if (a->type == CTRL_ATTRIBUTE_TYPE_STRING) {
                         char *tmp_str = NULL;
@@ -1482,11 +2584,23 @@ static int query_all(const Options *op, const char *display_name,
                         tmp_str = NULL;
 
                     } else {
+                        const PrefetchedValue *pv = NULL;
 
-                        status = NvCtrlGetValidDisplayAttributeValues(t,
-                                                                      mask,
-                                                                      a->attr,
-                                                                      &valid);
+                        if ((slot < end) &&
+                            (prefetched.values[slot].valid.display_mask ==
+                             mask)) {
+                            pv = &prefetched.values[slot++];
+                        }
+
+                        if (pv) {
+                            status = pv->valid.status;
+                            valid = pv->valid.val;
+                        } else {
+                            status =
+                                NvCtrlGetValidDisplayAttributeValues(t, mask,
+                                                                     a->attr,
+                                                                     &valid);
+                        }
 
                         if (status == NvCtrlAttributeNotAvailable) {
                             goto exit_bit_loop;
@@ -1500,8 +2614,13 @@ static int query_all(const Options *op, const char *display_name,
                             goto exit_bit_loop;
                         }
 
-                        status = NvCtrlGetDisplayAttribute(t, mask, a->attr,
-                                                           &val);
+                        if (pv && pv->value.ctrl_target) {
+                            status = pv->value.status;
+                            val = pv->value.val;
+                        } else {
+                            status = NvCtrlGetDisplayAttribute(t, mask,
+                                                               a->attr, &val);
+                        }
 
                         if (status == NvCtrlAttributeNotAvailable) {
                             goto exit_bit_loop;
@@ -1542,6 +2661,10 @@ exit_bit_loop:
 
             } /* entry */
 
+            nvfree(prefetched.values);
+            nvfree(prefetched.first);
+            nvfree(prefetched.count);
+
         } /* j (targets) */
 
     } /* target_type */
@@ -1997,6 +3120,12 @@ static int process_parsed_attribute_internal(const Options *op,
             ret = validate_value(op, t, p, d, target_type, whence);
             if (!ret) return NV_FALSE;
 
+            if (__batch_active && can_batch_assignment(a)) {
+                add_batched_assignment(t, d, a, p->val.i, whence, str,
+                                       verbose);
+                return NV_TRUE;
+            }
+
             status = NvCtrlSetDisplayAttribute(t, d, a->attr, p->val.i);
 
             if (status != NvCtrlSuccess) {
@@ -2143,9 +3272,16 @@ int nv_process_parsed_attribute(const Options *op,
 
     if (!whence) whence = strdup("\0");
 
+    /* attributes which are not batched are processed after those which are */
+
+    if (!assign || !can_batch_assignment(a)) {
+        flush_assignment_batch();
+    }
+
     /* if we don't have a Display connection, abort now */
 
     if (system == NULL) {
+        flush_assignment_batch();
         nv_error_msg("Unable to %s attribute %s specified %s (no Display "
                      "connection).", assign ? "assign" : "query",
                      a->name, whence);
@@ -2159,6 +3295,7 @@ int nv_process_parsed_attribute(const Options *op,
                (*str == ':' || *str == '.')) {
             str++;
         }
+        flush_assignment_batch();
         nv_deprecated_msg("The attribute '%s' is deprecated%s%s",
                           a->name,
                           *str ? "," : ".",
@@ -2172,6 +3309,7 @@ int nv_process_parsed_attribute(const Options *op,
                (*str == ':' || *str == '.')) {
             str++;
         }
+        flush_assignment_batch();
         nv_deprecated_msg("The attribute '%s' is no longer supported%s%s",
                           a->name,
                           *str ? "," : ".",
@@ -2179,20 +3317,26 @@ int nv_process_parsed_attribute(const Options *op,
         goto done;
     }
     /* Resolve any target specifications against the CtrlSystem that was
-     * allocated.
+     * allocated, unless the caller already did so with
+     * nv_resolve_parsed_attribute_targets().
      */
 
-    ret = resolve_attribute_targets(p, system, whence);
-    if (ret != NV_PARSER_STATUS_SUCCESS) {
-        nv_error_msg("Error resolving target specification '%s' "
-                     "(%s), specified %s.",
-                     p->target_specification ? p->target_specification : "",
-                     nv_parse_strerror(ret),
-                     whence);
-        goto done;
+    if (!p->targets) {
+        ret = resolve_attribute_targets(p, system, whence);
+        if (ret != NV_PARSER_STATUS_SUCCESS) {
+            flush_assignment_batch();
+            nv_error_msg("Error resolving target specification '%s' "
+                         "(%s), specified %s.",
+                         p->target_specification ?
+                         p->target_specification : "",
+                         nv_parse_strerror(ret),
+                         whence);
+            goto done;
+        }
     }
 
     if (!p->targets) {
+        flush_assignment_batch();
         nv_warning_msg("Failed to match any targets for target specification "
                        "'%s', specified %s.",
                        p->target_specification ? p->target_specification : "",
@@ -2308,6 +3452,7 @@ int nv_process_parsed_attribute(const Options *op,
                 tmp_d_str1 =
                     display_device_mask_to_display_device_name(check_mask);
 
+                flush_assignment_batch();
                 nv_error_msg("The attribute '%s' specified %s cannot be "
                              "assigned the value of %s (the currently %s "
                              "display devices are %s on %s).",
@@ -2379,6 +3524,7 @@ int nv_process_parsed_attribute(const Options *op,
             }
 
             if (multi_match) {
+                flush_assignment_batch();
                 nv_error_msg("The attribute '%s' specified %s cannot be "
                              "assigned the value of '%s' (This name matches "
                              "multiple display devices, please use a non-"
@@ -2388,6 +3534,7 @@ int nv_process_parsed_attribute(const Options *op,
             }
 
             if (!found) {
+                flush_assignment_batch();
                 nv_error_msg("The attribute '%s' specified %s cannot be "
                              "assigned the value of '%s' (This does not "
                              "name an available display device).",
@@ -2421,6 +3568,7 @@ int nv_process_parsed_attribute(const Options *op,
                     tmp_d_str0 = "value";
                 }
 
+                flush_assignment_batch();
                 nv_error_msg("The attribute '%s' specified %s cannot be "
                              "assigned the value of 0 (a valid, non-zero, "
                              "%s must be specified).",
@@ -2556,6 +3704,7 @@ int nv_process_parsed_attribute(const Options *op,
         }
 
         if (status != NvCtrlSuccess) {
+            flush_assignment_batch();
             if (status == NvCtrlAttributeNotAvailable) {
                 nv_warning_msg("Attribute '%s' specified %s is not "
                                "available on %s.",
@@ -2575,6 +3724,7 @@ int nv_process_parsed_attribute(const Options *op,
          */
 
         if (assign && !valid.permissions.write) {
+            flush_assignment_batch();
             nv_error_msg("The attribute '%s' specified %s cannot be "
                          "assigned (it is a read-only attribute).",
                          a->name, whence);
@@ -38,6 +38,13 @@ int nv_process_parsed_attribute(const Options *op,
                                 ParsedAttribute*, CtrlSystem *system,
                                 int, int, char*, ...) NV_ATTRIBUTE_PRINTF(6, 7);
 
+int nv_resolve_parsed_attribute_targets(ParsedAttribute *p,
+                                        CtrlSystem *system,
+                                        const char *whence);
+
+void nv_start_assignment_batch(void);
+void nv_end_assignment_batch(void);
+
 
 
 #endif /* __QUERY_ASSIGN_H__ */
@@ -155,6 +155,7 @@ GTK_SRC += gtk+-2.x/ctkdisplaydevice.c
 GTK_SRC += gtk+-2.x/ctkditheringcontrols.c
 GTK_SRC += gtk+-2.x/ctkthermal.c
 GTK_SRC += gtk+-2.x/ctkpowermizer.c
+GTK_SRC += gtk+-2.x/ctksampler.c
 GTK_SRC += gtk+-2.x/ctkdropdownmenu.c
 GTK_SRC += gtk+-2.x/ctkutils.c
 GTK_SRC += gtk+-2.x/ctkedid.c
@@ -203,6 +204,7 @@ GTK_EXTRA_DIST += gtk+-2.x/ctkditheringcontrols.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkconstants.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkthermal.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkpowermizer.h
+GTK_EXTRA_DIST += gtk+-2.x/ctksampler.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkdropdownmenu.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkutils.h
 GTK_EXTRA_DIST += gtk+-2.x/ctkedid.h